@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// Layered (subsumption-style) arbitration. Each layer runs at its own period
+// and leaves a standing motion proposal; every cycle the arbiter picks the
+// active proposal from the highest-priority layer. A slow layer's proposal
+// stays valid between its runs, so cheap reflexes can run every stream frame
+// while expensive low-priority layers run rarely.
+
+struct MotionProposal {
+  bool active;   // false = this layer has no opinion
+  int16_t right; // wheel speeds, mm/s before the motion speed scale
+  int16_t left;
+  uint8_t tag;   // caller-defined (behavior uses it for the FSM state id)
+};
+
+typedef void (*LayerFn)(MotionProposal &out, unsigned long nowMs);
+
+struct BehaviorLayer {
+  const char* name;
+  uint16_t periodMs; // 0 = every cycle
+  LayerFn run;
+  // Arbiter-owned bookkeeping
+  unsigned long lastRunMs;
+  MotionProposal proposal;
+  uint16_t runs;
+};
+
+// Layers are given highest priority first.
+void arbiterInit(BehaviorLayer* layers, uint8_t count, unsigned long nowMs);
+// Run the layers that are due and return the index of the winning layer
+// (its proposal in `winner`), or ARBITER_NONE when no layer is active.
+static const uint8_t ARBITER_NONE = 0xFF;
+uint8_t arbiterStep(unsigned long nowMs, MotionProposal &winner);
+// Clear every standing proposal (e.g. on disconnect) and run all layers next step.
+void arbiterReset();
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+
+// Second USB CDC ACM port for host control (-DDUAL_CDC=1).
+//
+// With it the 32U4 enumerates as a composite device: Serial (ttyACM0) stays
+// a byte-transparent OI bridge, while SerialCtl (ttyACM1) carries control
+// lines, STATUS/FDR/PROF dumps, debug prints and proto.h telemetry. Nothing
+// on the bridge port is scanned for escapes or handshakes, and control
+// traffic never queues behind bridge bytes. Without DUAL_CDC both share
+// Serial as before (FF 00 escape, OI_PLAY handshake; see protocol.md).
+//
+// Code that talks to the host (not the robot) writes to CONTROL_SERIAL.
+
+#ifndef DUAL_CDC
+#define DUAL_CDC 0
+#endif
+
+#if DUAL_CDC
+
+#if defined(ARDUINO) && defined(USBCON)
+#include <PluggableUSB.h>
+
+// CDC ACM function plugged next to the core's Serial: IAD + control
+// interface (interrupt IN) + data interface (bulk OUT/IN). Takes the three
+// endpoints the core leaves free on the 32U4.
+class CdcCtl : public PluggableUSBModule, public Stream {
+public:
+  CdcCtl();
+  void begin(unsigned long) {}
+  int available() override;
+  int peek() override;
+  int read() override;
+  int availableForWrite() override;
+  void flush() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t len) override;
+  using Print::write;
+  // Host opened the port (DTR set by SET_CONTROL_LINE_STATE)
+  bool dtr() const { return (lineState & 0x01) != 0; }
+  operator bool() { return dtr(); }
+
+protected:
+  int getInterface(uint8_t* interfaceCount) override;
+  int getDescriptor(USBSetup& setup) override;
+  bool setup(USBSetup& setup) override;
+  uint8_t getShortName(char* name) override;
+
+private:
+  uint8_t epType[3];
+  uint8_t lineCoding[7];     // dwDTERate, bCharFormat, bParityType, bDataBits
+  volatile uint8_t lineState = 0;
+  int peeked = -1;
+};
+
+extern CdcCtl SerialCtl;
+
+#elif !defined(ARDUINO)
+// Native builds: a second mock port (test/Arduino.h)
+extern USBSerial SerialCtl;
+#else
+#error "DUAL_CDC needs a native-USB board (USBCON)"
+#endif
+
+#define CONTROL_SERIAL SerialCtl
+
+#else
+
+#define CONTROL_SERIAL Serial
+
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+// Host control channel. While bridging, commands arrive escaped as
+// FF 00 !<cmd>\n (see protocol.md) and are answered with one ASCII line
+// (or a short block of lines for dumps). In managed mode the host sends
+// proto.h lines directly; their replies go through the TX ring.
+// With DUAL_CDC all of it lives on the control port (cdc_ctl.h), unescaped,
+// whatever the mode.
+
+// Dispatch one complete control line (no trailing newline).
+void controlHandleLine(const char* line);
+// Read host lines from the control port and dispatch them. Call each loop.
+void controlPoll();
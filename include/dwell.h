@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// Dwell-time accounting for a FIFO byte path through the firmware (the
+// bridge, one per direction). Ingress marks bytes as they are first seen
+// waiting at the input, stamped with the previous look at that input: they
+// arrived after it, so dwell is an upper bound that includes the time they
+// sat unnoticed between loop passes. Egress turns the marks back into
+// per-byte dwell times kept in a log2 histogram.
+//
+// Bucket i counts bytes that dwelt under 2^(i+4) us (16 us .. 16.4 ms); the
+// last bucket collects everything slower. Counts saturate at 65535.
+
+static const uint8_t DWELL_BUCKETS = 12;
+static const uint8_t DWELL_MARKS = 8;
+
+struct DwellQueue {
+  uint32_t markTicks[DWELL_MARKS]; // ingress time of each batch (tbTicks)
+  uint16_t markBytes[DWELL_MARKS]; // bytes of the batch still in flight
+  uint8_t head, marks;
+  uint16_t unread;                 // marked bytes not yet taken from the input
+  uint32_t lastLook;               // previous dwellSeen() (0 = none yet)
+  uint16_t hist[DWELL_BUCKETS];
+  uint32_t maxUs;
+};
+
+// Forget bytes in flight and restart ingress timing (keeps the histogram).
+void dwellRestart(DwellQueue &q);
+// Clear the histogram and max.
+void dwellClear(DwellQueue &q);
+// The input now holds avail bytes (marked and new).
+void dwellSeen(DwellQueue &q, uint16_t avail, uint32_t nowTicks);
+// n bytes were taken from the input.
+void dwellRead(DwellQueue &q, uint16_t n);
+// n bytes left at the output: oldest first, each adds one histogram count.
+void dwellOut(DwellQueue &q, uint16_t n, uint32_t nowTicks);
+// n bytes will never reach the output (consumed, dropped, coalesced).
+void dwellDrop(DwellQueue &q, uint16_t n);
+// Bucket index for a dwell time
+uint8_t dwellBucket(uint32_t us);
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// Energy accounting from the OI stream: every current sample (packet 23,
+// with voltage from packet 22) integrates |I| x V in fixed point (mW x ms =
+// uJ) into the account that was active, together with the time spent and
+// the distance travelled (packet 19). Discharge only; charging is ignored.
+//
+// Attribution, first match wins: wheels stopped (idle, the baseline every
+// other account pays too, or cue while a song plays); motion owned by the
+// host; otherwise the behavior activity set by energySetActivity(). A cue
+// played while driving leaves time and distance with the motion account and
+// takes only the draw above that account's average so far.
+
+enum EnergyAccount {
+  ENERGY_IDLE = 0, // wheels stopped, no cue
+  ENERGY_HOST,     // forebrain motion
+  ENERGY_SEEK,     // seeking/casting, or fidgets in sedate mode
+  ENERGY_ADVANCE,
+  ENERGY_WALL,
+  ENERGY_RECOIL,   // recoils and stuck/trap escapes
+  ENERGY_TURN,
+  ENERGY_CUE,      // songs and tones
+  ENERGY_ACCOUNTS
+};
+
+struct EnergyTotals {
+  uint32_t mJ;
+  uint32_t ms;
+  uint32_t mm;
+};
+
+// Samples further apart than this are treated as a stream gap: not integrated
+static const uint16_t ENERGY_MAX_GAP_MS = 100;
+
+void energyReset();
+// What the behavior is doing while it drives (EnergyAccount)
+void energySetActivity(uint8_t account);
+// An audio cue lasting ms starts now
+void energyCue(uint16_t ms);
+// Stream samples (called by the sensor parser)
+void energySample(uint16_t mV, int16_t mA, unsigned long nowMs);
+void energyDistance(int16_t mm);
+
+const char* energyAccountName(uint8_t account);
+void energyTotals(uint8_t account, EnergyTotals &out);
+// mJ per metre over every moving account (0 before any distance)
+uint32_t energyMilliJoulesPerMetre();
+// Average idle draw, the baseline (mW; 0 before any idle sample)
+uint32_t energyIdleMilliWatts();
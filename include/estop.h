@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+// ESTOP latch. Setting it sends a stop frame straight to the OI UART,
+// bypassing every motion layer, and waits for it to leave the wire; drive
+// commands from any source are refused until the latch is cleared with
+// SAFE,1. Worst-case stop latency is bounded by draining the UART TX buffer
+// plus the 5-byte stop frame: (64 + 5) byte times ≈ 12 ms at 57600 baud.
+
+// Who set the latch (bitmask; several may accumulate)
+enum {
+  ESTOP_SRC_HOST   = 0x01, // SAFE,0 or !estop
+  ESTOP_SRC_BUTTON = 0x02, // Create Play button
+  ESTOP_SRC_REFLEX = 0x04, // cliff reflex
+};
+
+// Latch and stop now. cmdTicks is when the request arrived (tbTicks(); 0 =
+// now); the command-to-wheels-stopped latency is measured from it.
+void estopSet(uint8_t source, uint32_t cmdTicks = 0);
+// Clear the latch; returns false if it was not set.
+bool estopClear();
+bool estopActive();
+uint8_t estopSources();
+// Poll each loop: Play button sets the latch; the stop is re-asserted while latched.
+void estopTick();
+
+uint32_t estopLastLatencyUs();
+uint32_t estopMaxLatencyUs();
+uint16_t estopCount();
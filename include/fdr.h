@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+// Flight recorder: a fixed ring of compact 8-byte records holding recent
+// sensor snapshots, drive commands, FSM states and reflex actions. Recording
+// is a handful of stores; on a configured trigger the ring freezes so the
+// lead-up to an incident survives until the host dumps it.
+
+// Ring capacity in records (8 bytes each). Override with -DFDR_RECORDS=<n>.
+#ifndef FDR_RECORDS
+#define FDR_RECORDS 32
+#endif
+
+// Record kinds
+enum FdrKind {
+  FDR_SENSORS = 1, // a = packed hazard bits (see sensorsPackedState), b = buttons
+  FDR_DRIVE   = 2, // b = right mm/s, c = left mm/s (as sent to the OI); a = new MotionOwner on a handoff stop
+  FDR_STATE   = 3, // a = new FSM state id, b = previous state id
+  FDR_REFLEX  = 4, // a = reflex action id (FDR_REFLEX_*)
+  FDR_TRIGGER = 5, // a = trigger bit that froze the ring
+};
+
+// Reflex action ids for FDR_REFLEX records
+enum {
+  FDR_REFLEX_CLIFF_FREEZE = 1,
+  FDR_REFLEX_BUMP_RECOIL  = 2,
+  FDR_REFLEX_ISR_RECOIL   = 3,
+  FDR_REFLEX_BIAS_FLIP    = 4,
+  FDR_REFLEX_STUCK        = 5, // b = StallReason (stall.h)
+  FDR_REFLEX_TRAP_ESCAPE  = 6, // b = TrapEscape level (trap.h)
+};
+
+// Trigger bits for fdrSetTriggerMask()/fdrTrigger()
+enum {
+  FDR_TRIG_CLIFF    = 0x01,
+  FDR_TRIG_ESTOP    = 0x02,
+  FDR_TRIG_WATCHDOG = 0x04,
+  FDR_TRIG_BUMPS    = 0x08, // five bumps in quick succession
+  FDR_TRIG_HOST     = 0x10, // explicit freeze requested by the host
+};
+
+void fdrInit();
+// Append a record unless the ring is frozen.
+void fdrRecord(uint8_t kind, uint8_t a, int16_t b = 0, int16_t c = 0);
+// Freeze the ring if the trigger bit is enabled in the trigger mask.
+void fdrTrigger(uint8_t trigger);
+// Re-arm after a dump: unfreeze and start recording again (history is kept).
+void fdrArm();
+bool fdrFrozen();
+uint8_t fdrTriggerMask();
+void fdrSetTriggerMask(uint8_t mask);
+// Write the ring to Serial, oldest first, as FDR,... lines (see tools/fdr_decode.py).
+void fdrDump();
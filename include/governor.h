@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// Battery governor for autonomous activity. Once per GOV_TICK_MS it turns
+// battery state into an activity level (percent):
+//  - a policy curve over battery percent: 100 at or above gov_full_pct,
+//    falling linearly to gov_min_level at gov_floor_pct and below;
+//  - a task budget (task_budget_min, 0 = none): while the predicted runtime
+//    falls short of what is left of the budget, a slow trim lowers the level
+//    further (never below gov_min_level), and it recovers once there is slack.
+// The level sets the drive speed factor (GOV_SPEED_MIN_PCT..100%: crawling
+// costs more per metre since the idle draw keeps running), the chance that a
+// fidget move or an audio cue goes ahead, and stretches the telemetry
+// keyframe period up to 4x.
+//
+// Runtime is predicted from the charge left above the IDLE_SLEEP_PCT cutoff
+// over a smoothed discharge current, and reported as
+// BAT,<mV>,<percent>,<charging>,<runtime_min>,<level> every GOV_REPORT_MS.
+
+#ifndef GOV_TICK_MS
+#define GOV_TICK_MS 1000
+#endif
+#ifndef GOV_REPORT_MS
+#define GOV_REPORT_MS 10000
+#endif
+#ifndef GOV_SPEED_MIN_PCT
+#define GOV_SPEED_MIN_PCT 60
+#endif
+
+// Runtime while charging or before the stream has reported a discharge
+static const uint16_t GOV_RUNTIME_UNKNOWN = 0xFFFF;
+
+// Full level, no draw estimate and no task budget; the mode manager calls it
+// at start and on every switch to PASSTHROUGH.
+void governorReset();
+// Call each managed loop.
+void governorTick(uint32_t nowMs);
+uint8_t governorLevel();
+// Minutes until the sleep cutoff at the current draw
+uint16_t governorRuntimeMin();
+// True with probability governorLevel()% (fidget moves, cues)
+bool governorAllow();
+
+// Policy (SET,gov_full_pct / gov_floor_pct / gov_min_level / task_budget_min).
+// Setters return false for values out of range or a floor not below full.
+bool governorSetFullPct(uint16_t pct);
+bool governorSetFloorPct(uint16_t pct);
+bool governorSetMinLevel(uint16_t pct);
+// Runtime the current task needs, counted from nowMs (0 = no budget)
+bool governorSetBudgetMin(uint16_t minutes, uint32_t nowMs);
@@ -1,9 +1,12 @@
 #pragma once
 #include <stdbool.h>
 
+// Battery percent below which the robot stops and sleeps
+#define IDLE_SLEEP_PCT 20
+
 // Initialize idle manager with optional timeout (ms). Defaults to 5 minutes.
 void initIdle(unsigned long timeoutMs = 300000);
-// Update idle behavior based on USB connection status. Call each loop.
+// Update idle behavior based on USB connection status (usbLinkPresent()). Call each loop.
 void updateIdle(bool usbConnected);
 // Query whether idle fidget behavior is active.
 bool idleIsActive();
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+
+// Run-mode manager: owns every switch between raw passthrough, host-driven
+// (forebrain) and on-board autonomous operation. A switch never reconfigures
+// the OI stream -- it is paused/resumed in place and the cached sensor
+// snapshot carries over -- and motion ownership changes in one step with a
+// stop in between. Switches complete inside the call that requests them.
+
+enum RunMode {
+  MODE_PASSTHROUGH = 0,
+  MODE_FOREBRAIN,
+  MODE_AUTONOMOUS,
+};
+
+// Managed-stack setup; also starts the timebase, USB presence and idle tracking.
+void initMode(RunMode start = MODE_PASSTHROUGH);
+// Switch now. cmdTicks is when the request arrived (tbTicks(); 0 = now) and
+// is used for the recorded transition latency. Emits STATE,<name>.
+void modeSet(RunMode mode, uint32_t cmdTicks = 0);
+RunMode modeCurrent();
+const char* modeName(RunMode mode);
+// Parse FOREBRAIN / AUTONOMOUS / PASSTHROUGH; returns false if unknown.
+bool modeFromName(const char* name, RunMode &out);
+
+// PAUSE holds the current managed mode with nobody driving; RESUME restores it.
+void modePause();
+void modeResume();
+bool modePaused();
+
+uint32_t modeLastSwitchUs();
+uint32_t modeMaxSwitchUs();
+uint16_t modeSwitches();
+
+// modeLoop() iteration time since the previous call (average and worst, µs);
+// each call starts a new window. Both are 0 if no iteration ran.
+void modeLoopStats(uint32_t &avgUs, uint32_t &maxUs);
+
+// One iteration of the managed main loop (USB presence, host input, sensor
+// stream, reflexes, autonomy, outbound lines).
+void modeLoop();
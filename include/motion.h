@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 void initMotors();
 void forwardOneTick();
@@ -15,7 +16,31 @@ void veerRightOneTick();
 void gentleVeerLeft();
 void gentleVeerRight();
 void stopAllMotors();
+// Non-blocking: set wheel speeds (mm/s before the speed scale) and return.
+// The caller refreshes or changes them; used by the behavior arbiter.
+void motionDrive(int16_t right, int16_t left);
+// Forebrain wheel speeds (mm/s, not scaled). Moving commands are refused
+// (false) unless the host owns motion and ESTOP is clear; stops always go.
+bool motionHostDrive(int16_t right, int16_t left);
+// Body velocity (vx m/s, wz rad/s) to Create wheel speeds, clamped to ±500 mm/s
+void motionTwistToWheels(float vx, float wz, int16_t &right, int16_t &left);
 void alertFreeze();
 
 // Scale all behavior/presence motion speeds (0.0..1.0). Forebrain TWIST unaffected.
 void setMotionSpeedScale(float scale);
+// Battery governor factor applied on top of the speed scale (0.05..1.0)
+void setMotionGovernor(float factor);
+
+// Who may drive the wheels. Handing ownership over stops the wheels first so
+// the new owner never inherits the previous owner's last command. Only the
+// behavior owner moves through the helpers above; stops always go through.
+enum MotionOwner {
+  MOTION_OWNER_NONE = 0, // paused: nobody drives
+  MOTION_OWNER_BRIDGE,   // host drives raw OI through passthrough
+  MOTION_OWNER_HOST,     // forebrain (managed host) commands
+  MOTION_OWNER_BEHAVIOR, // on-board autonomy
+};
+void setMotionOwner(MotionOwner owner);
+MotionOwner motionOwner();
+// Wheel speeds of the last drive frame sent to the OI (mm/s, after scaling)
+void motionLastSent(int16_t &right, int16_t &left);
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// Integer and fixed-point decimal formatting for outbound telemetry.
+// Digits are produced two at a time from a 100-entry pair table; the only
+// divisions are a fixed number of /10000 splits (never a per-digit loop), so
+// the cost per field is small and bounded. No NUL terminator is written.
+
+// Longest outputs: u32 = 10 chars, i32 = 11, fixed = 12 (sign, 10 digits, '.')
+static const uint8_t NUMFMT_MAX_LEN = 12;
+// Largest supported number of decimals for fmtFixed()/fmtFloat()
+static const uint8_t NUMFMT_MAX_DECIMALS = 6;
+
+uint8_t fmtU32(char* out, uint32_t v);
+uint8_t fmtI32(char* out, int32_t v);
+// Fixed-point: scaled holds value * 10^decimals (e.g. mm with decimals=3 gives meters).
+uint8_t fmtFixed(char* out, int32_t scaled, uint8_t decimals);
+// Convenience for float sources: rounds v * 10^decimals, then fmtFixed().
+// Out-of-range values and infinities saturate to the int32 limits; NaN gives 0.
+uint8_t fmtFloat(char* out, float v, uint8_t decimals);
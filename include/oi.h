@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+// Command framing for the host → robot OI byte stream (Create 1 Open
+// Interface). Lets the bridge tell opcode bytes from data bytes without
+// buffering, e.g. to hold back drive frames while ESTOP is latched.
+
+struct OiFramer {
+  uint8_t opcode;    // opcode of the command in progress (0 = between commands)
+  uint8_t remaining; // data bytes still expected for it
+  uint8_t lenState;  // variable-length header progress (see oi.cpp)
+};
+
+void oiFramerReset(OiFramer &f);
+// Feed one byte; returns true when the byte is an opcode (starts a command).
+bool oiFramerFeed(OiFramer &f, uint8_t b);
+// True for 137 (Drive) and 145 (Drive Direct)
+bool oiIsDriveOpcode(uint8_t opcode);
+// True for every opcode that can set the wheels moving: the drive frames,
+// the built-in demos (134 spot, 135 cover, 136 demo, 143 cover and dock) and
+// scripts (152 define, 153 play). Held back while ESTOP is latched.
+bool oiIsMotionOpcode(uint8_t opcode);
+
+// Latest-wins shaping for bridged host commands. Whole commands wait here
+// while the OI UART is full; a new drive frame replaces the newest queued
+// one that has not started sending, as long as only sensor requests (142,
+// 149) were queued after it. Everything else goes out untouched and in
+// order. Commands longer than the buffer stream through it.
+#ifndef OI_SHAPER_BYTES
+#define OI_SHAPER_BYTES 64
+#endif
+#ifndef OI_SHAPER_FRAMES
+#define OI_SHAPER_FRAMES 16
+#endif
+
+struct OiShaper {
+  OiFramer framer;
+  uint8_t buf[OI_SHAPER_BYTES];    // queued bytes, oldest first
+  uint8_t len;
+  uint8_t frameOp[OI_SHAPER_FRAMES];  // opcode (or stray byte) per command
+  uint8_t frameLen[OI_SHAPER_FRAMES]; // its bytes still in buf
+  uint8_t frames;
+  bool headStarted;  // part of the first command has been sent
+  bool open;         // the last command still expects data bytes
+  uint16_t coalesced;
+};
+
+void oiShaperReset(OiShaper &s);
+// Bytes that can surely be pushed now (0 when full)
+uint8_t oiShaperRoom(const OiShaper &s);
+// Queue one byte; false when there is no room.
+bool oiShaperPush(OiShaper &s, uint8_t b);
+// Mark the first n queued bytes as sent (they are at s.buf).
+void oiShaperConsume(OiShaper &s, uint8_t n);
+// Drop queued motion commands (oiIsMotionOpcode) that have not started
+// sending (ESTOP).
+void oiShaperDropDrives(OiShaper &s);
+// Drop every queued command that has not started sending; the rest of a
+// command already on the wire stays so the robot's parser is not left
+// mid-command.
+void oiShaperDropPending(OiShaper &s);
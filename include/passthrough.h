@@ -1,6 +1,36 @@
 #pragma once
+#include <stdint.h>
+#include "dwell.h"
 
 void passthroughEnable();
 void passthroughDisable();
 bool passthroughActive();
 void passthroughPump();
+// Passthrough watchdog: called on USB presence edges. When the host vanishes
+// mid-bridge the robot is stopped instead of running its last command.
+void passthroughLinkChanged(bool hostPresent);
+// Make the OI UART safe for a frame of the firmware's own (ESTOP): a bridged
+// command the robot is in the middle of is completed with zero data bytes,
+// the rest of it from the host is dropped, and staged commands are given up.
+// No-op outside passthrough or between commands.
+void passthroughFinishCommand();
+// True while the robot has been sent part of a bridged command
+bool passthroughMidCommand();
+// Bytes bridged since boot in each direction (drive frames held back by
+// ESTOP are not counted)
+uint32_t passthroughBytesToRobot();
+uint32_t passthroughBytesToHost();
+// Pumps that left host bytes unread because the robot UART was full
+uint32_t passthroughStalls();
+// Latest-wins drive shaping (oi.h OiShaper): while the UART is backed up a
+// newer drive frame replaces a queued one instead of queueing behind it.
+// Off by default (-DBRIDGE_COALESCE=1 or !coalesce,1).
+void passthroughSetCoalesce(bool on);
+bool passthroughCoalesce();
+// Drive frames replaced since boot
+uint16_t passthroughCoalesced();
+// Dwell-time histograms of bridged bytes (dwell.h), from first seen waiting
+// at the input to handed to the other side; cleared by !dwell_reset
+const DwellQueue &passthroughDwellToRobot();
+const DwellQueue &passthroughDwellToHost();
+void passthroughDwellClear();
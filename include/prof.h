@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Sampling PC profiler. A timer compare interrupt grabs the return address of
+// whatever it interrupted -- including library code such as HardwareSerial,
+// the USB CDC stack and soft-float -- and counts it in a small hashed table
+// of flash-address buckets. Dump with !prof and map the buckets back to
+// symbols with tools/prof_symbolize.py and the firmware ELF.
+//
+// Only compiled in with -DENABLE_PROF on AVR. Uses Timer1 compare B on the
+// timebase's free-running counter (Timer3 belongs to tone() on the 32U4).
+
+// Table size (power of two up to 128, 4 bytes each). Override with -DPROF_BUCKETS=<n>.
+#ifndef PROF_BUCKETS
+#define PROF_BUCKETS 64
+#endif
+// Bucket granularity: 2^PROF_SHIFT flash words (default 8 words = 16 bytes)
+#ifndef PROF_SHIFT
+#define PROF_SHIFT 3
+#endif
+
+// Clear the table and start sampling at roughly hz (slightly jittered so the
+// samples do not alias with periodic loop work). Returns false when the
+// profiler is not built in.
+bool profStart(uint16_t hz = 997);
+void profStop();
+bool profRunning();
+uint32_t profSamples();
+// Samples that found no free bucket within a few probes
+uint16_t profDropped();
+// Write PROF,... lines to Serial (see protocol.md).
+void profDump();
+
+// Record one sample; pc is a flash word address. Called from the ISR.
+void profSample(uint16_t pc);
@@ -1,6 +1,9 @@
 // Serial Protocol v1.0 for brainstem UART skeleton
 // Inbound (host → MCU):
 //   TWIST,<vx_mps>,<wz_radps>,<seq>\n
+//     (forebrain mode only; held then decayed to a stop by watchdog_ms, see twist.h)
+//   TRAJ,<t_ms>,<right_mm_s>,<left_mm_s> | TRAJV,<t_ms>,<vx_mps>,<wz_radps> | TRAJ,clear\n
+//     (t_ms on the brainstem clock, see GET,time; forebrain mode only)
 //   SAFE,<0|1>\n
 //   PING,<seq>\n
 //   RANGE,<meters>,<id>\n
@@ -8,25 +11,29 @@
 //   LED,<bitmask>\n
 //   (Handshake from passthrough now triggered by OI PLAY,<HANDSHAKE_SONG>)\n
 //   PAUSE | RESUME | PASS (return to passthrough)\n
-//   REPLAY,<since_eid> | STATS\n
+//   REPLAY,<since_eid> | STATS\n  (STATS replies STATS:{...} energy accounts, see protocol.md)
 // Outbound (MCU → host):
 //   HELLO,proto=1.0,build=<date> <time>\n
 //   LINK,<0|1>,<seq>\n
 //   PONG,<seq>\n
 //   ODOM,<x>,<y>,<theta>,<vx>,<wz>,<seq>\n         
-//   TIME,<millis>\n
+//   TIME,<millis>\n                               (reply to GET,time)
+//   TRAJ,underrun,<count>\n
 //   STATE,<name>\n
 //   BUMP,1,<mask>,<seq>\n                          
 //   CLIFF,1,<mask>,<seq>\n                         
 //   STARTLE,<reason>,<mask>,<seq>\n                
 //   ESTOP,<0|1>,<seq>\n
+//   SNS,<mask>[,<bumps>][,<cliffs>][,<wall>][,<buttons>]\n  (changed fields; mask|0x80 = keyframe)
 //   STALE,twist,<ms_since>\n
+//   STUCK,<slip|overcurrent|wheeldrop>,<count>\n  (autonomous mode)
+//   TRAP,escaped,<ms>,<episodes>\n               (autonomous mode)
 //   RGMIN,<meters>,<id>,<seq>\n
 //   ACK,<key>,<value>\n
 //   ERR,parse,<reason> | ERR,cmd,<name> | ERR,param,<key> | ERR,crc | ERR,evt,missing\n
 //   ... All outbound lines append final suffix: ,eid=<n>\n
-// Optional additional telemetry:
-//   BAT,<mV>,<percent>,<charging>
+// Battery governor report (every 10 s in managed modes, runtime 65535 = unknown):
+//   BAT,<mV>,<percent>,<charging>,<runtime_min>,<level>
 
 #pragma once
 
@@ -59,17 +66,26 @@ enum {
 // Mode names for high-level mode switching
 #define PROTO_STATE_FOREBRAIN  "FOREBRAIN"
 #define PROTO_STATE_AUTONOMOUS "AUTONOMOUS"
+#define PROTO_STATE_PASSTHROUGH "PASSTHROUGH"
+#define PROTO_STATE_PAUSED     "PAUSED"
 
 // Parameter keys
 #define PROTO_K_SOFT_STOP   "soft_stop_m"
 #define PROTO_K_HARD_STOP   "hard_stop_m"
 #define PROTO_K_WATCHDOG    "watchdog_ms"
+#define PROTO_K_TWIST_PERIOD "twist_period_ms"
+#define PROTO_K_TWIST_HOLD  "twist_hold_pct"
+#define PROTO_K_GOV_FULL    "gov_full_pct"
+#define PROTO_K_GOV_FLOOR   "gov_floor_pct"
+#define PROTO_K_GOV_MIN     "gov_min_level"
+#define PROTO_K_TASK_BUDGET "task_budget_min"
 #define PROTO_K_ODOM_HZ     "odom_hz"
 #define PROTO_K_SLEW_V      "slew_v"
 #define PROTO_K_SLEW_W      "slew_w"
 #define PROTO_K_TX_BUDGET   "tx_bytes_per_s"
 #define PROTO_K_MAX_LINE    "max_line_len"
 #define PROTO_K_LOG_LEVEL   "log_level"
+#define PROTO_K_MODE        "mode"
 
 #ifdef __cplusplus
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 void initSensors();
 void beginSensorStream();
@@ -6,6 +7,10 @@ void updateSensorStream();
 // Pause/resume helpers for the OI stream when switching modes
 void pauseSensorStream();
 void resumeSensorStream();
+// After the stream was paused and its bytes went elsewhere (passthrough):
+// drop partial pair state and treat the cached snapshot as still current,
+// so a warm resume does not look like a lost OI connection.
+void sensorsResync();
 // Simple queries from cached OI stream
 bool wallDetected();
 bool playButtonPressedAndClear();
@@ -16,10 +21,44 @@ bool oiConnected();
 int scanEnvironment();       // -1 = left, 1 = forward, 2 = right, 0 = none
 bool bumperTriggered();
 bool cliffDetected();
+// Cached hazard/wall bits packed into one byte:
+// bit0 bump R, bit1 bump L, bit2..5 cliff L/FL/FR/R, bit6 wall
+uint8_t sensorsPackedState();
+// Raw OI buttons byte (packet 18) from the cache
+uint8_t sensorsButtons();
+// Wheel drops from packet 7: bit0 right, bit1 left, bit2 caster
+uint8_t sensorsWheelDrops();
+// Overcurrents (packet 14): bit3 right wheel, bit4 left wheel, bits0-2 low-side drivers
+uint8_t sensorsOvercurrents();
+// Distance (mm) and angle (degrees, counter-clockwise positive) travelled
+// since the previous call, from packets 19/20; returns the number of
+// distance samples behind them (0 = no data, not "not moving").
+uint8_t sensorsTakeOdometry(int16_t &distMm, int16_t &angleDeg);
+// Heading since boot from the summed angle deltas (-180..179 degrees). Drifts
+// (Create 1 angle is coarse) but is good enough to recognise revisits.
+int16_t sensorsHeadingDeg();
+// Dead-reckoned position since boot (mm; x along the boot heading, y to its
+// left) and the unwrapped distance and turn totals behind it
+void sensorsPose(float &xMm, float &yMm, int32_t &travelMm, int32_t &turnDeg);
+// Battery from packets 22, 23, 25 and 26 (0 until streamed)
+uint16_t sensorsVoltageMv();
+int16_t sensorsCurrentMa(); // negative while discharging
+uint16_t sensorsChargeMah();
+uint16_t sensorsCapacityMah();
+
+// Fields that changed in the cached snapshot since the last call (bitmask)
+enum {
+  SENS_CHG_BUMPS   = 0x01,
+  SENS_CHG_CLIFFS  = 0x02,
+  SENS_CHG_WALL    = 0x04,
+  SENS_CHG_BUTTONS = 0x08,
+};
+uint8_t sensorsChangeMaskAndClear();
 
 // Optional: external bumper interrupt support
 // If your bumper switch is wired to a GPIO, call initSensors() and this will
 // auto-attach on supported boards. The event flag can be polled in the loop.
 bool bumperEventTriggeredAndClear();
+// Charge / capacity from the stream (100 before the first sample) unless overridden
 int batteryPercent();
 void setBatteryPercentOverride(int pct);
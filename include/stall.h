@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+// Stuck detection while the behavior drives. Fuses three OI signals with the
+// wheel speeds last sent (motionLastSent()):
+//  - slip: commanded travel adds up to STALL_EXPECT_MM (or STALL_EXPECT_DEG of
+//    turn) but packets 19/20 report under a quarter of it;
+//  - overcurrent: a drive wheel bit in packet 14 held for STALL_OC_MS;
+//  - wheel drop (packet 7) while commanded to move: high-centered or lifted.
+// Starting, stopping or reversing restarts the comparison after
+// STALL_SETTLE_MS so acceleration is not mistaken for a stall.
+
+#ifndef STALL_EXPECT_MM
+#define STALL_EXPECT_MM 25
+#endif
+#ifndef STALL_EXPECT_DEG
+#define STALL_EXPECT_DEG 15
+#endif
+#ifndef STALL_OC_MS
+#define STALL_OC_MS 120
+#endif
+#ifndef STALL_SETTLE_MS
+#define STALL_SETTLE_MS 150
+#endif
+
+enum StallReason {
+  STALL_NONE = 0,
+  STALL_SLIP,
+  STALL_OVERCURRENT,
+  STALL_WHEELDROP,
+};
+
+void stallReset();
+// Call every behavior cycle; returns a StallReason once per stuck event.
+uint8_t stallUpdate(unsigned long nowMs);
+const char* stallReasonName(uint8_t reason);
+uint16_t stallEvents();
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+
+// Change-only sensor telemetry for managed mode. Each loop the cached
+// snapshot's change mask decides which fields go out:
+//   SNS,<mask>[,<bumps>][,<cliffs>][,<wall>][,<buttons>],eid=<n>
+// Only fields whose bit is set follow, in bit order. A keyframe
+// (mask | SNS_KEYFRAME, all fields) goes out every TELEM_KEYFRAME_MS (the
+// battery governor stretches it on a low battery), on
+// entering managed mode, and after a record was lost to a full TX ring, so a
+// late joiner or a host that saw an eid gap resyncs within one period.
+//
+// With SET,odom_hz,<n> the same tick also sends dead-reckoned odometry n
+// times a second (off by default):
+//   ODOM,<x_m>,<y_m>,<theta_rad>,<vx_mps>,<wz_radps>,<seq>,eid=<n>
+// with three decimals; rates are averages since the previous record.
+
+// Mask bits (field order in the record)
+enum {
+  SNS_BUMPS    = 0x01, // PROTO_MASK_LEFT | PROTO_MASK_RIGHT
+  SNS_CLIFFS   = 0x02, // bit0 L, bit1 FL, bit2 FR, bit3 R
+  SNS_WALL     = 0x04, // 0/1
+  SNS_BUTTONS  = 0x08, // OI packet 18 byte
+  SNS_KEYFRAME = 0x80,
+};
+
+#ifndef TELEM_KEYFRAME_MS
+#define TELEM_KEYFRAME_MS 1000
+#endif
+#define TELEM_ODOM_MAX_HZ 50
+
+// Send a keyframe on the next telemetryTick().
+void telemetryForceKeyframe();
+// Keyframe period (ms); TELEM_KEYFRAME_MS until changed.
+void telemetrySetKeyframeMs(uint16_t ms);
+// ODOM records per second, 0..TELEM_ODOM_MAX_HZ (0 = off); false if out of range.
+bool telemetrySetOdomHz(uint16_t hz);
+// Call each managed-mode loop after the sensor stream was parsed.
+void telemetryTick();
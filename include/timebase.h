@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// Free-running high-resolution timebase on Timer1 (normal mode, F_CPU/8):
+// 0.5 us ticks extended to 32 bits by the overflow interrupt (wraps after
+// ~35.8 min; use unsigned differences). Compare A keeps a 1 ms counter so
+// millisecond users pay no division. All readers are safe inside ISRs.
+// Native builds derive ticks from the virtual micros() clock.
+//
+// Takes Timer1 from the core's pin 9/10 PWM (unused here); the profiler's
+// compare B shares the same counter configuration.
+
+static const uint8_t TB_TICKS_PER_US = 2;
+
+void initTimebase();
+// Raw 32-bit tick count (0.5 us)
+uint32_t tbTicks();
+// Microseconds and milliseconds on the same clock. tbMicros() is ticks/2 and
+// so wraps at 2^31; measure intervals with tbTicks() and tbTicksToUs().
+uint32_t tbMicros();
+uint32_t tbMillis();
+// Elapsed microseconds between two tbTicks() readings
+static inline uint32_t tbTicksToUs(uint32_t dt) { return dt / TB_TICKS_PER_US; }
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// Host-scheduled trajectory for forebrain mode. The host uploads wheel-speed
+// setpoints stamped on the brainstem clock (tbMillis(); GET,time reports it)
+// ahead of time; trajTick() plays them out on schedule, interpolating
+// linearly between points, so host and USB jitter no longer move the
+// moment a speed change reaches the wheels.
+//
+// The last point is held only if it stops the robot. Running past a moving
+// last point is an underrun: the wheels stop and TRAJ,underrun,<n> is
+// reported. ESTOP, a pause or leaving forebrain mode clears the queue.
+
+#ifndef TRAJ_POINTS
+#define TRAJ_POINTS 16
+#endif
+// Drive frame period while interpolating (the OI updates every 15 ms)
+#ifndef TRAJ_PERIOD_MS
+#define TRAJ_PERIOD_MS 15
+#endif
+// Create 1 wheel speed limit (mm/s); points are clamped to it
+#define TRAJ_MAX_MM_S 500
+
+// Queue a point; false when full or not after the last queued point.
+bool trajPush(uint32_t tMs, int16_t right, int16_t left);
+// Body velocity form: vx m/s, wz rad/s (Create wheel base 258 mm).
+bool trajPushTwist(uint32_t tMs, float vx, float wz);
+// Drop queued points and stop if a trajectory was driving.
+void trajClear();
+// Play out the queue; call each forebrain loop.
+void trajTick(uint32_t nowMs);
+uint8_t trajDepth();
+bool trajRunning();
+uint16_t trajUnderruns();
+// Points that arrived with their time already past (played late)
+uint16_t trajLate();
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// Trap detection for the foraging behavior. Keeps a short rolling history of
+// bumps (side, heading, time); bumps older than TRAP_WINDOW_MS fall out, so
+// habituation decays on its own. A trap episode starts when the history shows
+//  - a corner: bumps alternating left/right,
+//  - a cycle: the robot keeps bumping at the same heading (±TRAP_HEADING_DEG),
+//  - or simply TRAP_DENSE_BUMPS bumps inside the window.
+// Every further bump in the episode escalates the escape. The episode ends
+// once TRAP_CLEAR_MS pass without a bump; the time from its first bump to
+// its last is the time to escape.
+
+#ifndef TRAP_HISTORY
+#define TRAP_HISTORY 8
+#endif
+#ifndef TRAP_WINDOW_MS
+#define TRAP_WINDOW_MS 20000UL
+#endif
+#ifndef TRAP_CLEAR_MS
+#define TRAP_CLEAR_MS 5000UL
+#endif
+#ifndef TRAP_HEADING_DEG
+#define TRAP_HEADING_DEG 30
+#endif
+#ifndef TRAP_DENSE_BUMPS
+#define TRAP_DENSE_BUMPS 5
+#endif
+
+// Escape ladder, mildest first
+enum TrapEscape {
+  TRAP_NONE = 0,     // plain recoil
+  TRAP_WIDE_TURN,    // turn twice as far
+  TRAP_REVERSE_ARC,  // back out on an arc and flip the turn bias
+  TRAP_WALL_FOLLOW,  // hand over to following the other wall
+};
+
+void trapReset();
+// Record a bump (side: +1 right, -1 left, 0 both/unknown); returns the escape
+// to use for it.
+uint8_t trapBump(int8_t side, int16_t headingDeg, unsigned long nowMs);
+// Bumps still inside the window
+uint8_t trapRecentBumps(unsigned long nowMs);
+// Call each cycle; true once when an episode ends (escaped).
+bool trapTick(unsigned long nowMs);
+bool trapActive();
+uint8_t trapLevel();
+uint16_t trapEpisodes();
+uint32_t trapLastEscapeMs();
+uint32_t trapMaxEscapeMs();
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+// TWIST playout for forebrain teleop. Host commands arrive irregularly
+// (browser key repeat, host scheduling), so instead of a bare watchdog:
+//  - a small buffer keyed on <seq> drops late/duplicate commands and plays
+//    each one after an adaptive delay of up to half the nominal period, sized
+//    from the measured inter-arrival jitter;
+//  - the last command is held at full speed until the nominal period plus
+//    twist_hold_pct of it after its arrival, but never past watchdog_ms;
+//  - the speed then decays linearly, reaching zero at watchdog_ms after the
+//    last command, where the wheels stop and STALE,twist,<ms_since> is sent.
+
+#ifndef TWIST_SLOTS
+#define TWIST_SLOTS 4
+#endif
+
+// Queue a command that arrived at nowMs. Returns false when seq is not newer
+// than the last accepted one (dropped).
+bool twistPush(float vx, float wz, uint32_t seq, uint32_t nowMs);
+// Play out, hold or decay; call each forebrain loop.
+void twistTick(uint32_t nowMs);
+// Forget queued and playing commands and the last seq; stops the wheels if a
+// TWIST was driving.
+void twistClear();
+bool twistActive();
+
+// Tunables (SET,twist_period_ms / twist_hold_pct / watchdog_ms). Setters
+// return false for values out of range.
+bool twistSetPeriodMs(uint16_t ms);
+bool twistSetHoldPct(uint16_t pct);
+bool twistSetDeadlineMs(uint16_t ms);
+
+// Inter-arrival jitter estimate and current playout delay (ms)
+uint16_t twistJitterMs();
+uint16_t twistDelayMs();
+uint16_t twistStaleCount();
+uint16_t twistDropped();
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// Outbound line ring for managed-mode telemetry (proto.h). Fields are
+// formatted straight into the ring; txEndLine() appends ,eid=<n>\n and makes
+// the line visible to txFlush(). A line that does not fit is dropped whole,
+// so the host never sees a torn line. Call txFlush() each loop.
+//
+// Sent lines stay in the ring until new ones overwrite them; txReplay()
+// queues the ones still there again for a host that saw an eid gap.
+
+// Set while passthrough owns the USB port; lines queue but are not sent.
+extern bool tx_paused;
+
+void txBegin(const char* verb);    // start a line with its verb
+void txStr(const char* s);         // ",<s>"
+void txU32(uint32_t v);            // ",<v>"
+void txI32(int32_t v);             // ",<v>"
+void txFixed(int32_t scaled, uint8_t decimals); // ",<scaled / 10^decimals>"
+void txFloat(float v, uint8_t decimals);
+void txEndLine();                  // ",eid=<n>\n" and commit
+void txFlush();                    // drain to USB within its free space
+uint32_t txLastEid();
+// Queue again, in order and with their original eids, the sent lines still
+// in the ring whose eid is after sinceEid, keeping room for one more line.
+// Returns the first eid queued (0 if none), so the caller can tell whether
+// some were already overwritten. Lines up to sinceEid are forgotten. Call
+// between lines, not inside one.
+uint32_t txReplay(uint32_t sinceEid);
+uint16_t txDroppedLines();
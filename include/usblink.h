@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+// Host link presence taken from the USB stack instead of traffic: VBUS,
+// SOF frame-counter progress (stops within a few ms of suspend or unplug)
+// and the CDC DTR line state. A quiet but connected host stays present; a
+// pulled cable is noticed without any keepalive traffic.
+
+enum UsbLinkEvent {
+  USB_LINK_NONE = 0,
+  USB_LINK_UP,
+  USB_LINK_DOWN,
+};
+
+// Reasons the link is considered down (bitmask, 0 when present)
+enum {
+  USB_LINK_NO_VBUS   = 0x01,
+  USB_LINK_SOF_STALL = 0x02, // no start-of-frame progress: suspended or unplugged
+  USB_LINK_NO_DTR    = 0x04, // port not opened by a host program
+};
+
+void initUsbLink();
+// Poll each loop. On a presence edge this emits LINK,<0|1>,<seq>, notifies
+// the passthrough watchdog, and returns the event.
+UsbLinkEvent usbLinkPoll();
+bool usbLinkPresent();
+uint8_t usbLinkDownReason();
+// Number of presence transitions (the <seq> in LINK lines)
+uint16_t usbLinkTransitions();
+
+#ifndef ARDUINO
+// Native builds: drive the signals the 32U4 would report.
+void usbLinkSimulate(bool vbus, bool sofRunning, bool dtr);
+#endif
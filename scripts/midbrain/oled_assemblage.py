@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 import argparse
+import json
 import os
 import signal
 import socket
@@ -7,9 +8,10 @@ import subprocess
 import sys
 import time
 from datetime import datetime
+from functools import partial
 
 import psutil
-from PIL import ImageFont
+from PIL import Image, ImageDraw, ImageFont
 from luma.core.interface.serial import i2c
 from luma.core.render import canvas
 from luma.oled.device import sh1106, ssd1306
@@ -22,16 +24,48 @@ DEFAULT_ORIENTATION = "landscape"  # portrait | landscape | portrait180 | landsc
 DEFAULT_CONTROLLER = "sh1106"  # your panel
 DEFAULT_INTERVAL = 3.0  # seconds per page
 DEFAULT_H_OFFSET = 2    # SH1106 often needs this (landscape). Portrait usually 0.
+DEFAULT_REFRESH = 1.0   # seconds between redraw checks of the current page
+DEFAULT_BRAINSTEM_BAUD = 115200
+
+# How long each metric stays cached (seconds). Pages read these caches, so a
+# page redrawn every second only samples what is actually due.
+TTL_NET = 30.0
+TTL_CPU = 2.0
+TTL_TEMP = 5.0
+TTL_MEM_DISK = 10.0
+TTL_ROS = 30.0      # the ros2 CLI is slow; keep it rare
+TTL_BRAINSTEM = 2.0
 
 # ---------- Small helpers ----------
+class Cached:
+    """Value produced by fn, refreshed at most once per ttl seconds.
+
+    A failed refresh keeps the previous value."""
+
+    def __init__(self, fn, ttl):
+        self.fn = fn
+        self.ttl = ttl
+        self.value = None
+        self.stamp = None
+
+    def get(self):
+        now = time.monotonic()
+        if self.stamp is None or now - self.stamp >= self.ttl:
+            self.stamp = now
+            try:
+                self.value = self.fn()
+            except Exception:
+                pass
+        return self.value
+
 def ip_addrs():
-    # Prefer non-loopback IPv4s in a simple, dependency-free way
+    # Non-loopback IPv4s straight from the interface table (no subprocess)
     addrs = []
     try:
-        out = subprocess.check_output("hostname -I", shell=True, text=True).strip()
-        for tok in out.split():
-            if tok and not tok.startswith("127."):
-                addrs.append(tok)
+        for name, entries in psutil.net_if_addrs().items():
+            for a in entries:
+                if a.family == socket.AF_INET and not a.address.startswith("127."):
+                    addrs.append(a.address)
     except Exception:
         pass
     if not addrs:
@@ -102,7 +136,115 @@ def make_device(controller, width, height, addr=None, rotate=DEFAULT_ROTATE, h_o
             continue
     raise RuntimeError(f"Could not init display at {addrs} ({last_err})")
 
+# ---------- Metrics ----------
+def cpu_metrics():
+    freq = psutil.cpu_freq()
+    return psutil.getloadavg(), (freq.current if freq else None)
+
+def mem_disk_metrics():
+    return psutil.virtual_memory(), psutil.disk_usage("/")
+
+# OPTIONAL: ROS 2 peek without bringing rclpy
+def ros_counts():
+    nodes = subprocess.check_output("ros2 node list 2>/dev/null | wc -l", shell=True, text=True).strip()
+    topics = subprocess.check_output("ros2 topic list 2>/dev/null | wc -l", shell=True, text=True).strip()
+    return nodes, topics
+
+NET = Cached(ip_addrs, TTL_NET)
+CPU = Cached(cpu_metrics, TTL_CPU)
+TEMP = Cached(cpu_temp_c, TTL_TEMP)
+MEM_DISK = Cached(mem_disk_metrics, TTL_MEM_DISK)
+ROS = Cached(ros_counts, TTL_ROS)
+
+def _is_bridge_port(dev):
+    """True when dev is the first CDC function (the OI bridge) of the brainstem.
+
+    The control port is the second CDC function, so its data interface is not
+    interface 0. Unknown layouts (no sysfs) are allowed.
+    """
+    try:
+        name = os.path.basename(os.path.realpath(dev))
+        with open(f"/sys/class/tty/{name}/device/bInterfaceNumber") as f:
+            return int(f.read().strip(), 16) < 2
+    except (OSError, ValueError):
+        return False
+
+class Brainstem:
+    """Polls the brainstem's STATUS line over its control port.
+
+    Only the DUAL_CDC control port (SerialCtl, usually /dev/ttyACM1) is
+    used: there !status needs no escape and nothing is bridged. The bridge
+    port belongs to the host stack -- reading it would steal robot bytes and
+    writing would interleave with its OI frames -- so it is refused. Byte
+    rates come from the bridge counters of consecutive replies.
+
+    STATUS comes from the managed stack, i.e. env:brainstem_promicro_dualcdc,
+    and only once the host's HELLO got READY; before that the firmware
+    answers nothing but HELLO. The dashboard never sends HELLO itself (it
+    power-cycles the robot and starts the host's session), so until then it
+    shows the link as waiting.
+    """
+
+    def __init__(self, dev, baud=DEFAULT_BRAINSTEM_BAUD):
+        self.dev = dev
+        self.baud = baud
+        self.ser = None
+        self.bridge = _is_bridge_port(dev)
+        self.prev = None   # (monotonic time, h2r, r2h) of the last reply
+        self.rates = None  # (host->robot, robot->host) bytes/s
+
+    def _open(self):
+        if self.ser is None:
+            import serial  # only needed when the page is enabled
+            self.ser = serial.Serial(self.dev, self.baud, timeout=0.2)
+        return self.ser
+
+    def query(self):
+        if self.bridge:
+            return None
+        try:
+            ser = self._open()
+            ser.write(b"!status\n")
+            deadline = time.monotonic() + 0.5
+            while time.monotonic() < deadline:
+                ln = ser.readline().decode(errors="ignore").strip()
+                if ln.startswith("STATUS:"):
+                    return self._update(json.loads(ln[len("STATUS:"):]))
+        except Exception:
+            # Reopen next time (unplugged, re-enumerated, ...)
+            try:
+                if self.ser is not None:
+                    self.ser.close()
+            except Exception:
+                pass
+            self.ser = None
+        self.prev = None
+        self.rates = None
+        return None
+
+    def _update(self, st):
+        now = time.monotonic()
+        h2r, r2h = st.get("h2r"), st.get("r2h")
+        if self.prev and h2r is not None and r2h is not None:
+            t0, h0, r0 = self.prev
+            dt = now - t0
+            # Counters restart with the firmware; skip the interval if they went back
+            if dt > 0 and h2r >= h0 and r2h >= r0:
+                self.rates = ((h2r - h0) / dt, (r2h - r0) / dt)
+        if h2r is not None and r2h is not None:
+            self.prev = (now, h2r, r2h)
+        st["_rates"] = self.rates
+        return st
+
+def human_rate(bps):
+    if bps is None:
+        return "-"
+    if bps >= 1000:
+        return f"{bps/1000:.1f}k"
+    return f"{bps:.0f}"
+
 # ---------- Pages ----------
+# Each page returns (header, lines); Frames draws and pushes them.
 def page_splash(device, name="Midbrain", sub="SH1106 @ Geekworm"):
     w, h = device.width, device.height
     f = pick_font()
@@ -112,65 +254,84 @@ def page_splash(device, name="Midbrain", sub="SH1106 @ Geekworm"):
         draw.text((4, 24), sub, fill=255, font=f)
         draw.text((4, 48), "Booting…", fill=255, font=f)
 
-def page_network(device):
-    w, h = device.width, device.height
-    f = pick_font()
-    addrs = ip_addrs()
-    with canvas(device) as draw:
-        draw_header(draw, "NET", w)
-        y = 14
-        for ip in addrs[:3]:  # show up to 3
-            draw.text((2, y), ip, fill=255, font=f)
-            y += 12
+def page_network():
+    return "NET", (NET.get() or [])[:3]  # show up to 3
 
-def page_cpu(device):
-    w, h = device.width, device.height
-    f = pick_font()
-    load1, load5, load15 = psutil.getloadavg()
-    freq = psutil.cpu_freq()
-    temp = cpu_temp_c()
-    with canvas(device) as draw:
-        draw_header(draw, "CPU", w)
-        draw.text((2, 14), f"Load: {load1:.2f} {load5:.2f} {load15:.2f}", fill=255, font=f)
+def page_cpu():
+    lines = []
+    m = CPU.get()
+    if m:
+        (load1, load5, load15), freq = m
+        lines.append(f"Load: {load1:.2f} {load5:.2f} {load15:.2f}")
         if freq:
-            draw.text((2, 26), f"Freq: {freq.current/1000:.2f} GHz", fill=255, font=f)
-        if temp is not None:
-            draw.text((2, 38), f"Temp: {temp:.1f}°C", fill=255, font=f)
+            lines.append(f"Freq: {freq/1000:.2f} GHz")
+    temp = TEMP.get()
+    if temp is not None:
+        lines.append(f"Temp: {temp:.1f}°C")
+    return "CPU", lines
 
-def page_mem_disk(device):
-    w, h = device.width, device.height
-    f = pick_font()
-    vm = psutil.virtual_memory()
-    du = psutil.disk_usage("/")
-    with canvas(device) as draw:
-        draw_header(draw, "MEM/DISK", w)
-        draw.text((2, 14), f"RAM: {human_pct(vm.percent)}  ({vm.used//(1024**2)}M/{vm.total//(1024**2)}M)", fill=255, font=f)
-        draw.text((2, 26), f"Disk:{human_pct(du.percent)}  ({du.used//(1024**3)}G/{du.total//(1024**3)}G)", fill=255, font=f)
+def page_mem_disk():
+    m = MEM_DISK.get()
+    if not m:
+        return "MEM/DISK", []
+    vm, du = m
+    return "MEM/DISK", [
+        f"RAM: {human_pct(vm.percent)}  ({vm.used//(1024**2)}M/{vm.total//(1024**2)}M)",
+        f"Disk:{human_pct(du.percent)}  ({du.used//(1024**3)}G/{du.total//(1024**3)}G)",
+    ]
 
-def page_clock(device):
-    w, h = device.width, device.height
-    f = pick_font()
+def page_clock():
     now = datetime.now()
-    with canvas(device) as draw:
-        draw_header(draw, "TIME", w)
-        draw.text((2, 16), now.strftime("%Y-%m-%d"), fill=255, font=f)
-        draw.text((2, 30), now.strftime("%H:%M:%S"), fill=255, font=f)
+    return "TIME", [now.strftime("%Y-%m-%d"), now.strftime("%H:%M:%S")]
 
-# OPTIONAL: ROS 2 peek without bringing rclpy
-def page_ros(device):
-    w, h = device.width, device.height
-    f = pick_font()
-    try:
-        nodes = subprocess.check_output("ros2 node list 2>/dev/null | wc -l", shell=True, text=True).strip()
-        topics = subprocess.check_output("ros2 topic list 2>/dev/null | wc -l", shell=True, text=True).strip()
-        with canvas(device) as draw:
-            draw_header(draw, "ROS 2", w)
-            draw.text((2, 16), f"Nodes:  {nodes}", fill=255, font=f)
-            draw.text((2, 28), f"Topics: {topics}", fill=255, font=f)
-    except Exception:
-        with canvas(device) as draw:
-            draw_header(draw, "ROS 2", w)
-            draw.text((2, 16), "ros2 CLI not found", fill=255, font=f)
+def page_ros():
+    counts = ROS.get()
+    if counts is None:
+        return "ROS 2", ["ros2 CLI not found"]
+    nodes, topics = counts
+    return "ROS 2", [f"Nodes:  {nodes}", f"Topics: {topics}"]
+
+def page_brainstem(status):
+    st = status.get()
+    if not st:
+        # Bare bridge builds, or managed before the host's HELLO/READY
+        return "BRAINSTEM", ["no STATUS reply", "waiting for HELLO", "(dualcdc env only)"]
+    link = "UP" if st.get("link", 1) else "DOWN"
+    lines = [f"Link: {link} {st.get('state', '?')}"]
+    if "mode" in st:
+        lines.append(f"Mode: {st['mode']} E:{st.get('estop', 0)}")
+    rates = st.get("_rates")
+    if rates:
+        lines.append(f"B/s >{human_rate(rates[0])} <{human_rate(rates[1])}")
+    else:
+        lines.append("B/s >- <-")
+    if "loop_us" in st:
+        lines.append(f"Loop {st['loop_us']}us max {st.get('loop_max_us', 0)}")
+    return "BRAINSTEM", lines
+
+class Frames:
+    """Draws pages into an off-screen image and sends it to the panel only
+    when the page content differs from what is already shown."""
+
+    def __init__(self, device):
+        self.device = device
+        self.font = pick_font()
+        self.shown = None
+
+    def show(self, header, lines):
+        key = (header, tuple(lines))
+        if key == self.shown:
+            return False
+        img = Image.new(self.device.mode, self.device.size)
+        draw = ImageDraw.Draw(img)
+        draw_header(draw, header, self.device.width)
+        y = 14
+        for ln in lines:
+            draw.text((2, y), ln, fill=255, font=self.font)
+            y += 12
+        self.device.display(img)
+        self.shown = key
+        return True
 
 PAGES = [page_network, page_cpu, page_mem_disk, page_clock, page_ros]
 
@@ -204,6 +365,14 @@ def main():
                     default=(int(os.getenv("OLED_H_OFFSET")) if os.getenv("OLED_H_OFFSET") is not None else None),
                     help="SH1106 horizontal offset. If omitted, auto: 2 for landscape, 0 for portrait")
     ap.add_argument("--interval", type=float, default=float(os.getenv("OLED_INTERVAL", DEFAULT_INTERVAL)))
+    ap.add_argument("--refresh", type=float, default=float(os.getenv("OLED_REFRESH", DEFAULT_REFRESH)),
+                    help="Seconds between content checks; the panel is only written on change")
+    ap.add_argument("--brainstem", default=os.getenv("OLED_BRAINSTEM"),
+                    help="Brainstem control port (e.g. /dev/ttyACM1) of the "
+                         "brainstem_promicro_dualcdc build for the link page; STATUS starts after "
+                         "the host's HELLO/READY. The bridge port is refused")
+    ap.add_argument("--brainstem-baud", dest="brainstem_baud", type=int,
+                    default=int(os.getenv("OLED_BRAINSTEM_BAUD", DEFAULT_BRAINSTEM_BAUD)))
     ap.add_argument("--name", default=os.getenv("OLED_NAME", "Midbrain"))
     ap.add_argument("--splash", action="store_true", help="Show splash for 2s at start")
     args = ap.parse_args()
@@ -245,17 +414,27 @@ def main():
         page_splash(device, args.name)
         time.sleep(2)
 
+    pages = list(PAGES)
+    if args.brainstem:
+        link = Brainstem(args.brainstem, args.brainstem_baud)
+        if link.bridge:
+            print(f"{args.brainstem} is the brainstem bridge port; pass the control port "
+                  "(DUAL_CDC, e.g. /dev/ttyACM1)", file=sys.stderr)
+        pages.append(partial(page_brainstem, Cached(link.query, TTL_BRAINSTEM)))
+
+    frames = Frames(device)
     i = 0
+    page_start = time.monotonic()
     while running:
         try:
-            PAGES[i % len(PAGES)](device)
+            frames.show(*pages[i % len(pages)]())
         except Exception as e:
             # Show the error briefly but don't crash the loop
-            with canvas(device) as draw:
-                draw.text((0, 0), "ERR:", fill=255)
-                draw.text((0, 12), str(e)[:18], fill=255)
-        time.sleep(args.interval)
-        i += 1
+            frames.show("ERR", [str(e)[:18]])
+        time.sleep(min(args.refresh, args.interval))
+        if time.monotonic() - page_start >= args.interval:
+            i += 1
+            page_start = time.monotonic()
 
     # Clear on exit
     try:
@@ -0,0 +1,40 @@
+#include "arbiter.h"
+
+static BehaviorLayer* layers = nullptr;
+static uint8_t layerCount = 0;
+static bool runAll = true;
+
+void arbiterInit(BehaviorLayer* l, uint8_t count, unsigned long nowMs) {
+  layers = l;
+  layerCount = count;
+  for (uint8_t i = 0; i < count; ++i) {
+    layers[i].lastRunMs = nowMs;
+    layers[i].proposal.active = false;
+    layers[i].runs = 0;
+  }
+  runAll = true;
+}
+
+void arbiterReset() {
+  for (uint8_t i = 0; i < layerCount; ++i) layers[i].proposal.active = false;
+  runAll = true;
+}
+
+uint8_t arbiterStep(unsigned long nowMs, MotionProposal &winner) {
+  for (uint8_t i = 0; i < layerCount; ++i) {
+    BehaviorLayer &l = layers[i];
+    if (runAll || l.periodMs == 0 || nowMs - l.lastRunMs >= l.periodMs) {
+      l.run(l.proposal, nowMs);
+      l.lastRunMs = nowMs;
+      l.runs++;
+    }
+  }
+  runAll = false;
+  for (uint8_t i = 0; i < layerCount; ++i) {
+    if (layers[i].proposal.active) {
+      winner = layers[i].proposal;
+      return i;
+    }
+  }
+  return ARBITER_NONE;
+}
@@ -1,10 +1,24 @@
 #include "behavior.h"
+#include "cdc_ctl.h"
+#include "arbiter.h"
 #include "motion.h"
 #include "sensors.h"
 #include "utils.h"
 #include "leds.h"
+#include "fdr.h"
+#include "governor.h"
+#include "energy.h"
+#include "estop.h"
+#include "stall.h"
+#include "trap.h"
+#include "tx.h"
 #include <Arduino.h>
 
+// Latch ESTOP on the cliff reflex (host must send SAFE,1 to resume)
+#ifndef ESTOP_ON_CLIFF
+#define ESTOP_ON_CLIFF 1
+#endif
+
 enum State {
   CONNECTING,
   WAITING,
@@ -19,7 +33,7 @@ enum State {
 
 static State currentState = CONNECTING;
 static unsigned long lastTick = 0;
-const unsigned long tickInterval = 100; // ms
+const unsigned long tickInterval = 100; // ms: connection, watchdog and keepalive cadence
 static bool wanderEnabled = false; // default sedate: no translation until enabled
 
 // Micro-behavior internal state inspired by simple animal foraging:
@@ -28,56 +42,335 @@ static bool wanderEnabled = false; // default sedate: no translation until enabl
 // - persistence: maintain heading bias to avoid pure random walk
 static unsigned long stateEnterMs = 0;
 static int8_t turnBias = 1;           // +1 = favor right, -1 = favor left
-static unsigned runTicksTarget = 5;   // desired forward ticks in a run
+static unsigned runTicksTarget = 5;   // desired forward steps in a run
 static unsigned runTicksSoFar = 0;    // progress through the current run
 static unsigned castingPhase = 0;     // toggles small left/right arcs while seeking
-static unsigned bumpsRecently = 0;    // habituation counter
+static unsigned bumpsRecently = 0;    // habituation: bumps in the trap window
 static unsigned long lastBumpMs = 0;  // timestamp of last bumper event
 static unsigned long bumperFlashUntil = 0; // LED alert window
 // Wall-follow settings
 static bool followRight = true; // default side
+static bool wallEngaged = false; // a recoil hands the robot over to wall following
+static unsigned long wallEngagedMs = 0; // start of the current wall run
+static unsigned long wallSeenMs = 0;    // last wall signal during it
+// A wall run ends after this long, or once the wall has been out of reach
+// for WALL_LOST_MS; seeking takes over again
+static const unsigned long WALL_RUN_MS = 15000;
+static const unsigned long WALL_LOST_MS = 1500;
 // Reconnect backoff state
 static unsigned long nextConnectAttemptMs = 0;
 static unsigned connectRetry = 0; // exponential backoff counter
 static const unsigned long CONNECT_BASE_MS = 500;   // initial interval
 static const unsigned long CONNECT_MAX_MS  = 8000;  // cap interval
 
+// Wheel speeds (mm/s before the motion speed scale) and maneuver step length;
+// one step matches one of the former blocking motion ticks.
+static const int16_t VELOCITY = 200;
+static const int16_t VEER_SLOW = (VELOCITY * 3) / 5;
+static const unsigned long STEP_MS = 100;
+// Re-send an unchanged moving command this often so the OI never idles out
+static const unsigned long DRIVE_REFRESH_MS = 200;
+
+static int16_t lastRight = 0, lastLeft = 0;
+static unsigned long lastDriveMs = 0;
+
+static uint8_t energyAccountFor(State s) {
+  switch (s) {
+    case WALL_FOLLOWING: return ENERGY_WALL;
+    case SEEKING:        return ENERGY_SEEK;
+    case ADVANCING:      return ENERGY_ADVANCE;
+    case RECOILING:      return ENERGY_RECOIL;
+    case TURNING_LEFT:
+    case TURNING_RIGHT:  return ENERGY_TURN;
+    default:             return ENERGY_IDLE;
+  }
+}
+
 static inline void enterState(State s) {
   State prev = currentState;
-  auto name = [](State st) -> const char* {
-    switch (st) {
-      case CONNECTING: return "CONNECTING";
-      case WAITING: return "WAITING";
-      case WALL_FOLLOWING: return "WALL_FOLLOWING";
-      case SEEKING: return "SEEKING";
-      case ADVANCING: return "ADVANCING";
-      case RECOILING: return "RECOILING";
-      case TURNING_LEFT: return "TURNING_LEFT";
-      case TURNING_RIGHT: return "TURNING_RIGHT";
-      case FROZEN: return "FROZEN";
-    }
-    return "?";
-  };
-  // Logs suppressed to save flash
-  // Play a distinct audio cue only when state actually changes
-  if (s != currentState) {
-    // Audio suppressed in minimal build
-  }
+  if (s == prev) return;
+  fdrRecord(FDR_STATE, (uint8_t)s, (int16_t)prev);
   currentState = s;
+  energySetActivity(energyAccountFor(s));
   stateEnterMs = millis();
   // Event-based expressions
-  if (prev == RECOILING && s == SEEKING) {
+  if (prev == RECOILING && s == SEEKING && governorAllow()) {
     // After escaping a bump, playful chirp
     playOopsChirp();
   }
-  // reset per-state counters where appropriate
-  if (s == ADVANCING) {
+}
+
+static inline void propose(MotionProposal &p, int16_t right, int16_t left, State s) {
+  p.active = true;
+  p.right = right;
+  p.left = left;
+  p.tag = (uint8_t)s;
+}
+
+// --- Reflex layer (every cycle): cliff freeze, bump recoil ---------------
+
+enum RecoilPhase { RECOIL_NONE, RECOIL_BACK, RECOIL_TURN };
+static RecoilPhase recoilPhase = RECOIL_NONE;
+static unsigned long recoilPhaseEndMs = 0;
+static bool frozenAlerted = false;
+// Escape chosen by the trap detector for the current recoil (trap.h)
+static uint8_t trapEscape = TRAP_NONE;
+
+// Stuck (stall.h): back out longer than a bump recoil and turn the other way,
+// since the current heading is what wedged us
+static const unsigned STUCK_BACK_STEPS = 5;
+
+static void reportStuck(uint8_t reason) {
+  // STUCK,<reason>,<count>
+  txBegin("STUCK");
+  txStr(stallReasonName(reason));
+  txU32(stallEvents());
+  txEndLine();
+}
+
+static void startEscape(unsigned long now) {
+  lastBumpMs = now;
+  trapEscape = TRAP_NONE;
+  turnBias = -turnBias;
+  if (bumpsRecently < 2) bumpsRecently = 2; // full-length turn
+  recoilPhase = RECOIL_BACK;
+  recoilPhaseEndMs = now + STUCK_BACK_STEPS * STEP_MS;
+}
+
+static void reportTrapEscaped() {
+  // TRAP,escaped,<ms>,<episodes>
+  txBegin("TRAP");
+  txStr("escaped");
+  txU32(trapLastEscapeMs());
+  txU32(trapEpisodes());
+  txEndLine();
+}
+
+static void startRecoil(unsigned long now) {
+  // Habituation: record the bump; back up longer if we've bumped repeatedly
+  lastBumpMs = now;
+  uint8_t bumps = sensorsPackedState() & 0x03;
+  int8_t side = bumps == 0x01 ? 1 : (bumps == 0x02 ? -1 : 0);
+  trapEscape = trapBump(side, sensorsHeadingDeg(), now);
+  bumpsRecently = trapRecentBumps(now);
+  if (trapEscape != TRAP_NONE) fdrRecord(FDR_REFLEX, FDR_REFLEX_TRAP_ESCAPE, trapEscape);
+  if (bumpsRecently >= 5) fdrTrigger(FDR_TRIG_BUMPS);
+  recoilPhase = RECOIL_BACK;
+  unsigned steps = trapEscape >= TRAP_REVERSE_ARC ? 4 : (bumpsRecently >= 3 ? 2 : 1);
+  recoilPhaseEndMs = now + steps * STEP_MS;
+}
+
+static void reflexLayer(MotionProposal &p, unsigned long now) {
+  p.active = false;
+  // Asynchronous bumper interrupt: play song, flash LEDs, and recoil
+  if (bumperEventTriggeredAndClear()) {
+    if (governorAllow()) playBumperSong();
+    bumperFlashUntil = now + 600; // flash for 0.6s
+    fdrRecord(FDR_REFLEX, FDR_REFLEX_ISR_RECOIL);
+    startRecoil(now);
+  }
+
+  // Safety preemption: a cliff freezes everything
+  if (cliffDetected()) {
+    if (currentState != FROZEN) fdrRecord(FDR_REFLEX, FDR_REFLEX_CLIFF_FREEZE);
+#if ESTOP_ON_CLIFF
+    if (!estopActive()) estopSet(ESTOP_SRC_REFLEX);
+#endif
+    if (!frozenAlerted) {
+      alertFreeze();
+      frozenAlerted = true;
+    }
+    recoilPhase = RECOIL_NONE;
+    propose(p, 0, 0, FROZEN);
+    return;
+  }
+  frozenAlerted = false;
+
+  if (trapTick(now)) reportTrapEscaped();
+  uint8_t stuck = stallUpdate(now);
+  if (stuck != STALL_NONE) {
+    fdrRecord(FDR_REFLEX, FDR_REFLEX_STUCK, stuck);
+    reportStuck(stuck);
+    if (stuck != STALL_WHEELDROP) startEscape(now);
+  }
+  // No driving with a wheel in the air (high-centered or picked up)
+  if (sensorsWheelDrops()) {
+    recoilPhase = RECOIL_NONE;
+    propose(p, 0, 0, FROZEN);
+    return;
+  }
+
+  if (recoilPhase == RECOIL_NONE && bumperTriggered()) {
+    fdrRecord(FDR_REFLEX, FDR_REFLEX_BUMP_RECOIL);
+    startRecoil(now);
+  }
+  if (recoilPhase == RECOIL_NONE) return;
+
+  if (recoilPhase == RECOIL_BACK && (long)(now - recoilPhaseEndMs) >= 0) {
+    // Turn away using bias; escalating trap escapes flip it and, last,
+    // follow the other wall out
+    if (trapEscape >= TRAP_REVERSE_ARC) {
+      fdrRecord(FDR_REFLEX, FDR_REFLEX_BIAS_FLIP, turnBias);
+      turnBias = -turnBias;
+#ifdef ENABLE_DEBUG
+      CONTROL_SERIAL.println("[FSM] RECOIL flipping bias to escape");
+#endif
+    }
+    if (trapEscape == TRAP_WALL_FOLLOW) followRight = !followRight;
+    recoilPhase = RECOIL_TURN;
+    unsigned steps = trapEscape >= TRAP_WIDE_TURN ? 4 : (bumpsRecently >= 2 ? 2 : 1);
+    recoilPhaseEndMs = now + steps * STEP_MS;
+  }
+  if (recoilPhase == RECOIL_TURN && (long)(now - recoilPhaseEndMs) >= 0) {
+    // Start a shorter forward run after recoil to test the new heading
+    recoilPhase = RECOIL_NONE;
+    runTicksTarget = 4;
+    wallEngaged = true;
+    wallEngagedMs = wallSeenMs = now;
+    return;
+  }
+
+  if (recoilPhase == RECOIL_BACK && trapEscape >= TRAP_REVERSE_ARC) {
+    // Swing the rear so the nose already points along the coming turn
+    if (turnBias > 0) propose(p, -VELOCITY, -VEER_SLOW, RECOILING);
+    else propose(p, -VEER_SLOW, -VELOCITY, RECOILING);
+  } else if (recoilPhase == RECOIL_BACK && !wanderEnabled) {
+    // Sedate: no translation; hold still, then turn in place
+    propose(p, 0, 0, RECOILING);
+  } else if (recoilPhase == RECOIL_BACK) {
+    propose(p, -VELOCITY, -VELOCITY, RECOILING);
+  } else if (turnBias > 0) {
+    propose(p, -VELOCITY, VELOCITY, RECOILING);
+  } else {
+    propose(p, VELOCITY, -VELOCITY, RECOILING);
+  }
+}
+
+// --- Avoid layer (50 ms): turn toward a directional stimulus --------------
+
+static unsigned long avoidUntilMs = 0;
+static bool avoidRight = false;
+// Run-and-cast phase shared with the seek layer
+static bool advancing = false;
+
+static void avoidLayer(MotionProposal &p, unsigned long now) {
+  p.active = false;
+  if (!wanderEnabled || wallEngaged) return;
+  if (avoidUntilMs == 0) {
+    int stimulus = scanEnvironment();
+    if (stimulus != -1 && stimulus != 2) return;
+    avoidRight = (stimulus == 2);
+    avoidUntilMs = now + STEP_MS;
+  }
+  if ((long)(now - avoidUntilMs) >= 0) {
+    // Reinforce the bias toward the stimulus and capitalize with a medium run
+    avoidUntilMs = 0;
+    turnBias = avoidRight ? 1 : -1;
+    runTicksTarget = 6;
+    runTicksSoFar = 0;
+    advancing = true;
+    return;
+  }
+  if (avoidRight) propose(p, -VELOCITY, VELOCITY, TURNING_RIGHT);
+  else propose(p, VELOCITY, -VELOCITY, TURNING_LEFT);
+}
+
+// --- Wall-follow layer (100 ms) ------------------------------------------
+
+static void wallFollowLayer(MotionProposal &p, unsigned long now) {
+  p.active = false;
+  if (!wanderEnabled || !wallEngaged) return;
+  bool wall = wallDetected();
+  if (wall) wallSeenMs = now;
+  if (now - wallEngagedMs >= WALL_RUN_MS || now - wallSeenMs >= WALL_LOST_MS) {
+    wallEngaged = false;
+    return;
+  }
+  if (wall) {
+    // When on a wall, bias toward it slightly and move forward
+    if (followRight) propose(p, VEER_SLOW, VELOCITY, WALL_FOLLOWING);
+    else propose(p, VELOCITY, VEER_SLOW, WALL_FOLLOWING);
+  } else {
+    // Search for wall: rotate toward the side we follow
+    if (followRight) propose(p, -VELOCITY, VELOCITY, WALL_FOLLOWING);
+    else propose(p, VELOCITY, -VELOCITY, WALL_FOLLOWING);
+  }
+}
+
+// --- Seek/wander layer (100 ms): run-and-cast foraging --------------------
+
+static void seekLayer(MotionProposal &p, unsigned long now) {
+  p.active = false;
+  if (!wanderEnabled) return;
+  bool favorRight = (turnBias > 0);
+  if (advancing) {
+    // Gentle veer in the direction of bias to create a run
+    runTicksSoFar++;
+    if (runTicksSoFar >= runTicksTarget) advancing = false; // brief seek to reassess
+    if (favorRight) propose(p, VEER_SLOW, VELOCITY, ADVANCING);
+    else propose(p, VELOCITY, VEER_SLOW, ADVANCING);
+    return;
+  }
+  if (scanEnvironment() == 1) {
+    // Forward attractant: longer runs if we haven't bumped recently
+    runTicksTarget = (now - lastBumpMs > 5000) ? 10 : 6;
     runTicksSoFar = 0;
-  } else if (s == SEEKING) {
-    castingPhase = 0;
+    advancing = true;
+    propose(p, VELOCITY, VELOCITY, ADVANCING);
+    return;
+  }
+  // No stimulus: casting — alternating gentle arcs, slightly biased toward
+  // turnBias to create persistence without random walk; every fifth step
+  // probes straight ahead.
+  castingPhase++;
+  if ((castingPhase % 5) == 0) {
+    propose(p, VELOCITY, VELOCITY, SEEKING);
+  } else if (((castingPhase % 4) < 3) == favorRight) {
+    propose(p, VEER_SLOW, VELOCITY, SEEKING);
+  } else {
+    propose(p, VELOCITY, VEER_SLOW, SEEKING);
   }
 }
 
+// --- Idle-fidget layer (sedate mode): eased in-place turns ----------------
+
+static bool fidgetMoving = false;
+
+static void fidgetLayer(MotionProposal &p, unsigned long now) {
+  (void)now;
+  p.active = false;
+  if (wanderEnabled) return;
+  // Alternate a short half-speed turn in a random direction with a rest; on
+  // a low battery the governor skips some of the turns
+  fidgetMoving = !fidgetMoving && governorAllow();
+  if (!fidgetMoving) {
+    propose(p, 0, 0, SEEKING);
+  } else if (random(2) == 0) {
+    propose(p, VELOCITY / 2, -VELOCITY / 2, SEEKING);
+  } else {
+    propose(p, -VELOCITY / 2, VELOCITY / 2, SEEKING);
+  }
+}
+
+// Highest priority first
+static BehaviorLayer layers[] = {
+  { "reflex", 0,   reflexLayer,     0, { false, 0, 0, 0 }, 0 },
+  { "avoid",  50,  avoidLayer,      0, { false, 0, 0, 0 }, 0 },
+  { "wall",   100, wallFollowLayer, 0, { false, 0, 0, 0 }, 0 },
+  { "seek",   100, seekLayer,       0, { false, 0, 0, 0 }, 0 },
+  { "fidget", 150, fidgetLayer,     0, { false, 0, 0, 0 }, 0 },
+};
+
+static void applyDrive(int16_t right, int16_t left, unsigned long now) {
+  bool changed = (right != lastRight || left != lastLeft);
+  bool moving = (right != 0 || left != 0);
+  if (!changed && !(moving && now - lastDriveMs >= DRIVE_REFRESH_MS)) return;
+  motionDrive(right, left);
+  lastRight = right;
+  lastLeft = left;
+  lastDriveMs = now;
+}
+
 void initializeBehavior() {
   initMotors();
   initSensors();
@@ -86,6 +379,14 @@ void initializeBehavior() {
   stateEnterMs = lastTick;
   // seed a turning bias to avoid symmetric dithering
   turnBias = (random(2) == 0) ? -1 : 1;
+  recoilPhase = RECOIL_NONE;
+  wallEngaged = false;
+  avoidUntilMs = 0;
+  advancing = false;
+  lastRight = lastLeft = 0;
+  stallReset();
+  trapReset();
+  arbiterInit(layers, (uint8_t)(sizeof(layers) / sizeof(layers[0])), lastTick);
 }
 
 void setBehaviorWanderEnabled(bool enabled) { wanderEnabled = enabled; }
@@ -93,43 +394,70 @@ void setBehaviorWanderEnabled(bool enabled) { wanderEnabled = enabled; }
 void setWallFollowSide(bool right) { followRight = right; }
 void toggleWallFollowSide() { followRight = !followRight; }
 
-void updateBehavior() {
-  if (millis() - lastTick < tickInterval) return;
-  lastTick = millis();
-  // Feed motion watchdog at the cadence of control ticks
-  feedRobotWatchdog();
-  // Keep the Create's OI alive only when connected or not in CONNECTING
-  if (!(currentState == CONNECTING && !oiConnected())) {
-    keepAliveTick();
+static void connectTick(unsigned long now) {
+  // Periodically try to wake/configure the OI with exponential backoff
+  if (now < nextConnectAttemptMs) return;
+  // Compute interval = min(MAX, BASE << retry)
+  unsigned long interval = CONNECT_BASE_MS;
+  if (connectRetry < 14) { // guard shifts
+    interval <<= connectRetry;
   }
-  // Sensor stream is polled in main; cached values are current
+  if (interval > CONNECT_MAX_MS) interval = CONNECT_MAX_MS;
+  // Add +/-20% jitter to avoid phase-locking
+  long jitter = (long)(interval / 5);
+  long delta = (long)random((long)(2 * jitter + 1)) - jitter;
+  nextConnectAttemptMs = now + interval + (unsigned long)((delta < 0) ? 0 - delta : delta);
+  pokeOI();
+  beginSensorStream();
+  if (connectRetry < 20) connectRetry++;
+}
 
-  // Handle asynchronous bumper interrupt: play song, flash LEDs, and recoil
-  if (bumperEventTriggeredAndClear()) {
-    playBumperSong();
-    bumperFlashUntil = millis() + 600; // flash for 0.6s
-    enterState(RECOILING);
+void updateBehavior() {
+  unsigned long now = millis();
+  bool tick = (now - lastTick >= tickInterval);
+  if (tick) {
+    lastTick = now;
+    // Feed motion watchdog at the cadence of control ticks
+    feedRobotWatchdog();
   }
 
-  // Sedate mode: fidget in place only (no forward/back) until midbrain handshake enables wander
-  if (!wanderEnabled) {
-    setLedPattern(PATTERN_WAITING);
-    // Use eased in-place turns for lifelike motion
-    if (random(2) == 0) gentleTurnLeft(); else gentleTurnRight();
-    enterState(SEEKING);
+  if (!oiConnected()) {
+    // Ensure motors are idle while attempting connection; stay in CONNECTING
+    // until the stream becomes active.
+    if (currentState != CONNECTING) {
+      enterState(CONNECTING);
+      arbiterReset();
+      applyDrive(0, 0, now);
+    }
+    setLedPattern(PATTERN_CONNECTING);
+    if (tick) connectTick(now);
     return;
   }
+  if (currentState == CONNECTING) {
+    connectRetry = 0;
+    nextConnectAttemptMs = 0;
+    enterState(WAITING);
+  }
 
-  // (Optional pet-me mode could be added here by counting rapid ISR taps.)
-
-  // Safety preemption: if a hazard is present, force immediate transition
-  if (cliffDetected()) {
-    enterState(FROZEN);
-  } else if (bumperTriggered()) {
-    enterState(RECOILING);
+  // Layers run at their own rates; the highest-priority active proposal drives
+  MotionProposal win;
+  State s = WAITING;
+  int16_t right = 0, left = 0;
+  if (arbiterStep(now, win) != ARBITER_NONE) {
+    right = win.right;
+    left = win.left;
+    s = (State)win.tag;
+  }
+  enterState(s);
+  applyDrive(right, left, now);
+  // Keep the Create's OI alive while stopped (a moving command refreshes
+  // itself); the mode guard runs either way
+  if (tick) {
+    if (right == 0 && left == 0) keepAliveTick();
+    else oiFullGuardTick();
   }
 
-  // Reflect current state on LEDs each tick, with alert override window
+  // Reflect current state on LEDs, with sedate and alert overrides
   switch (currentState) {
     case CONNECTING:     setLedPattern(PATTERN_CONNECTING); break;
     case WAITING:        setLedPattern(PATTERN_WAITING); break;
@@ -141,179 +469,8 @@ void updateBehavior() {
     case TURNING_RIGHT:  setLedPattern(PATTERN_TURNING_RIGHT); break;
     case FROZEN:         setLedPattern(PATTERN_FROZEN); break;
   }
-
-  if (bumperFlashUntil && millis() < bumperFlashUntil) {
+  if (!wanderEnabled && currentState == SEEKING) setLedPattern(PATTERN_WAITING);
+  if (bumperFlashUntil && now < bumperFlashUntil) {
     setLedPattern(PATTERN_ALERT);
   }
-
-  switch (currentState) {
-    case CONNECTING:
-      // Ensure motors are idle while attempting connection
-      stopAllMotors();
-      // If we are already seeing the stream, proceed and reset backoff.
-      if (oiConnected()) {
-        connectRetry = 0;
-        nextConnectAttemptMs = 0;
-        enterState(WAITING);
-        break;
-      }
-      // Periodically try to wake/configure the OI with exponential backoff
-      if (millis() >= nextConnectAttemptMs) {
-        unsigned long now = millis();
-        // Compute interval = min(MAX, BASE << retry)
-        unsigned long interval = CONNECT_BASE_MS;
-        if (connectRetry < 14) { // guard shifts
-          interval <<= connectRetry;
-        }
-        if (interval > CONNECT_MAX_MS) interval = CONNECT_MAX_MS;
-        // Add +/-20% jitter to avoid phase-locking
-        long jitter = (long)(interval / 5);
-        long delta = (long)random((long)(2 * jitter + 1)) - jitter;
-        nextConnectAttemptMs = now + interval + (unsigned long)((delta < 0) ? 0 - delta : delta);
-        // suppressed
-        pokeOI();
-        beginSensorStream();
-        if (connectRetry < 20) connectRetry++;
-      }
-      // stay in CONNECTING until stream becomes active
-      break;
-
-    case WAITING:
-      // Idle: keep motors stopped during brief wait
-      stopAllMotors();
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      delayBriefly();
-      // remain in WAITING
-      break;
-
-    case WALL_FOLLOWING: {
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      // Simple heuristic wall follow using OI 'wall' boolean
-      if (cliffDetected()) { enterState(FROZEN); break; }
-      if (bumperTriggered()) { enterState(RECOILING); break; }
-      if (wallDetected()) {
-        // When on a wall, bias toward it slightly and move forward
-        if (followRight) veerRightOneTick(); else veerLeftOneTick();
-        forwardOneTick();
-      } else {
-        // Search for wall: rotate toward the side we follow
-        if (followRight) turnRightOneTick(); else turnLeftOneTick();
-      }
-      enterState(WALL_FOLLOWING);
-      break;
-    }
-
-    case SEEKING: {
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      int stimulus = scanEnvironment();
-      if (stimulus == 1) {
-        // Forward attractant: begin a run with current bias
-        // Longer runs if we haven't bumped recently
-        unsigned long sinceBump = millis() - lastBumpMs;
-        runTicksTarget = (sinceBump > 5000) ? 10 : 6;
-        // suppressed
-        enterState(ADVANCING);
-      } else if (stimulus == -1) {
-        // suppressed
-        enterState(TURNING_LEFT);
-      } else if (stimulus == 2) {
-        // suppressed
-        enterState(TURNING_RIGHT);
-      } else {
-        // No stimulus: casting — alternating gentle arcs, slightly biased
-        // toward turnBias to create persistence without random walk
-        bool favorRight = (turnBias > 0);
-        // 0-2: favored direction, 3: opposite direction
-        if ((castingPhase % 4) < 3) {
-          if (favorRight) veerRightOneTick(); else veerLeftOneTick();
-        } else {
-          if (favorRight) veerLeftOneTick(); else veerRightOneTick();
-        }
-        castingPhase++;
-        // suppressed
-        // Periodically attempt a short forward tick to probe ahead
-        if ((castingPhase % 5) == 0) {
-          // suppressed
-          forwardOneTick();
-        }
-        // Remain in SEEKING
-        enterState(SEEKING);
-      }
-      break;
-    }
-
-    case ADVANCING:
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      // Check sensors first to avoid driving further into obstacles
-      if (bumperTriggered()) {
-        // Habituation: record bump timing and increase turn magnitude
-        lastBumpMs = millis();
-        if (bumpsRecently < 10) bumpsRecently++;
-        // suppressed
-        enterState(RECOILING);
-      } else if (cliffDetected()) {
-        // suppressed
-        enterState(FROZEN);
-      } else {
-        // Gentle veer in the direction of bias to create a run
-        if (turnBias > 0) veerRightOneTick(); else veerLeftOneTick();
-        runTicksSoFar++;
-        // suppressed
-        if (runTicksSoFar < runTicksTarget) {
-          // continue the run
-          enterState(ADVANCING);
-        } else {
-          // finished a run; brief seek to reassess
-          enterState(SEEKING);
-        }
-      }
-      break;
-
-    case RECOILING:
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      // Back up longer if we've bumped repeatedly (simple habituation)
-      backwardOneTick();
-      if (bumpsRecently >= 3) {
-        backwardOneTick();
-      }
-      // Turn away using bias; if we've been bumping a lot, flip the bias to escape
-      if (bumpsRecently >= 5) {
-        turnBias = -turnBias; // escape trap
-        bumpsRecently = 0;    // reset after decisive change
-        Serial.println("[FSM] RECOIL flipping bias to escape");
-      }
-      if (turnBias > 0) {
-        turnRightOneTick();
-        if (bumpsRecently >= 2) turnRightOneTick();
-      } else {
-        turnLeftOneTick();
-        if (bumpsRecently >= 2) turnLeftOneTick();
-      }
-      // Start a shorter forward run after recoil to test the new heading
-      runTicksTarget = 4;
-      enterState(WALL_FOLLOWING);
-      break;
-
-    case TURNING_LEFT:
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      turnLeftOneTick();
-      turnBias = -1;            // reinforce left bias after explicit turn
-      runTicksTarget = 6;       // set a medium run to capitalize on turn
-      enterState(ADVANCING);
-      break;
-
-    case TURNING_RIGHT:
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      turnRightOneTick();
-      turnBias = 1;             // reinforce right bias after explicit turn
-      runTicksTarget = 6;
-      enterState(ADVANCING);
-      break;
-
-    case FROZEN:
-      if (!oiConnected()) { enterState(CONNECTING); break; }
-      stopAllMotors();
-      alertFreeze();
-      break;
-  }
 }
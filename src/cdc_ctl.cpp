@@ -0,0 +1,105 @@
+#include "cdc_ctl.h"
+
+#if DUAL_CDC
+
+#if defined(ARDUINO) && defined(USBCON)
+
+// Same layout as the core's CDC interface (CDCDescriptor in USBCore.h),
+// numbered from the interfaces/endpoints PluggableUSB hands us.
+#define CTL_ACM_INTERFACE   pluggedInterface
+#define CTL_DATA_INTERFACE  (uint8_t)(pluggedInterface + 1)
+#define CTL_ENDPOINT_ACM    pluggedEndpoint
+#define CTL_ENDPOINT_OUT    (uint8_t)(pluggedEndpoint + 1)
+#define CTL_ENDPOINT_IN     (uint8_t)(pluggedEndpoint + 2)
+
+CdcCtl SerialCtl;
+
+CdcCtl::CdcCtl() : PluggableUSBModule(3, 2, epType) {
+  epType[0] = EP_TYPE_INTERRUPT_IN;
+  epType[1] = EP_TYPE_BULK_OUT;
+  epType[2] = EP_TYPE_BULK_IN;
+  // 115200 8N1; the port ignores it, but hosts expect to read it back
+  const uint8_t coding[7] = { 0x00, 0xC2, 0x01, 0x00, 0, 0, 8 };
+  memcpy(lineCoding, coding, sizeof(lineCoding));
+  PluggableUSB().plug(this);
+}
+
+int CdcCtl::getInterface(uint8_t* interfaceCount) {
+  *interfaceCount += 2;
+  CDCDescriptor desc = {
+    D_IAD(CTL_ACM_INTERFACE, 2, CDC_COMMUNICATION_INTERFACE_CLASS, CDC_ABSTRACT_CONTROL_MODEL, 1),
+    D_INTERFACE(CTL_ACM_INTERFACE, 1, CDC_COMMUNICATION_INTERFACE_CLASS, CDC_ABSTRACT_CONTROL_MODEL, 0),
+    D_CDCCS(CDC_HEADER, 0x10, 0x01),
+    D_CDCCS(CDC_CALL_MANAGEMENT, 1, 1),
+    D_CDCCS4(CDC_ABSTRACT_CONTROL_MANAGEMENT, 6),
+    D_CDCCS(CDC_UNION, CTL_ACM_INTERFACE, CTL_DATA_INTERFACE),
+    D_ENDPOINT(USB_ENDPOINT_IN(CTL_ENDPOINT_ACM), USB_ENDPOINT_TYPE_INTERRUPT, 0x10, 0x40),
+    D_INTERFACE(CTL_DATA_INTERFACE, 2, CDC_DATA_INTERFACE_CLASS, 0, 0),
+    D_ENDPOINT(USB_ENDPOINT_OUT(CTL_ENDPOINT_OUT), USB_ENDPOINT_TYPE_BULK, USB_EP_SIZE, 0),
+    D_ENDPOINT(USB_ENDPOINT_IN(CTL_ENDPOINT_IN), USB_ENDPOINT_TYPE_BULK, USB_EP_SIZE, 0)
+  };
+  return USB_SendControl(0, &desc, sizeof(desc));
+}
+
+int CdcCtl::getDescriptor(USBSetup&) { return 0; }
+
+bool CdcCtl::setup(USBSetup& setup) {
+  if (setup.wIndex != CTL_ACM_INTERFACE) return false;
+  uint8_t r = setup.bRequest;
+  if (setup.bmRequestType == REQUEST_DEVICETOHOST_CLASS_INTERFACE && r == CDC_GET_LINE_CODING) {
+    USB_SendControl(0, lineCoding, sizeof(lineCoding));
+    return true;
+  }
+  if (setup.bmRequestType == REQUEST_HOSTTODEVICE_CLASS_INTERFACE) {
+    if (r == CDC_SET_LINE_CODING) USB_RecvControl(lineCoding, sizeof(lineCoding));
+    else if (r == CDC_SET_CONTROL_LINE_STATE) lineState = setup.wValueL;
+    // No 1200-baud bootloader touch here: that stays on the bridge port
+    return true;
+  }
+  return false;
+}
+
+uint8_t CdcCtl::getShortName(char* name) {
+  memcpy(name, "CTL", 3);
+  return 3;
+}
+
+int CdcCtl::available() {
+  return (peeked >= 0 ? 1 : 0) + USB_Available(CTL_ENDPOINT_OUT);
+}
+
+int CdcCtl::peek() {
+  if (peeked < 0 && USB_Available(CTL_ENDPOINT_OUT)) peeked = USB_Recv(CTL_ENDPOINT_OUT);
+  return peeked;
+}
+
+int CdcCtl::read() {
+  if (peeked >= 0) {
+    int c = peeked;
+    peeked = -1;
+    return c;
+  }
+  return USB_Available(CTL_ENDPOINT_OUT) ? USB_Recv(CTL_ENDPOINT_OUT) : -1;
+}
+
+int CdcCtl::availableForWrite() { return USB_SendSpace(CTL_ENDPOINT_IN); }
+
+void CdcCtl::flush() { USB_Flush(CTL_ENDPOINT_IN); }
+
+size_t CdcCtl::write(uint8_t b) { return write(&b, 1); }
+
+size_t CdcCtl::write(const uint8_t* buf, size_t len) {
+  // Like the core CDC: nothing is queued while no program holds the port,
+  // so a closed control port never stalls the loop.
+  if (!dtr()) return 0;
+  int r = USB_Send(CTL_ENDPOINT_IN, buf, len);
+  return r > 0 ? (size_t)r : 0;
+}
+
+#else
+
+USBSerial SerialCtl;
+
+#endif
+
+#endif  // DUAL_CDC
@@ -0,0 +1,416 @@
+#include "control.h"
+#include "cdc_ctl.h"
+#include "energy.h"
+#include "estop.h"
+#include "fdr.h"
+#include "governor.h"
+#include "mode.h"
+#include "passthrough.h"
+#include "prof.h"
+#include "proto.h"
+#include "numfmt.h"
+#include "sensors.h"
+#include "stall.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "traj.h"
+#include "trap.h"
+#include "twist.h"
+#include "tx.h"
+#include "usblink.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Managed-mode line buffer (proto.h lines straight from the host)
+static char lineBuf[64];
+static uint8_t lineLen = 0;
+static bool lineOverflow = false;
+// tbTicks() when the current line's terminator arrived (latency reference)
+static uint32_t lineTicks = 0;
+
+// ,"<key>":[bucket counts],"<key>_max_us":<n>
+static void printDwell(const char* key, const DwellQueue &q) {
+  CONTROL_SERIAL.print(",\"");
+  CONTROL_SERIAL.print(key);
+  CONTROL_SERIAL.print("\":[");
+  for (uint8_t i = 0; i < DWELL_BUCKETS; ++i) {
+    if (i) CONTROL_SERIAL.print(",");
+    CONTROL_SERIAL.print((unsigned long)q.hist[i]);
+  }
+  CONTROL_SERIAL.print("],\"");
+  CONTROL_SERIAL.print(key);
+  CONTROL_SERIAL.print("_max_us\":");
+  CONTROL_SERIAL.print((unsigned long)q.maxUs);
+}
+
+static void printFixed(const char* key, int32_t scaled, uint8_t decimals) {
+  char buf[NUMFMT_MAX_LEN];
+  uint8_t n = fmtFixed(buf, scaled, decimals);
+  CONTROL_SERIAL.print(",\"");
+  CONTROL_SERIAL.print(key);
+  CONTROL_SERIAL.print("\":");
+  CONTROL_SERIAL.write((const uint8_t*)buf, n);
+}
+
+// Energy one-liner: STATS:{"energy":{"<account>":[mJ,ms,mm],...},...}
+static void printStats() {
+  CONTROL_SERIAL.print("STATS:{\"energy\":{");
+  for (uint8_t i = 0; i < ENERGY_ACCOUNTS; ++i) {
+    EnergyTotals t;
+    energyTotals(i, t);
+    if (i) CONTROL_SERIAL.print(",");
+    CONTROL_SERIAL.print("\"");
+    CONTROL_SERIAL.print(energyAccountName(i));
+    CONTROL_SERIAL.print("\":[");
+    CONTROL_SERIAL.print((unsigned long)t.mJ);
+    CONTROL_SERIAL.print(",");
+    CONTROL_SERIAL.print((unsigned long)t.ms);
+    CONTROL_SERIAL.print(",");
+    CONTROL_SERIAL.print((unsigned long)t.mm);
+    CONTROL_SERIAL.print("]");
+  }
+  CONTROL_SERIAL.print("},\"mj_per_m\":");
+  CONTROL_SERIAL.print((unsigned long)energyMilliJoulesPerMetre());
+  CONTROL_SERIAL.print(",\"idle_mw\":");
+  CONTROL_SERIAL.print((unsigned long)energyIdleMilliWatts());
+  CONTROL_SERIAL.println("}");
+}
+
+// Status one-liner: STATUS:{...}
+static void printStatus() {
+  CONTROL_SERIAL.print("STATUS:{\"state\":\"");
+  CONTROL_SERIAL.print(passthroughActive() ? "BRIDGE" : "MANAGED");
+  CONTROL_SERIAL.print("\",\"fdr_frozen\":");
+  CONTROL_SERIAL.print(fdrFrozen() ? "1" : "0");
+  CONTROL_SERIAL.print(",\"fdr_mask\":");
+  CONTROL_SERIAL.print((unsigned long)fdrTriggerMask());
+  CONTROL_SERIAL.print(",\"estop\":");
+  CONTROL_SERIAL.print((unsigned long)estopSources());
+  CONTROL_SERIAL.print(",\"estop_lat_us\":");
+  CONTROL_SERIAL.print((unsigned long)estopLastLatencyUs());
+  CONTROL_SERIAL.print(",\"estop_max_us\":");
+  CONTROL_SERIAL.print((unsigned long)estopMaxLatencyUs());
+  CONTROL_SERIAL.print(",\"mode\":\"");
+  CONTROL_SERIAL.print(modePaused() ? PROTO_STATE_PAUSED : modeName(modeCurrent()));
+  CONTROL_SERIAL.print("\",\"mode_lat_us\":");
+  CONTROL_SERIAL.print((unsigned long)modeLastSwitchUs());
+  CONTROL_SERIAL.print(",\"mode_max_us\":");
+  CONTROL_SERIAL.print((unsigned long)modeMaxSwitchUs());
+  CONTROL_SERIAL.print(",\"link\":");
+  CONTROL_SERIAL.print(usbLinkPresent() ? "1" : "0");
+  CONTROL_SERIAL.print(",\"link_seq\":");
+  CONTROL_SERIAL.print((unsigned long)usbLinkTransitions());
+  CONTROL_SERIAL.print(",\"h2r\":");
+  CONTROL_SERIAL.print((unsigned long)passthroughBytesToRobot());
+  CONTROL_SERIAL.print(",\"r2h\":");
+  CONTROL_SERIAL.print((unsigned long)passthroughBytesToHost());
+  CONTROL_SERIAL.print(",\"h2r_stall\":");
+  CONTROL_SERIAL.print((unsigned long)passthroughStalls());
+  CONTROL_SERIAL.print(",\"coalesced\":");
+  CONTROL_SERIAL.print((unsigned long)passthroughCoalesced());
+  CONTROL_SERIAL.print(",\"traj_depth\":");
+  CONTROL_SERIAL.print((unsigned long)trajDepth());
+  CONTROL_SERIAL.print(",\"traj_underruns\":");
+  CONTROL_SERIAL.print((unsigned long)trajUnderruns());
+  CONTROL_SERIAL.print(",\"traj_late\":");
+  CONTROL_SERIAL.print((unsigned long)trajLate());
+  CONTROL_SERIAL.print(",\"twist_jitter_ms\":");
+  CONTROL_SERIAL.print((unsigned long)twistJitterMs());
+  CONTROL_SERIAL.print(",\"twist_delay_ms\":");
+  CONTROL_SERIAL.print((unsigned long)twistDelayMs());
+  CONTROL_SERIAL.print(",\"twist_stale\":");
+  CONTROL_SERIAL.print((unsigned long)twistStaleCount());
+  CONTROL_SERIAL.print(",\"twist_dropped\":");
+  CONTROL_SERIAL.print((unsigned long)twistDropped());
+  CONTROL_SERIAL.print(",\"stuck\":");
+  CONTROL_SERIAL.print((unsigned long)stallEvents());
+  CONTROL_SERIAL.print(",\"trap_episodes\":");
+  CONTROL_SERIAL.print((unsigned long)trapEpisodes());
+  CONTROL_SERIAL.print(",\"trap_last_ms\":");
+  CONTROL_SERIAL.print((unsigned long)trapLastEscapeMs());
+  CONTROL_SERIAL.print(",\"trap_max_ms\":");
+  CONTROL_SERIAL.print((unsigned long)trapMaxEscapeMs());
+  CONTROL_SERIAL.print(",\"bat_pct\":");
+  CONTROL_SERIAL.print((unsigned long)batteryPercent());
+  CONTROL_SERIAL.print(",\"gov_level\":");
+  CONTROL_SERIAL.print((unsigned long)governorLevel());
+  CONTROL_SERIAL.print(",\"runtime_min\":");
+  CONTROL_SERIAL.print((unsigned long)governorRuntimeMin());
+  float x, y;
+  int32_t travelMm, turnDeg;
+  sensorsPose(x, y, travelMm, turnDeg);
+  printFixed("odom_m", travelMm, 3);
+  printDwell("h2r_dwell", passthroughDwellToRobot());
+  printDwell("r2h_dwell", passthroughDwellToHost());
+  // Loop times since the previous STATUS
+  uint32_t loopAvg, loopMax;
+  modeLoopStats(loopAvg, loopMax);
+  CONTROL_SERIAL.print(",\"loop_us\":");
+  CONTROL_SERIAL.print((unsigned long)loopAvg);
+  CONTROL_SERIAL.print(",\"loop_max_us\":");
+  CONTROL_SERIAL.print((unsigned long)loopMax);
+  CONTROL_SERIAL.println("}");
+}
+
+// Bridge-mode (!cmd) replies go straight to USB as one line
+static void bridgeAck(const char* key, unsigned long value) {
+  CONTROL_SERIAL.print("ACK,");
+  CONTROL_SERIAL.print(key);
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.println(value);
+}
+
+static void managedAck(const char* key, const char* value) {
+  txBegin("ACK");
+  txStr(key);
+  txStr(value);
+  txEndLine();
+}
+
+static void managedErr(const char* kind, const char* what) {
+  txBegin("ERR");
+  txStr(kind);
+  txStr(what);
+  txEndLine();
+}
+
+// TRAJ,<t_ms>,<right_mm_s>,<left_mm_s> | TRAJV,<t_ms>,<vx_mps>,<wz_radps> | TRAJ,clear
+static void handleTraj(const char* line, bool twist) {
+  const char* p = line + (twist ? 6 : 5);
+  if (!twist && strcmp(p, "clear") == 0) {
+    trajClear();
+    managedAck("traj", "clear");
+    return;
+  }
+  if (modeCurrent() != MODE_FOREBRAIN || modePaused()) {
+    managedErr("cmd", twist ? "TRAJV" : "TRAJ");
+    return;
+  }
+  char* end;
+  uint32_t t = strtoul(p, &end, 10);
+  if (end == p || *end != ',') { managedErr("parse", "traj"); return; }
+  bool ok;
+  if (twist) {
+    float vx = (float)strtod(end + 1, &end);
+    if (*end != ',') { managedErr("parse", "traj"); return; }
+    float wz = (float)strtod(end + 1, &end);
+    if (*end != '\0') { managedErr("parse", "traj"); return; }
+    ok = trajPushTwist(t, vx, wz);
+  } else {
+    long right = strtol(end + 1, &end, 10);
+    if (*end != ',') { managedErr("parse", "traj"); return; }
+    long left = strtol(end + 1, &end, 10);
+    if (*end != '\0') { managedErr("parse", "traj"); return; }
+    // Clamp while still long: a cast first would wrap 70000 to a small speed
+    if (right > TRAJ_MAX_MM_S) right = TRAJ_MAX_MM_S;
+    if (right < -TRAJ_MAX_MM_S) right = -TRAJ_MAX_MM_S;
+    if (left > TRAJ_MAX_MM_S) left = TRAJ_MAX_MM_S;
+    if (left < -TRAJ_MAX_MM_S) left = -TRAJ_MAX_MM_S;
+    ok = trajPush(t, (int16_t)right, (int16_t)left);
+  }
+  // A trajectory takes over from teleop
+  if (ok) twistClear();
+  // Full, or not after the last queued point
+  if (!ok) managedErr("param", "traj");
+}
+
+// TWIST,<vx_mps>,<wz_radps>,<seq>; late or duplicate seq is dropped silently
+static void handleTwist(const char* line) {
+  if (modeCurrent() != MODE_FOREBRAIN || modePaused()) {
+    managedErr("cmd", "TWIST");
+    return;
+  }
+  const char* p = line + 6;
+  char* end;
+  float vx = (float)strtod(p, &end);
+  if (end == p || *end != ',') { managedErr("parse", "twist"); return; }
+  p = end + 1;
+  float wz = (float)strtod(p, &end);
+  if (end == p || *end != ',') { managedErr("parse", "twist"); return; }
+  p = end + 1;
+  uint32_t seq = strtoul(p, &end, 10);
+  if (end == p || *end != '\0') { managedErr("parse", "twist"); return; }
+  trajClear();
+  twistPush(vx, wz, seq, tbMillis());
+}
+
+// SET,<key>,<value> for numeric tunables; ACK echoes the value
+static void handleSet(const char* line) {
+  const char* key = line + 4;
+  const char* comma = strchr(key, ',');
+  if (!comma) { managedErr("parse", "set"); return; }
+  char name[20];
+  size_t n = (size_t)(comma - key);
+  if (n >= sizeof(name)) n = sizeof(name) - 1;
+  memcpy(name, key, n);
+  name[n] = '\0';
+  char* end;
+  unsigned long v = strtoul(comma + 1, &end, 10);
+  bool ok = end != comma + 1 && *end == '\0' && v <= 0xFFFF;
+  if (ok) {
+    if (strcmp(name, PROTO_K_TWIST_PERIOD) == 0) ok = twistSetPeriodMs((uint16_t)v);
+    else if (strcmp(name, PROTO_K_TWIST_HOLD) == 0) ok = twistSetHoldPct((uint16_t)v);
+    else if (strcmp(name, PROTO_K_WATCHDOG) == 0) ok = twistSetDeadlineMs((uint16_t)v);
+    else if (strcmp(name, PROTO_K_GOV_FULL) == 0) ok = governorSetFullPct((uint16_t)v);
+    else if (strcmp(name, PROTO_K_GOV_FLOOR) == 0) ok = governorSetFloorPct((uint16_t)v);
+    else if (strcmp(name, PROTO_K_GOV_MIN) == 0) ok = governorSetMinLevel((uint16_t)v);
+    else if (strcmp(name, PROTO_K_TASK_BUDGET) == 0) ok = governorSetBudgetMin((uint16_t)v, tbMillis());
+    else if (strcmp(name, PROTO_K_ODOM_HZ) == 0) ok = telemetrySetOdomHz((uint16_t)v);
+    else ok = false;
+  }
+  if (!ok) { managedErr("param", name); return; }
+  managedAck(name, comma + 1);
+}
+
+// Escaped diagnostics: "!<cmd>[,args]"
+static void handleBang(const char* line) {
+  if (strcmp(line, "!status") == 0) {
+    printStatus();
+  } else if (strcmp(line, "!fdr") == 0) {
+    fdrDump();
+  } else if (strcmp(line, "!fdr_arm") == 0) {
+    fdrArm();
+    bridgeAck("fdr_arm", 1);
+  } else if (strcmp(line, "!fdr_freeze") == 0) {
+    fdrTrigger(FDR_TRIG_HOST);
+    bridgeAck("fdr_freeze", 1);
+  } else if (strncmp(line, "!fdr_mask,", 10) == 0) {
+    fdrSetTriggerMask((uint8_t)strtoul(line + 10, nullptr, 0));
+    bridgeAck("fdr_mask", fdrTriggerMask());
+  } else if (strcmp(line, "!prof_start") == 0 || strncmp(line, "!prof_start,", 12) == 0) {
+    uint16_t hz = line[11] == ',' ? (uint16_t)strtoul(line + 12, nullptr, 10) : 997;
+    if (profStart(hz)) bridgeAck("prof", 1);
+    else CONTROL_SERIAL.println("ERR:prof not built (-DENABLE_PROF)");
+  } else if (strcmp(line, "!prof_stop") == 0) {
+    profStop();
+    bridgeAck("prof", 0);
+  } else if (strcmp(line, "!prof") == 0) {
+    profDump();
+  } else if (strcmp(line, "!estop") == 0) {
+    estopSet(ESTOP_SRC_HOST);
+    bridgeAck("estop", estopLastLatencyUs());
+  } else if (strncmp(line, "!coalesce,", 10) == 0) {
+    passthroughSetCoalesce(line[10] == '1');
+    bridgeAck("coalesce", passthroughCoalesce() ? 1 : 0);
+  } else if (strcmp(line, "!stats") == 0) {
+    printStats();
+  } else if (strcmp(line, "!energy_reset") == 0) {
+    energyReset();
+    bridgeAck("energy_reset", 1);
+  } else if (strcmp(line, "!dwell_reset") == 0) {
+    passthroughDwellClear();
+    bridgeAck("dwell_reset", 1);
+  } else if (strcmp(line, "!safe") == 0) {
+    estopClear();
+    bridgeAck("estop", 0);
+  } else {
+    CONTROL_SERIAL.print("ERR:unknown ");
+    CONTROL_SERIAL.println(line);
+  }
+}
+
+void controlHandleLine(const char* line) {
+  if (line[0] == '!') {
+    handleBang(line);
+    return;
+  }
+  uint32_t cmdTicks = lineTicks ? lineTicks : tbTicks();
+  lineTicks = 0;
+  if (strncmp(line, "SAFE,", 5) == 0) {
+    // SAFE,0 latches ESTOP; SAFE,1 clears it. ESTOP,<0|1>,<seq> follows only
+    // when the latch changes (nothing for SAFE,1 while clear).
+    if (line[5] == '0') estopSet(ESTOP_SRC_HOST, cmdTicks);
+    else if (line[5] == '1') estopClear();
+    else managedErr("param", "safe");
+    return;
+  }
+  // Mode switches answer with STATE,<name>
+  if (strcmp(line, "PAUSE") == 0) { modePause(); return; }
+  if (strcmp(line, "RESUME") == 0) { modeResume(); return; }
+  if (strcmp(line, "PASS") == 0) { modeSet(MODE_PASSTHROUGH, cmdTicks); return; }
+  if (strncmp(line, "SET," PROTO_K_MODE ",", 9) == 0) {
+    RunMode m;
+    if (!modeFromName(line + 9, m)) { managedErr("param", PROTO_K_MODE); return; }
+    modeSet(m, cmdTicks);
+    managedAck(PROTO_K_MODE, modeName(m));
+    return;
+  }
+  if (strncmp(line, "TRAJ,", 5) == 0 || strncmp(line, "TRAJV,", 6) == 0) {
+    handleTraj(line, line[4] == 'V');
+    return;
+  }
+  if (strncmp(line, "TWIST,", 6) == 0) {
+    handleTwist(line);
+    return;
+  }
+  if (strncmp(line, "SET,", 4) == 0) {
+    handleSet(line);
+    return;
+  }
+  if (strncmp(line, "REPLAY,", 7) == 0) {
+    // REPLAY,<since_eid>: resend what the TX ring still holds after it
+    char* end;
+    unsigned long since = strtoul(line + 7, &end, 10);
+    if (end == line + 7 || *end != '\0') { managedErr("parse", "replay"); return; }
+    uint32_t first = txReplay(since);
+    if (since < txLastEid() && (first == 0 || first > since + 1)) {
+      // Some were overwritten already: only a keyframe repairs the snapshot
+      managedErr("evt", "missing");
+      telemetryForceKeyframe();
+    }
+    return;
+  }
+  if (strcmp(line, "STATS") == 0) {
+    printStats();
+    return;
+  }
+  if (strncmp(line, "PING,", 5) == 0) {
+    // PONG,<seq> echoes the host's sequence number for round-trip timing
+    char* end;
+    unsigned long seq = strtoul(line + 5, &end, 10);
+    if (end == line + 5 || *end != '\0') { managedErr("parse", "ping"); return; }
+    txBegin("PONG");
+    txU32(seq);
+    txEndLine();
+    return;
+  }
+  if (strcmp(line, "GET,time") == 0) {
+    // TIME,<ms> on the clock trajectory points are stamped with
+    txBegin("TIME");
+    txU32(tbMillis());
+    txEndLine();
+    return;
+  }
+  const char* comma = strchr(line, ',');
+  char verb[12];
+  size_t n = comma ? (size_t)(comma - line) : strlen(line);
+  if (n >= sizeof(verb)) n = sizeof(verb) - 1;
+  memcpy(verb, line, n);
+  verb[n] = '\0';
+  managedErr("cmd", verb);
+}
+
+void controlPoll() {
+  // Shared port: stop at PASS, the rest of the input belongs to the bridge.
+  // With DUAL_CDC control has its own port and is read in every mode.
+  while ((DUAL_CDC || !passthroughActive()) && CONTROL_SERIAL.available() > 0) {
+    int c = CONTROL_SERIAL.read();
+    if (c < 0) break;
+    if (c == '\n' || c == '\r') {
+      if (lineOverflow) {
+        managedErr("parse", "overflow");
+      } else if (lineLen > 0) {
+        lineBuf[lineLen] = '\0';
+        lineTicks = tbTicks();
+        controlHandleLine(lineBuf);
+      }
+      lineLen = 0;
+      lineOverflow = false;
+    } else if ((unsigned)lineLen + 1 < sizeof(lineBuf)) {
+      lineBuf[lineLen++] = (char)c;
+    } else {
+      lineOverflow = true;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#include "dwell.h"
+#include "timebase.h"
+
+void dwellRestart(DwellQueue &q) {
+  q.head = 0;
+  q.marks = 0;
+  q.unread = 0;
+  q.lastLook = 0;
+}
+
+void dwellClear(DwellQueue &q) {
+  for (uint8_t i = 0; i < DWELL_BUCKETS; ++i) q.hist[i] = 0;
+  q.maxUs = 0;
+}
+
+uint8_t dwellBucket(uint32_t us) {
+  uint8_t b = 0;
+  us >>= 4;
+  while (us && b + 1 < DWELL_BUCKETS) {
+    us >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void dwellSeen(DwellQueue &q, uint16_t avail, uint32_t nowTicks) {
+  uint32_t since = q.lastLook ? q.lastLook : nowTicks;
+  q.lastLook = nowTicks;
+  if (avail <= q.unread) return;
+  uint16_t fresh = avail - q.unread;
+  q.unread = avail;
+  if (q.marks == DWELL_MARKS) {
+    // Out of marks: fold into the newest batch (its stamp is older, so this
+    // errs towards longer dwell)
+    q.markBytes[(q.head + q.marks - 1) % DWELL_MARKS] += fresh;
+    return;
+  }
+  uint8_t i = (q.head + q.marks) % DWELL_MARKS;
+  q.markTicks[i] = since;
+  q.markBytes[i] = fresh;
+  q.marks++;
+}
+
+void dwellRead(DwellQueue &q, uint16_t n) { q.unread = n < q.unread ? q.unread - n : 0; }
+
+// Take n bytes off the oldest marks; sample them when nowTicks is given
+static void take(DwellQueue &q, uint16_t n, bool sample, uint32_t nowTicks) {
+  while (n > 0 && q.marks > 0) {
+    uint16_t k = n < q.markBytes[q.head] ? n : q.markBytes[q.head];
+    if (sample) {
+      uint32_t us = tbTicksToUs(nowTicks - q.markTicks[q.head]);
+      uint16_t &c = q.hist[dwellBucket(us)];
+      c = (uint32_t)c + k > 0xFFFF ? 0xFFFF : c + k;
+      if (us > q.maxUs) q.maxUs = us;
+    }
+    q.markBytes[q.head] -= k;
+    n -= k;
+    if (q.markBytes[q.head] == 0) {
+      q.head = (q.head + 1) % DWELL_MARKS;
+      q.marks--;
+    }
+  }
+}
+
+void dwellOut(DwellQueue &q, uint16_t n, uint32_t nowTicks) { take(q, n, true, nowTicks); }
+
+void dwellDrop(DwellQueue &q, uint16_t n) { take(q, n, false, 0); }
@@ -0,0 +1,102 @@
+#include "energy.h"
+#include "motion.h"
+#include <Arduino.h>
+
+struct Account {
+  uint32_t mJ;
+  uint16_t uJ; // remainder below 1 mJ
+  uint32_t ms;
+  uint32_t mm;
+};
+
+static Account accounts[ENERGY_ACCOUNTS];
+static uint8_t activity = ENERGY_IDLE;
+static unsigned long cueUntil = 0;
+static unsigned long lastSampleMs = 0;
+static uint8_t current = ENERGY_IDLE; // account of the latest sample
+
+static const char* const NAMES[ENERGY_ACCOUNTS] = {
+  "idle", "host", "seek", "advance", "wall", "recoil", "turn", "cue",
+};
+
+void energyReset() {
+  for (uint8_t i = 0; i < ENERGY_ACCOUNTS; ++i) accounts[i] = Account{0, 0, 0, 0};
+  lastSampleMs = 0;
+  cueUntil = 0;
+}
+
+void energySetActivity(uint8_t account) {
+  if (account < ENERGY_ACCOUNTS) activity = account;
+}
+
+void energyCue(uint16_t ms) { cueUntil = millis() + ms; }
+
+static bool cuePlaying(unsigned long nowMs) {
+  return cueUntil && (long)(nowMs - cueUntil) < 0;
+}
+
+// Motion account of the sample; a cue over stopped wheels takes it whole
+static uint8_t attribute(unsigned long nowMs) {
+  int16_t right, left;
+  motionLastSent(right, left);
+  if (right == 0 && left == 0) return cuePlaying(nowMs) ? ENERGY_CUE : ENERGY_IDLE;
+  if (motionOwner() != MOTION_OWNER_BEHAVIOR) return ENERGY_HOST;
+  return activity;
+}
+
+static void addEnergy(Account &a, uint32_t uJ) {
+  uJ += a.uJ;
+  a.mJ += uJ / 1000;
+  a.uJ = (uint16_t)(uJ % 1000);
+}
+
+void energySample(uint16_t mV, int16_t mA, unsigned long nowMs) {
+  unsigned long dt = lastSampleMs ? nowMs - lastSampleMs : 0;
+  lastSampleMs = nowMs;
+  current = attribute(nowMs);
+  if (dt == 0 || dt > ENERGY_MAX_GAP_MS) return;
+  Account &a = accounts[current];
+  bool split = current != ENERGY_CUE && cuePlaying(nowMs);
+  uint32_t base = a.ms ? (uint32_t)((uint64_t)a.mJ * 1000 / a.ms) : 0;
+  a.ms += dt;
+  if (split) accounts[ENERGY_CUE].ms += dt;
+  if (mA >= 0) return; // charging or no draw
+  // mV x mA / 1000 = mW; mW x ms = uJ (< 2^32 for any gap we accept)
+  uint32_t mW = (uint32_t)mV * (uint32_t)(-(int32_t)mA) / 1000;
+  if (split && base && mW > base) {
+    // A cue while driving: the motion account keeps its usual draw and the
+    // distance, the cue only gets the increment
+    addEnergy(accounts[ENERGY_CUE], (mW - base) * dt);
+    mW = base;
+  }
+  addEnergy(a, mW * dt);
+}
+
+void energyDistance(int16_t mm) {
+  accounts[current].mm += (uint32_t)(mm < 0 ? -mm : mm);
+}
+
+const char* energyAccountName(uint8_t account) {
+  return account < ENERGY_ACCOUNTS ? NAMES[account] : "?";
+}
+
+void energyTotals(uint8_t account, EnergyTotals &out) {
+  const Account &a = accounts[account < ENERGY_ACCOUNTS ? account : (uint8_t)ENERGY_IDLE];
+  out.mJ = a.mJ;
+  out.ms = a.ms;
+  out.mm = a.mm;
+}
+
+uint32_t energyMilliJoulesPerMetre() {
+  uint32_t mJ = 0, mm = 0;
+  for (uint8_t i = ENERGY_HOST; i < ENERGY_CUE; ++i) {
+    mJ += accounts[i].mJ;
+    mm += accounts[i].mm;
+  }
+  return mm ? (uint32_t)((uint64_t)mJ * 1000 / mm) : 0;
+}
+
+uint32_t energyIdleMilliWatts() {
+  const Account &a = accounts[ENERGY_IDLE];
+  return a.ms ? (uint32_t)((uint64_t)a.mJ * 1000 / a.ms) : 0;
+}
@@ -0,0 +1,85 @@
+#include "estop.h"
+#include "fdr.h"
+#include "leds.h"
+#include "passthrough.h"
+#include "sensors.h"
+#include "timebase.h"
+#include "tx.h"
+#include "utils.h"
+#include <Arduino.h>
+
+#ifndef CREATE_SERIAL
+#define CREATE_SERIAL Serial1
+#endif
+
+static const uint8_t OI_DRIVE_DIRECT = 145;
+// Re-send the stop while latched in case the OI dropped a frame
+static const unsigned long ESTOP_REASSERT_MS = 100;
+
+static uint8_t sources = 0;
+static unsigned long lastAssertMs = 0;
+static uint32_t lastLatencyUs = 0;
+static uint32_t maxLatencyUs = 0;
+static uint16_t setCount = 0;
+
+// The dedicated stop path: one frame straight to the UART, then wait until
+// it (and anything queued ahead of it) has been shifted out.
+static void writeStopFrame() {
+  const uint8_t stop[] = { OI_DRIVE_DIRECT, 0, 0, 0, 0 };
+  CREATE_SERIAL.write(stop, sizeof(stop));
+  CREATE_SERIAL.flush();
+}
+
+static void reportEstop(bool active) {
+  // ESTOP,<0|1>,<seq>
+  txBegin("ESTOP");
+  txU32(active ? 1 : 0);
+  txU32(setCount);
+  txEndLine();
+}
+
+void estopSet(uint8_t source, uint32_t cmdTicks) {
+  if (cmdTicks == 0) cmdTicks = tbTicks();
+  // A half-sent bridged command would swallow the stop (and the alarm song)
+  // as its data bytes
+  passthroughFinishCommand();
+  writeStopFrame();
+  uint32_t lat = tbTicksToUs(tbTicks() - cmdTicks);
+  lastLatencyUs = lat;
+  if (lat > maxLatencyUs) maxLatencyUs = lat;
+  lastAssertMs = millis();
+  bool wasActive = (sources != 0);
+  sources |= source;
+  if (wasActive) return;
+  setCount++;
+  fdrTrigger(FDR_TRIG_ESTOP);
+  setLedPattern(PATTERN_ALERT);
+  playEstopAlarmSad();
+  reportEstop(true);
+}
+
+bool estopClear() {
+  if (!sources) return false;
+  sources = 0;
+  reportEstop(false);
+  return true;
+}
+
+bool estopActive() { return sources != 0; }
+uint8_t estopSources() { return sources; }
+
+void estopTick() {
+  if (playButtonPressedAndClear()) estopSet(ESTOP_SRC_BUTTON);
+  if (!sources) return;
+  unsigned long now = millis();
+  // Re-assert between bridged commands only; a command the host is still
+  // sending (anything but motion) is let through whole
+  if (now - lastAssertMs >= ESTOP_REASSERT_MS && !passthroughMidCommand()) {
+    writeStopFrame();
+    lastAssertMs = now;
+  }
+}
+
+uint32_t estopLastLatencyUs() { return lastLatencyUs; }
+uint32_t estopMaxLatencyUs() { return maxLatencyUs; }
+uint16_t estopCount() { return setCount; }
@@ -0,0 +1,95 @@
+#include "fdr.h"
+#include "cdc_ctl.h"
+#include <Arduino.h>
+
+// One record: low 16 bits of millis(), kind, a, b, c. The host unwraps the
+// timestamps backwards from the now_ms given in the dump header.
+struct FdrRecord {
+  uint16_t ms;
+  uint8_t kind;
+  uint8_t a;
+  int16_t b;
+  int16_t c;
+};
+
+static FdrRecord ring[FDR_RECORDS];
+static uint8_t head = 0;   // next slot to write
+static uint8_t count = 0;  // valid records (<= FDR_RECORDS)
+static bool frozen = false;
+static uint8_t frozenBy = 0;
+static uint8_t triggerMask = FDR_TRIG_CLIFF | FDR_TRIG_ESTOP | FDR_TRIG_WATCHDOG | FDR_TRIG_BUMPS | FDR_TRIG_HOST;
+
+void fdrInit() {
+  head = 0;
+  count = 0;
+  frozen = false;
+  frozenBy = 0;
+}
+
+void fdrRecord(uint8_t kind, uint8_t a, int16_t b, int16_t c) {
+  if (frozen) return;
+  FdrRecord &r = ring[head];
+  r.ms = (uint16_t)millis();
+  r.kind = kind;
+  r.a = a;
+  r.b = b;
+  r.c = c;
+  head = (uint8_t)((head + 1) % FDR_RECORDS);
+  if (count < FDR_RECORDS) count++;
+}
+
+void fdrTrigger(uint8_t trigger) {
+  if (frozen || !(trigger & triggerMask)) return;
+  // Record the trigger itself as the last entry, then freeze
+  fdrRecord(FDR_TRIGGER, trigger);
+  frozen = true;
+  frozenBy = trigger;
+}
+
+void fdrArm() {
+  frozen = false;
+  frozenBy = 0;
+}
+
+bool fdrFrozen() { return frozen; }
+uint8_t fdrTriggerMask() { return triggerMask; }
+void fdrSetTriggerMask(uint8_t mask) { triggerMask = mask; }
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static char* putHex8(char* p, uint8_t v) {
+  *p++ = HEX_DIGITS[v >> 4];
+  *p++ = HEX_DIGITS[v & 0x0F];
+  return p;
+}
+
+void fdrDump() {
+  // Header: FDR,<frozen>,<trigger>,<now_ms>,<count>
+  CONTROL_SERIAL.print("FDR,");
+  CONTROL_SERIAL.print(frozen ? "1," : "0,");
+  CONTROL_SERIAL.print((unsigned long)frozenBy);
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.print((unsigned long)millis());
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.println((unsigned long)count);
+  // Records oldest first, each as 16 hex chars in little-endian field order
+  uint8_t idx = (uint8_t)((head + FDR_RECORDS - count) % FDR_RECORDS);
+  for (uint8_t i = 0; i < count; ++i) {
+    const FdrRecord &r = ring[idx];
+    char line[4 + 16 + 1];
+    char* p = line;
+    *p++ = 'F'; *p++ = 'D'; *p++ = 'R'; *p++ = ',';
+    p = putHex8(p, (uint8_t)(r.ms & 0xFF));
+    p = putHex8(p, (uint8_t)(r.ms >> 8));
+    p = putHex8(p, r.kind);
+    p = putHex8(p, r.a);
+    p = putHex8(p, (uint8_t)((uint16_t)r.b & 0xFF));
+    p = putHex8(p, (uint8_t)((uint16_t)r.b >> 8));
+    p = putHex8(p, (uint8_t)((uint16_t)r.c & 0xFF));
+    p = putHex8(p, (uint8_t)((uint16_t)r.c >> 8));
+    *p = '\0';
+    CONTROL_SERIAL.println(line);
+    idx = (uint8_t)((idx + 1) % FDR_RECORDS);
+  }
+  CONTROL_SERIAL.println("FDR,end");
+}
@@ -0,0 +1,131 @@
+#include "governor.h"
+#include "idle.h"
+#include "motion.h"
+#include "sensors.h"
+#include "telemetry.h"
+#include "tx.h"
+#include <Arduino.h>
+
+static uint8_t fullPct = 60;
+static uint8_t floorPct = 25;
+static uint8_t minLevel = 30;
+static uint16_t budgetMin = 0;
+static uint32_t budgetStartMs = 0;
+
+static uint8_t trim = 100;   // budget trim (percent of the curve level)
+static uint8_t level = 100;
+static uint32_t draw16 = 0;  // smoothed discharge current, mA * 16
+static uint16_t runtimeMin = GOV_RUNTIME_UNKNOWN;
+static bool ticked = false;
+static uint32_t lastTickMs = 0;
+static uint32_t lastReportMs = 0;
+
+void governorReset() {
+  trim = 100;
+  level = 100;
+  draw16 = 0;
+  runtimeMin = GOV_RUNTIME_UNKNOWN;
+  ticked = false;
+  budgetMin = 0;
+  budgetStartMs = 0;
+  setMotionGovernor(1.0f);
+  telemetrySetKeyframeMs(TELEM_KEYFRAME_MS);
+}
+
+static uint8_t curveLevel(int pct) {
+  if (pct >= fullPct) return 100;
+  if (pct <= floorPct) return minLevel;
+  return (uint8_t)(minLevel + (100 - minLevel) * (pct - floorPct) / (fullPct - floorPct));
+}
+
+static void predict() {
+  int16_t mA = sensorsCurrentMa();
+  if (mA < 0) {
+    uint32_t draw = (uint32_t)(-(int32_t)mA);
+    draw16 = draw16 ? draw16 - draw16 / 16 + draw : draw * 16;
+  }
+  uint16_t cap = sensorsCapacityMah();
+  if (mA >= 0 || cap == 0 || draw16 < 16) {
+    runtimeMin = GOV_RUNTIME_UNKNOWN;
+    return;
+  }
+  uint32_t reserve = (uint32_t)cap * IDLE_SLEEP_PCT / 100;
+  uint32_t charge = sensorsChargeMah();
+  uint32_t usable = charge > reserve ? charge - reserve : 0;
+  uint32_t m = usable * 60 / (draw16 / 16);
+  runtimeMin = (uint16_t)(m < GOV_RUNTIME_UNKNOWN ? m : GOV_RUNTIME_UNKNOWN - 1);
+}
+
+static void trimForBudget(uint32_t nowMs) {
+  uint32_t elapsedMin = (nowMs - budgetStartMs) / 60000UL;
+  if (budgetMin == 0 || elapsedMin >= budgetMin || runtimeMin == GOV_RUNTIME_UNKNOWN) {
+    if (trim < 100) trim++;
+    return;
+  }
+  uint32_t left = budgetMin - elapsedMin;
+  if (runtimeMin < left) {
+    // Short of the budget: 2%/s down, 1%/s back up, so the trim settles
+    // where the (smoothed) draw just covers the rest of the task
+    trim = trim > minLevel + 2 ? trim - 2 : minLevel;
+  } else if (runtimeMin > left + left / 10 && trim < 100) {
+    trim++;
+  }
+}
+
+static void report() {
+  // BAT,<mV>,<percent>,<charging>,<runtime_min>,<level>
+  txBegin("BAT");
+  txU32(sensorsVoltageMv());
+  txU32((uint32_t)batteryPercent());
+  txU32(sensorsCurrentMa() > 0 ? 1 : 0);
+  txU32(runtimeMin);
+  txU32(level);
+  txEndLine();
+}
+
+void governorTick(uint32_t nowMs) {
+  if (ticked && nowMs - lastTickMs < GOV_TICK_MS) return;
+  if (!ticked) lastReportMs = nowMs;
+  ticked = true;
+  lastTickMs = nowMs;
+  predict();
+  trimForBudget(nowMs);
+  uint8_t l = (uint8_t)((uint16_t)curveLevel(batteryPercent()) * trim / 100);
+  level = l > minLevel ? l : minLevel;
+  setMotionGovernor((GOV_SPEED_MIN_PCT + (100 - GOV_SPEED_MIN_PCT) * level / 100) / 100.0f);
+  telemetrySetKeyframeMs((uint16_t)((uint32_t)TELEM_KEYFRAME_MS * (100 + 3 * (100 - level)) / 100));
+  // Nothing to report until the stream has delivered a voltage
+  if (nowMs - lastReportMs >= GOV_REPORT_MS && sensorsVoltageMv() != 0) {
+    lastReportMs = nowMs;
+    report();
+  }
+}
+
+uint8_t governorLevel() { return level; }
+uint16_t governorRuntimeMin() { return runtimeMin; }
+
+bool governorAllow() { return level >= 100 || random(100) < level; }
+
+bool governorSetFullPct(uint16_t pct) {
+  if (pct > 100 || pct <= floorPct) return false;
+  fullPct = (uint8_t)pct;
+  return true;
+}
+
+bool governorSetFloorPct(uint16_t pct) {
+  if (pct >= fullPct) return false;
+  floorPct = (uint8_t)pct;
+  return true;
+}
+
+bool governorSetMinLevel(uint16_t pct) {
+  if (pct < 5 || pct > 100) return false;
+  minLevel = (uint8_t)pct;
+  return true;
+}
+
+bool governorSetBudgetMin(uint16_t minutes, uint32_t nowMs) {
+  budgetMin = minutes;
+  budgetStartMs = nowMs;
+  return true;
+}
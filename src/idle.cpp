@@ -41,7 +41,7 @@ void updateIdle(bool usbConnected) {
   setIdleBatteryLevel((uint8_t)pct);
 
   // Battery check first
-  if (pct < 20) {
+  if (pct < IDLE_SLEEP_PCT) {
     if (!sleeping) {
       playLowBatteryTone();
       stopAllMotors();
@@ -50,7 +50,7 @@ void updateIdle(bool usbConnected) {
       idleActive = false;
     }
     return;
-  } else if (sleeping && pct >= 20) {
+  } else if (sleeping && pct >= IDLE_SLEEP_PCT) {
     sleeping = false;
   }
 
@@ -1,5 +1,21 @@
 // Pro Micro Brainstem — HELLO/READY handshake + reboot, pre-handshake Safe mode with periodic note, then passthrough
+// (or, with MANAGED_STACK, the mode manager)
 #include <Arduino.h>
+#include "cdc_ctl.h"
+
+// Managed stack (-DMANAGED_STACK=1, env:brainstem_promicro_managed): after
+// READY the loop belongs to the mode manager (mode.h) -- bridge with FF 00
+// escapes and the PLAY handshake, FOREBRAIN, AUTONOMOUS -- instead of the
+// bare byte copy below.
+#ifndef MANAGED_STACK
+#define MANAGED_STACK 0
+#endif
+#if MANAGED_STACK
+#include "fdr.h"
+#include "leds.h"
+#include "mode.h"
+#include "sensors.h"
+#endif
 
 #ifndef CREATE_SERIAL
 #define CREATE_SERIAL Serial1
@@ -49,7 +65,9 @@ static const unsigned long OI_GAP_MS = 20;
 // Define a small palette of pleasant phrases (IDs 0..5)
 // 0: yawn (down then up), 1: stretch (upwards arpeggio), 2: soft warble,
 // 3: chirp-up, 4: chirp-down, 5: trill
-static void defineAmbientSongs() {
+// One song per call; ambientDefineTick() spaces them by OI_GAP_MS from loop().
+static const uint8_t AMBIENT_SONGS = 6;
+static void defineAmbientSong(uint8_t song) {
   auto defineSong = [](uint8_t id, const uint8_t* notes, const uint8_t* durs, uint8_t count) {
     CREATE_SERIAL.write(OI_SONG);
     CREATE_SERIAL.write(id);
@@ -58,46 +76,141 @@ static void defineAmbientSongs() {
       CREATE_SERIAL.write(notes[i]);
       CREATE_SERIAL.write(durs[i]);
     }
-    delay(OI_GAP_MS);
   };
 
   // Song 0: Yawn (A4..C4..G4), gentle and slow
-  {
+  if (song == 0) {
     const uint8_t notes[] = {69, 67, 65, 64, 62, 60, 62, 64, 65, 67};
     const uint8_t durs[]  = {12, 12, 12, 10, 10, 10, 10, 10, 12, 14};
     defineSong(0, notes, durs, (uint8_t)(sizeof(notes)));
   }
   // Song 1: Stretch (C4 E4 G4 C5 G4)
-  {
+  if (song == 1) {
     const uint8_t notes[] = {60, 64, 67, 72, 67};
     const uint8_t durs[]  = {10, 10, 10, 12, 10};
     defineSong(1, notes, durs, (uint8_t)(sizeof(notes)));
   }
   // Song 2: Soft warble around E5
-  {
+  if (song == 2) {
     const uint8_t notes[] = {76, 75, 77, 75, 76, 74};
     const uint8_t durs[]  = {6,  6,  6,  6,  8,  8};
     defineSong(2, notes, durs, (uint8_t)(sizeof(notes)));
   }
   // Song 3: Chirp up (quick, light)
-  {
+  if (song == 3) {
     const uint8_t notes[] = {76, 79, 83};
     const uint8_t durs[]  = {4,  4,  6};
     defineSong(3, notes, durs, (uint8_t)(sizeof(notes)));
   }
   // Song 4: Chirp down (quick, light)
-  {
+  if (song == 4) {
     const uint8_t notes[] = {83, 79, 76};
     const uint8_t durs[]  = {4,  4,  6};
     defineSong(4, notes, durs, (uint8_t)(sizeof(notes)));
   }
   // Song 5: Trill (gentle alternating pair)
-  {
+  if (song == 5) {
     const uint8_t notes[] = {79, 81, 79, 81, 79, 81};
     const uint8_t durs[]  = {3,  3,  3,  3,  3,  6};
     defineSong(5, notes, durs, (uint8_t)(sizeof(notes)));
   }
-  g_ambientDefined = true;
+}
+
+// Deferred OI bring-up: START then SAFE, one step per OI_GAP_MS from loop(),
+// so setup() returns as soon as USB and the UART are up. The ambient songs are
+// defined the same way once the OI answers.
+enum BootStep { BOOT_OI_START, BOOT_OI_SAFE, BOOT_DONE };
+static uint8_t g_bootStep = BOOT_OI_START;
+static unsigned long g_bootNextMs = 0;
+static uint8_t g_ambientNext = 0;           // next ambient song to define
+static unsigned long g_ambientNextMs = 0;
+static unsigned long g_probeUntilMs = 0;    // non-zero while a probe awaits its reply
+
+// Boot-phase timings reported in HELLO (micros()/millis() since reset)
+static unsigned long g_bootSetupUs = 0;  // setup() finished: bridge ready
+static unsigned long g_bootOiUs = 0;     // deferred OI init finished (0 = pending/skipped)
+static unsigned long g_bootUsbMs = 0;    // host opened the port (DTR)
+
+// Survives every reset but power-on (which scrambles it): set on READY and
+// cleared while the host has the port closed (DTR low). The Pro Micro's
+// Caterina bootloader clears MCUSR before the sketch runs, so the reset cause
+// cannot be read back; the marker alone says a session was live. USB
+// re-enumerates on any reset, so the host always comes back with HELLO: a
+// warm boot leaves the OI alone and answers it with READY at once, without
+// the power cycle and OI init.
+static const uint32_t WARM_MAGIC = 0xB5A1B0D7UL;
+static uint32_t g_warmMagic __attribute__((section(".noinit")));
+static uint32_t g_warmCheck __attribute__((section(".noinit")));
+static bool g_warmBoot = false;
+static bool g_warmPending = false; // warm boot still waiting for HELLO
+static bool g_hostDtr = false;   // host held the port open on the last pass
+// A warm boot nobody reclaims falls back to the cold pre-handshake routine
+static const unsigned long WARM_HELLO_WAIT_MS = 5000;
+
+#if defined(__AVR__)
+#include <avr/wdt.h>
+// Before the core's init code runs: a watchdog reset (!reboot) leaves WDRF
+// set and the watchdog running, which would reset again mid-setup.
+static void stopWatchdog() __attribute__((naked, used, section(".init3")));
+static void stopWatchdog() {
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+static void markHostSession(bool active) {
+  g_warmMagic = active ? WARM_MAGIC : 0;
+  g_warmCheck = active ? ~WARM_MAGIC : 0;
+}
+
+#if MANAGED_STACK
+// USB traffic hook from passthroughPump(); presence itself comes from the USB
+// stack (usblink.h), so there is nothing to record
+void usbLinkActivity() {}
+#endif
+
+// The host owns the robot from here: READY, or a warm reset mid-session
+static void startHostSession() {
+  g_hostMode = true;
+  markHostSession(true);
+#if MANAGED_STACK
+  // Configure the OI stream once; mode switches only pause/resume it
+  beginSensorStream();
+  initMode(MODE_PASSTHROUGH);
+#endif
+}
+
+static void bootTick(unsigned long now) {
+  if (g_bootStep == BOOT_DONE || (long)(now - g_bootNextMs) < 0) return;
+  if (g_bootStep == BOOT_OI_START) {
+    CREATE_SERIAL.write(OI_START);
+    g_bootStep = BOOT_OI_SAFE;
+  } else {
+    CREATE_SERIAL.write(OI_SAFE);
+    g_bootStep = BOOT_DONE;
+    g_bootOiUs = micros();
+  }
+  g_bootNextMs = now + OI_GAP_MS;
+  g_lastOiAssertMs = now;
+}
+
+static void ambientDefineTick(unsigned long now) {
+  if (g_ambientDefined || (long)(now - g_ambientNextMs) < 0) return;
+  defineAmbientSong(g_ambientNext++);
+  g_ambientNextMs = now + OI_GAP_MS;
+  if (g_ambientNext >= AMBIENT_SONGS) g_ambientDefined = true;
+}
+
+static void printHello() {
+  // HELLO,proto=1.0,build=<date> <time>,reset=<warm|cold>,setup_us=..,oi_us=..,usb_ms=..
+  CONTROL_SERIAL.print("HELLO,proto=1.0,build=" __DATE__ " " __TIME__ ",reset=");
+  CONTROL_SERIAL.print(g_warmBoot ? "warm" : "cold");
+  CONTROL_SERIAL.print(",setup_us=");
+  CONTROL_SERIAL.print(g_bootSetupUs);
+  CONTROL_SERIAL.print(",oi_us=");
+  CONTROL_SERIAL.print(g_bootOiUs);
+  CONTROL_SERIAL.print(",usb_ms=");
+  CONTROL_SERIAL.println(g_bootUsbMs);
 }
 
 static inline void oiWriteDelay(uint8_t b) {
@@ -132,68 +245,125 @@ void setup() {
   // Leave power toggle floating until explicitly pulsed
   pinMode(POWER_TOGGLE_PIN, INPUT);
   g_ctrlLen = 0;
-  g_hostMode = false;
+  // A warm reset leaves the OI mode alone (START would drop the robot back
+  // to Passive under the host's feet) and keeps the marker for HELLO.
+  g_warmBoot = g_warmMagic == WARM_MAGIC && g_warmCheck == ~WARM_MAGIC;
+  g_warmPending = g_warmBoot;
+  if (!g_warmBoot) markHostSession(false);
+#if MANAGED_STACK
+  fdrInit();
+  initLeds();
+  initSensors();
+#endif
   // Seed RNG for random note selection
   randomSeed((unsigned long)micros());
-  // Attempt to place robot into Safe mode (no power toggle here)
-  oiWriteDelay(OI_START);
-  oiWriteDelay(OI_SAFE);
   unsigned long now = millis();
+  // Place robot into Safe mode in the background (no power toggle here)
+  g_bootStep = g_warmBoot ? BOOT_DONE : BOOT_OI_START;
+  g_bootNextMs = now;
   // Schedule first ambient phrase in a few seconds
   g_nextAmbientMs = now + 3000;
   g_lastOiAssertMs = now;
   g_lastProbeMs = now;
+  g_bootSetupUs = micros();
 }
 
 // (DTMF implementation removed in favor of friendlier tones)
 
+// One byte of host control text (HELLO handshake)
+static void hostControlByte(uint8_t b) {
+  // Host began typing: ensure pleasant chirps are defined; play a light chirp
+  // per char (never once bridging: the robot stream belongs to the host)
+  bool chirp = !g_hostMode && !g_warmPending && (millis() - g_lastOiReadyMs) < 5000;
+  if (chirp && !g_ambientDefined) {
+    ambientDefineTick(millis());
+  }
+  if (chirp && g_ambientDefined) {
+    // Pick from chirp songs 3..5 for variation
+    uint8_t pick = (uint8_t)(3 + (random(3))); // 3,4,5
+    uint8_t play[] = { OI_PLAY, pick };
+    CREATE_SERIAL.write(play, sizeof(play));
+  }
+  // Accumulate an ASCII line and look for HELLO
+  if (b == '\n' || b == '\r') {
+    g_ctrlBuf[g_ctrlLen < sizeof(g_ctrlBuf)-1 ? g_ctrlLen : sizeof(g_ctrlBuf)-1] = '\0';
+    if (strcmp(g_ctrlBuf, "HELLO") == 0 && g_warmPending) {
+      // The robot never noticed the reset: hand it straight back
+      printHello();
+      g_warmPending = false;
+      CONTROL_SERIAL.println("READY");
+      startHostSession();
+    } else if (strcmp(g_ctrlBuf, "HELLO") == 0) {
+      printHello();
+      CONTROL_SERIAL.println("BUSY");
+      // The handshake re-initializes the OI itself
+      g_bootStep = BOOT_DONE;
+      // Deterministic OFF → ON power cycle
+      pulsePowerToggle();                // OFF
+      delay(POWER_OFF_SETTLE_MS);
+      pulsePowerToggle();                // ON
+      delay(POWER_POST_DELAY_MS);
+      // Minimal OI init to a benign state with proper inter-opcode gap
+      oiWriteDelay(OI_START);
+      oiWriteDelay(OI_SAFE);
+      // Hand over to host
+      CONTROL_SERIAL.println("READY");
+      startHostSession();
+    }
+    g_ctrlLen = 0;
+  } else if (g_ctrlLen + 1 < sizeof(g_ctrlBuf)) {
+    g_ctrlBuf[g_ctrlLen++] = (char)b;
+  } else {
+    // overflow; reset buffer
+    g_ctrlLen = 0;
+  }
+}
+
 void loop() {
-  // Host → control or passthrough
+  bool dtr = Serial.dtr() || CONTROL_SERIAL.dtr();
+  if (!g_bootUsbMs && CONTROL_SERIAL.dtr()) g_bootUsbMs = millis();
+  // The warm-reset marker only lasts while a host holds the port open
+  if (g_hostMode && dtr != g_hostDtr) markHostSession(dtr);
+  g_hostDtr = dtr;
+#if MANAGED_STACK
+  if (g_hostMode) {
+    modeLoop();
+    updateLeds();
+    return;
+  }
+#endif
+#if DUAL_CDC
+  // Control text has a port of its own; the bridge port is never scanned
+  while (CONTROL_SERIAL.available() > 0) {
+    int ci = CONTROL_SERIAL.read();
+    if (ci < 0) break;
+    hostControlByte((uint8_t)ci);
+  }
   while (Serial.available() > 0) {
+    // Leave what the UART cannot take in the USB endpoint (CDC NAKs)
+    if (g_hostMode && CREATE_SERIAL.availableForWrite() <= 0) break;
+    int ci = Serial.read();
+    if (ci < 0) break;
+    // Bridge bytes before READY are dropped
+    if (g_hostMode) CREATE_SERIAL.write((uint8_t)ci);
+  }
+#else
+  // Host → control or passthrough. Once bridging, read no faster than the
+  // UART drains so a full TX buffer never blocks the robot → host direction.
+  while (Serial.available() > 0) {
+    if (g_hostMode && CREATE_SERIAL.availableForWrite() <= 0) break;
     int ci = Serial.read();
     if (ci < 0) break;
     uint8_t b = (uint8_t)ci;
     if (!g_hostMode) {
-      // Host began typing: ensure pleasant chirps are defined; play a light chirp per char
-      if ((millis() - g_lastOiReadyMs) < 5000 && !g_ambientDefined) {
-        defineAmbientSongs();
-      }
-      if ((millis() - g_lastOiReadyMs) < 5000 && g_ambientDefined) {
-        // Pick from chirp songs 3..5 for variation
-        uint8_t pick = (uint8_t)(3 + (random(3))); // 3,4,5
-        uint8_t play[] = { OI_PLAY, pick };
-        CREATE_SERIAL.write(play, sizeof(play));
-      }
-      // Accumulate an ASCII line and look for HELLO
-      if (b == '\n' || b == '\r') {
-        g_ctrlBuf[g_ctrlLen < sizeof(g_ctrlBuf)-1 ? g_ctrlLen : sizeof(g_ctrlBuf)-1] = '\0';
-        if (strcmp(g_ctrlBuf, "HELLO") == 0) {
-          Serial.println("BUSY");
-          // Deterministic OFF → ON power cycle
-          pulsePowerToggle();                // OFF
-          delay(POWER_OFF_SETTLE_MS);
-          pulsePowerToggle();                // ON
-          delay(POWER_POST_DELAY_MS);
-          // Minimal OI init to a benign state with proper inter-opcode gap
-          oiWriteDelay(OI_START);
-          oiWriteDelay(OI_SAFE);
-          // Hand over to host
-          Serial.println("READY");
-          g_hostMode = true;
-        }
-        g_ctrlLen = 0;
-      } else if (g_ctrlLen + 1 < sizeof(g_ctrlBuf)) {
-        g_ctrlBuf[g_ctrlLen++] = (char)b;
-      } else {
-        // overflow; reset buffer
-        g_ctrlLen = 0;
-      }
+      hostControlByte(b);
       // Do not forward bytes before READY
       continue;
     }
     // Passthrough mode
     CREATE_SERIAL.write(b);
   }
+#endif
 
   // Robot → Host (only when in passthrough)
   if (g_hostMode) {
@@ -205,30 +375,48 @@ void loop() {
   } else {
     // Pre-handshake: keep robot in SAFE and occasionally play gentle phrases
     unsigned long now = millis();
+    if (g_warmPending) {
+      // Hands off the OI until the host's HELLO, or until it is clear that
+      // nobody is coming back
+      if (now < WARM_HELLO_WAIT_MS) return;
+      g_warmPending = false;
+      g_warmBoot = false;
+      g_bootStep = BOOT_OI_START;
+      g_bootNextMs = now;
+      markHostSession(false);
+    }
+    if (g_bootStep != BOOT_DONE) {
+      bootTick(now);
+      return;
+    }
     // Re-assert OI mode periodically so if the robot powers up later, we catch it
     if (now - g_lastOiAssertMs >= OI_ASSERT_MS) {
       // Do NOT resend START repeatedly (that would drop back to PASSIVE).
       // Only re-assert SAFE to remain in Safe mode.
-      oiWriteDelay(OI_SAFE);
+      CREATE_SERIAL.write(OI_SAFE);
       g_lastOiAssertMs = now;
     }
-    // Lightweight probe occasionally to confirm OI is listening
-    bool oi_ready = false;
-    if (now - g_lastProbeMs >= PROBE_INTERVAL_MS) {
+    // Lightweight probe occasionally to confirm OI is listening. The reply is
+    // collected on later passes instead of spinning here.
+    if (g_probeUntilMs) {
+      if (CREATE_SERIAL.available() > 0) {
+        while (CREATE_SERIAL.available() > 0) (void)CREATE_SERIAL.read();
+        g_lastOiReadyMs = now;
+        g_probeUntilMs = 0;
+      } else if ((long)(now - g_probeUntilMs) >= 0) {
+        g_probeUntilMs = 0;
+      }
+    } else if (now - g_lastProbeMs >= PROBE_INTERVAL_MS && now - g_lastOiAssertMs >= OI_GAP_MS) {
       // Query packet 7 (one byte). If any byte comes back quickly, consider ready.
       while (CREATE_SERIAL.available() > 0) (void)CREATE_SERIAL.read();
       CREATE_SERIAL.write((uint8_t)142); // OI_SENSORS
       CREATE_SERIAL.write((uint8_t)7);
-      unsigned long until = now + PROBE_WAIT_MS;
-      while (millis() < until) {
-        if (CREATE_SERIAL.available() > 0) { (void)CREATE_SERIAL.read(); oi_ready = true; break; }
-      }
+      g_probeUntilMs = now + PROBE_WAIT_MS;
       g_lastProbeMs = now;
-      if (oi_ready) g_lastOiReadyMs = now;
     }
     // Define ambient songs once after OI responds
-    if (!g_ambientDefined && (now - g_lastOiReadyMs) < 5000) {
-      defineAmbientSongs();
+    if (!g_ambientDefined && g_lastOiReadyMs && (now - g_lastOiReadyMs) < 5000) {
+      ambientDefineTick(now);
     }
     // Occasionally play a gentle phrase if OI seems ready
     if (g_ambientDefined && (now - g_lastOiReadyMs) < 5000 && now >= g_nextAmbientMs) {
@@ -0,0 +1,175 @@
+#include "mode.h"
+#include "cdc_ctl.h"
+#include "behavior.h"
+#include "control.h"
+#include "estop.h"
+#include "governor.h"
+#include "idle.h"
+#include "motion.h"
+#include "passthrough.h"
+#include "proto.h"
+#include "sensors.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "traj.h"
+#include "twist.h"
+#include "tx.h"
+#include "usblink.h"
+#include <Arduino.h>
+#include <string.h>
+
+static RunMode current = MODE_PASSTHROUGH;
+static bool paused = false;
+static uint32_t lastSwitchUs = 0;
+static uint32_t maxSwitchUs = 0;
+// Loop-time window, in timebase ticks
+static uint32_t loopSumTicks = 0;
+static uint32_t loopMaxTicks = 0;
+static uint16_t loopCount = 0;
+static uint16_t switches = 0;
+
+static MotionOwner ownerFor(RunMode mode) {
+  switch (mode) {
+    case MODE_FOREBRAIN:  return MOTION_OWNER_HOST;
+    case MODE_AUTONOMOUS: return MOTION_OWNER_BEHAVIOR;
+    default:              return MOTION_OWNER_BRIDGE;
+  }
+}
+
+static void reportState(const char* name) {
+  // STATE,<name>
+  txBegin("STATE");
+  txStr(name);
+  txEndLine();
+}
+
+const char* modeName(RunMode mode) {
+  switch (mode) {
+    case MODE_FOREBRAIN:  return PROTO_STATE_FOREBRAIN;
+    case MODE_AUTONOMOUS: return PROTO_STATE_AUTONOMOUS;
+    default:              return PROTO_STATE_PASSTHROUGH;
+  }
+}
+
+bool modeFromName(const char* name, RunMode &out) {
+  if (strcmp(name, PROTO_STATE_FOREBRAIN) == 0) out = MODE_FOREBRAIN;
+  else if (strcmp(name, PROTO_STATE_AUTONOMOUS) == 0) out = MODE_AUTONOMOUS;
+  else if (strcmp(name, PROTO_STATE_PASSTHROUGH) == 0) out = MODE_PASSTHROUGH;
+  else return false;
+  return true;
+}
+
+void initMode(RunMode start) {
+  initTimebase();
+  initUsbLink();
+  initIdle();
+  governorReset();
+  current = start;
+  paused = false;
+  setMotionOwner(ownerFor(start));
+  if (start == MODE_PASSTHROUGH) passthroughEnable();
+  if (start == MODE_AUTONOMOUS) initializeBehavior();
+}
+
+void modeSet(RunMode mode, uint32_t cmdTicks) {
+  if (cmdTicks == 0) cmdTicks = tbTicks();
+  RunMode prev = current;
+  bool wasPaused = paused;
+  paused = false;
+  if (mode == prev && !wasPaused) return;
+  // Stop and hand the wheels over before anything else changes
+  trajClear();
+  twistClear();
+  setMotionOwner(ownerFor(mode));
+  if (mode == MODE_PASSTHROUGH) {
+    // Announce while the TX ring still owns USB, then hand the port over;
+    // passthroughEnable() pauses (not reconfigures) the OI stream.
+    reportState(modeName(mode));
+    txFlush();
+    current = mode;
+    passthroughEnable();
+    // The governor stops ticking: drop its level and the host's task budget
+    governorReset();
+  } else {
+    if (prev == MODE_PASSTHROUGH) {
+      passthroughDisable(); // resumes the configured stream
+      sensorsResync();
+      telemetryForceKeyframe();
+    }
+    current = mode;
+    reportState(modeName(mode));
+    // Fresh arbiter and OI FULL for every autonomy run
+    if (mode == MODE_AUTONOMOUS) initializeBehavior();
+  }
+  uint32_t lat = tbTicksToUs(tbTicks() - cmdTicks);
+  lastSwitchUs = lat;
+  if (lat > maxSwitchUs) maxSwitchUs = lat;
+  switches++;
+}
+
+RunMode modeCurrent() { return current; }
+
+void modePause() {
+  if (paused || current == MODE_PASSTHROUGH) return;
+  paused = true;
+  trajClear();
+  twistClear();
+  setMotionOwner(MOTION_OWNER_NONE);
+  reportState(PROTO_STATE_PAUSED);
+}
+
+void modeResume() {
+  if (!paused) return;
+  modeSet(current);
+}
+
+bool modePaused() { return paused; }
+
+uint32_t modeLastSwitchUs() { return lastSwitchUs; }
+uint32_t modeMaxSwitchUs() { return maxSwitchUs; }
+uint16_t modeSwitches() { return switches; }
+
+void modeLoopStats(uint32_t &avgUs, uint32_t &maxUs) {
+  avgUs = loopCount ? tbTicksToUs(loopSumTicks / loopCount) : 0;
+  maxUs = tbTicksToUs(loopMaxTicks);
+  loopSumTicks = loopMaxTicks = 0;
+  loopCount = 0;
+}
+
+// Handshake hook from passthroughPump(): OI PLAY <HANDSHAKE_SONG>
+void enterForebrainModeFromPassthrough(uint8_t songId) {
+  (void)songId;
+  modeSet(MODE_FOREBRAIN);
+}
+
+void modeLoop() {
+  uint32_t start = tbTicks();
+  usbLinkPoll();
+  if (current == MODE_PASSTHROUGH) {
+    passthroughPump(); // may switch to FOREBRAIN on the handshake
+#if DUAL_CDC
+    controlPoll();     // control has its own port: SET,mode / !cmds while bridging
+#endif
+  } else {
+    controlPoll();
+    updateSensorStream();
+    telemetryTick();
+    estopTick();
+    governorTick(tbMillis());
+    // Host gone for the idle timeout: idle pattern; low battery: sleep
+    updateIdle(usbLinkPresent());
+    if (current == MODE_FOREBRAIN && !paused) {
+      trajTick(tbMillis());
+      twistTick(tbMillis());
+    }
+    if (current == MODE_AUTONOMOUS && !paused) updateBehavior();
+  }
+  txFlush();
+  uint32_t dt = tbTicks() - start;
+  // Saturate the window rather than let the sum wrap (~35 min of ticks)
+  if (loopCount < 0xFFFF && loopSumTicks + dt >= loopSumTicks) {
+    loopSumTicks += dt;
+    loopCount++;
+  }
+  if (dt > loopMaxTicks) loopMaxTicks = dt;
+}
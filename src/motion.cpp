@@ -1,6 +1,8 @@
 #include "motion.h"
 #include <Arduino.h>
 #include "sensors.h"  // for pause/resume of OI sensor stream during blocking motions
+#include "fdr.h"
+#include "estop.h"
 
 // iRobot Create 1 Open Interface opcodes
 static constexpr uint8_t OI_START = 128;
@@ -10,16 +12,17 @@ static constexpr uint8_t OI_DRIVE_DIRECT = 145;
 static constexpr uint16_t VELOCITY = 200; // mm/s base before scaling
 static constexpr unsigned long TICK_MS = 100; // duration of one tick
 static float SPEED_SCALE = 0.25f; // 25% speed for gentle autonomous/presence
+static float GOVERNOR = 1.0f;     // battery governor factor on top of the scale
+static MotionOwner owner = MOTION_OWNER_BEHAVIOR;
+// Wheel speeds of the last Drive Direct frame (mm/s as sent)
+static int16_t sentRight = 0, sentLeft = 0;
 
 /**
  * Helper to send direct wheel speeds to the Create.
  * @param right Right wheel velocity in mm/s
  * @param left  Left wheel velocity in mm/s
  */
-static void driveWheels(int16_t right, int16_t left) {
-  // Apply global scale to behavior/presence motions only
-  right = (int16_t)(right * SPEED_SCALE);
-  left  = (int16_t)(left * SPEED_SCALE);
+static void sendDrive(int16_t right, int16_t left) {
   uint8_t cmd[] = {
       OI_DRIVE_DIRECT,
       static_cast<uint8_t>((right >> 8) & 0xFF),
@@ -27,6 +30,20 @@ static void driveWheels(int16_t right, int16_t left) {
       static_cast<uint8_t>((left >> 8) & 0xFF),
       static_cast<uint8_t>(left & 0xFF)};
   Serial1.write(cmd, sizeof(cmd));
+  sentRight = right;
+  sentLeft = left;
+  fdrRecord(FDR_DRIVE, 0, right, left);
+}
+
+static void driveWheels(int16_t right, int16_t left) {
+  // ESTOP latch refuses any motion; stops are always allowed through
+  if (estopActive() && (right != 0 || left != 0)) return;
+  // Only the behavior layer moves through these helpers
+  if (owner != MOTION_OWNER_BEHAVIOR && (right != 0 || left != 0)) return;
+  // Apply global scale to behavior/presence motions only
+  right = (int16_t)(right * SPEED_SCALE * GOVERNOR);
+  left  = (int16_t)(left * SPEED_SCALE * GOVERNOR);
+  sendDrive(right, left);
 }
 
 /**
@@ -39,8 +56,9 @@ static void driveWheels(int16_t right, int16_t left) {
  */
 void initMotors() {
   Serial1.begin(57600);
-  delay(100);
   Serial1.write(OI_START);
+  // The OI drops a mode change sent hard on the heels of START
+  delay(100);
   // Create 1: prefer FULL mode to avoid unexpected passive/safe drops during autonomous ticks
   Serial1.write(OI_FULL);
 }
@@ -192,6 +210,37 @@ void stopAllMotors() {
   driveWheels(0, 0);
 }
 
+/**
+ * Set wheel speeds without blocking; they hold until the next command.
+ */
+void motionDrive(int16_t right, int16_t left) {
+  driveWheels(right, left);
+}
+
+/**
+ * Host (forebrain) wheel speeds, unscaled. Refused unless the host owns motion.
+ */
+bool motionHostDrive(int16_t right, int16_t left) {
+  bool moving = right != 0 || left != 0;
+  if (moving && (estopActive() || owner != MOTION_OWNER_HOST)) return false;
+  sendDrive(right, left);
+  return true;
+}
+
+/**
+ * Differential-drive kinematics for the Create 1 (258 mm wheel base).
+ */
+void motionTwistToWheels(float vx, float wz, int16_t &right, int16_t &left) {
+  float v = vx * 1000.0f, w = wz * 129.0f;
+  float r = v + w, l = v - w;
+  if (r > 500.0f) r = 500.0f;
+  if (r < -500.0f) r = -500.0f;
+  if (l > 500.0f) l = 500.0f;
+  if (l < -500.0f) l = -500.0f;
+  right = (int16_t)r;
+  left = (int16_t)l;
+}
+
 /**
  * Emit an audible alert when the robot freezes.
  */
@@ -204,3 +253,26 @@ void setMotionSpeedScale(float scale) {
   if (scale > 1.0f) scale = 1.0f;
   SPEED_SCALE = scale;
 }
+
+void setMotionGovernor(float factor) {
+  if (factor < 0.05f) factor = 0.05f;
+  if (factor > 1.0f) factor = 1.0f;
+  GOVERNOR = factor;
+}
+
+void setMotionOwner(MotionOwner next) {
+  if (next == owner) return;
+  // Stop before the handoff so nothing keeps running on stale commands
+  const uint8_t stop[] = { OI_DRIVE_DIRECT, 0, 0, 0, 0 };
+  Serial1.write(stop, sizeof(stop));
+  sentRight = sentLeft = 0;
+  fdrRecord(FDR_DRIVE, (uint8_t)next, 0, 0);
+  owner = next;
+}
+
+MotionOwner motionOwner() { return owner; }
+
+void motionLastSent(int16_t &right, int16_t &left) {
+  right = sentRight;
+  left = sentLeft;
+}
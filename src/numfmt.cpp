@@ -0,0 +1,130 @@
+#include "numfmt.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#endif
+#endif
+
+static const char DIGIT_PAIRS[200] PROGMEM = {
+  '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+  '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+  '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+  '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+  '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+  '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+  '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+  '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+  '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+  '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+static const uint32_t POW10[NUMFMT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+static inline char* putPair(char* p, uint8_t v) {
+  const char* src = &DIGIT_PAIRS[v * 2];
+  *p++ = (char)pgm_read_byte(src);
+  *p++ = (char)pgm_read_byte(src + 1);
+  return p;
+}
+
+// v < 10000: split into two pairs with a multiply-shift (exact for v < 43699)
+static inline void split100(uint16_t v, uint8_t &hi, uint8_t &lo) {
+  hi = (uint8_t)(((uint32_t)v * 5243UL) >> 19);
+  lo = (uint8_t)(v - (uint16_t)hi * 100);
+}
+
+// Write v (< 10000) without leading zeros.
+static char* put4(char* p, uint16_t v) {
+  uint8_t hi, lo;
+  split100(v, hi, lo);
+  if (v >= 1000) { p = putPair(p, hi); return putPair(p, lo); }
+  if (v >= 100) { *p++ = (char)('0' + hi); return putPair(p, lo); }
+  if (v >= 10) return putPair(p, lo);
+  *p++ = (char)('0' + lo);
+  return p;
+}
+
+// Write v (< 10000) as exactly four digits.
+static char* put4Padded(char* p, uint16_t v) {
+  uint8_t hi, lo;
+  split100(v, hi, lo);
+  p = putPair(p, hi);
+  return putPair(p, lo);
+}
+
+// Write v (< 10^8) as exactly `width` digits (1..8).
+static char* putPadded(char* p, uint32_t v, uint8_t width) {
+  char tmp[8];
+  uint16_t hi = 0, lo = (uint16_t)v;
+  if (width > 4) {
+    hi = (uint16_t)(v / 10000);
+    lo = (uint16_t)(v - (uint32_t)hi * 10000);
+  }
+  put4Padded(tmp, hi);
+  put4Padded(tmp + 4, lo);
+  const char* src = tmp + (8 - width);
+  for (uint8_t i = 0; i < width; ++i) *p++ = src[i];
+  return p;
+}
+
+uint8_t fmtU32(char* out, uint32_t v) {
+  char* p = out;
+  if (v < 10000) {
+    p = put4(p, (uint16_t)v);
+  } else {
+    uint32_t hi = v / 10000;
+    uint16_t lo = (uint16_t)(v - hi * 10000);
+    if (hi < 10000) {
+      p = put4(p, (uint16_t)hi);
+    } else {
+      uint16_t top = (uint16_t)(hi / 10000);
+      p = put4(p, top);
+      p = put4Padded(p, (uint16_t)(hi - (uint32_t)top * 10000));
+    }
+    p = put4Padded(p, lo);
+  }
+  return (uint8_t)(p - out);
+}
+
+uint8_t fmtI32(char* out, int32_t v) {
+  if (v < 0) {
+    out[0] = '-';
+    return (uint8_t)(1 + fmtU32(out + 1, (uint32_t)0 - (uint32_t)v));
+  }
+  return fmtU32(out, (uint32_t)v);
+}
+
+uint8_t fmtFixed(char* out, int32_t scaled, uint8_t decimals) {
+  if (decimals > NUMFMT_MAX_DECIMALS) decimals = NUMFMT_MAX_DECIMALS;
+  if (decimals == 0) return fmtI32(out, scaled);
+  char* p = out;
+  uint32_t u = (uint32_t)scaled;
+  if (scaled < 0) {
+    *p++ = '-';
+    u = (uint32_t)0 - u;
+  }
+  uint32_t ip = u / POW10[decimals];
+  uint32_t fp = u - ip * POW10[decimals];
+  p += fmtU32(p, ip);
+  *p++ = '.';
+  p = putPadded(p, fp, decimals);
+  return (uint8_t)(p - out);
+}
+
+uint8_t fmtFloat(char* out, float v, uint8_t decimals) {
+  if (decimals > NUMFMT_MAX_DECIMALS) decimals = NUMFMT_MAX_DECIMALS;
+  float s = v * (float)POW10[decimals];
+  // NaN would make the int32 conversion undefined; send it as zero
+  if (s != s) s = 0.0f;
+  // Clamp to the int32 range (and infinities) before rounding
+  if (s > 2147483520.0f) s = 2147483520.0f;
+  if (s < -2147483520.0f) s = -2147483520.0f;
+  int32_t scaled = (int32_t)(s < 0 ? s - 0.5f : s + 0.5f);
+  return fmtFixed(out, scaled, decimals);
+}
@@ -0,0 +1,179 @@
+#include "oi.h"
+#include <string.h>
+
+static const uint8_t OI_DRIVE = 137;
+static const uint8_t OI_SONG = 140;
+static const uint8_t OI_DRIVE_DIRECT = 145;
+static const uint8_t OI_STREAM = 148;
+static const uint8_t OI_QUERY_LIST = 149;
+static const uint8_t OI_SCRIPT = 152;
+
+// Fixed data-byte counts for opcodes 128..158; variable-length ones are 0
+// here and handled through lenState (1 = count byte, 2/3 = song header).
+static const uint8_t DATA_LEN[] = {
+  0, 1, 0, 0, 0, 0, 0, 0, // 128 start, 129 baud, 130 control, 131 safe, 132 full, 133, 134 spot, 135 cover
+  1, 4, 1, 3, 0, 1, 1, 0, // 136 demo, 137 drive, 138 low side, 139 leds, 140 song*, 141 play, 142 sensors, 143 dock
+  3, 4, 0, 1, 0, 0, 1, 1, // 144 pwm low side, 145 drive direct, 146, 147 digital out, 148 stream*, 149 query*, 150 pause, 151 ir
+  0, 0, 0, 1, 2, 2, 1,    // 152 script*, 153 play script, 154 show script, 155 wait time, 156 wait dist, 157 wait angle, 158 wait event
+};
+
+void oiFramerReset(OiFramer &f) {
+  f.opcode = 0;
+  f.remaining = 0;
+  f.lenState = 0;
+}
+
+bool oiFramerFeed(OiFramer &f, uint8_t b) {
+  switch (f.lenState) {
+    case 1: // count byte of stream/query list/script: that many bytes follow
+      f.lenState = 0;
+      f.remaining = b;
+      return false;
+    case 2: // song number; the note count comes next
+      f.lenState = 3;
+      return false;
+    case 3: // song note count: N (note, duration) pairs follow
+      f.lenState = 0;
+      f.remaining = (uint8_t)(b * 2);
+      return false;
+    default:
+      break;
+  }
+  if (f.remaining > 0) {
+    f.remaining--;
+    return false;
+  }
+  f.opcode = b;
+  f.remaining = 0;
+  // Bytes outside the opcode range between commands are noise; forward as-is
+  if (b < 128 || b > 158) return false;
+  if (b == OI_STREAM || b == OI_QUERY_LIST || b == OI_SCRIPT) {
+    f.lenState = 1;
+  } else if (b == OI_SONG) {
+    f.lenState = 2;
+  } else {
+    f.remaining = DATA_LEN[b - 128];
+  }
+  return true;
+}
+
+bool oiIsDriveOpcode(uint8_t opcode) { return opcode == OI_DRIVE || opcode == OI_DRIVE_DIRECT; }
+
+bool oiIsMotionOpcode(uint8_t opcode) {
+  switch (opcode) {
+    case 134: case 135: case 136: // spot, cover, demo
+    case 143:                     // cover and dock
+    case OI_SCRIPT: case 153:     // a script may drive; play script
+      return true;
+    default:
+      return oiIsDriveOpcode(opcode);
+  }
+}
+
+static const uint8_t OI_SENSORS = 142;
+
+void oiShaperReset(OiShaper &s) {
+  oiFramerReset(s.framer);
+  s.len = 0;
+  s.frames = 0;
+  s.headStarted = false;
+  s.open = false;
+}
+
+uint8_t oiShaperRoom(const OiShaper &s) {
+  // Worst case every byte starts a command and needs a frame slot
+  uint8_t bytes = (uint8_t)(OI_SHAPER_BYTES - s.len);
+  uint8_t slots = (uint8_t)(OI_SHAPER_FRAMES - s.frames + (s.open ? 1 : 0));
+  return bytes < slots ? bytes : slots;
+}
+
+// Byte offset of command i in buf
+static uint8_t frameOffset(const OiShaper &s, uint8_t i) {
+  uint8_t off = 0;
+  for (uint8_t k = 0; k < i; ++k) off += s.frameLen[k];
+  return off;
+}
+
+static void removeFrame(OiShaper &s, uint8_t i) {
+  uint8_t off = frameOffset(s, i), n = s.frameLen[i];
+  memmove(s.buf + off, s.buf + off + n, s.len - off - n);
+  s.len -= n;
+  for (uint8_t k = i; k + 1 < s.frames; ++k) {
+    s.frameOp[k] = s.frameOp[k + 1];
+    s.frameLen[k] = s.frameLen[k + 1];
+  }
+  s.frames--;
+}
+
+// The last command just completed: if it is a drive frame, let it take the
+// place of an older queued one
+static void coalesceLast(OiShaper &s) {
+  uint8_t j = s.frames - 1;
+  if (!oiIsDriveOpcode(s.frameOp[j])) return;
+  for (uint8_t i = j; i-- > 0;) {
+    uint8_t op = s.frameOp[i];
+    if (op == OI_SENSORS || op == OI_QUERY_LIST) continue;
+    if (!oiIsDriveOpcode(op) || (i == 0 && s.headStarted) || s.frameLen[i] != s.frameLen[j]) return;
+    uint8_t from = frameOffset(s, j);
+    memcpy(s.buf + frameOffset(s, i), s.buf + from, s.frameLen[j]);
+    s.frameOp[i] = s.frameOp[j];
+    s.len = from;
+    s.frames--;
+    s.coalesced++;
+    return;
+  }
+}
+
+bool oiShaperPush(OiShaper &s, uint8_t b) {
+  if (s.len >= OI_SHAPER_BYTES) return false;
+  if (!s.open) {
+    if (s.frames >= OI_SHAPER_FRAMES) return false;
+    // Opcode or stray byte between commands: either starts an entry
+    s.frameOp[s.frames] = b;
+    s.frameLen[s.frames] = 0;
+    s.frames++;
+  }
+  oiFramerFeed(s.framer, b);
+  s.buf[s.len++] = b;
+  s.frameLen[s.frames - 1]++;
+  s.open = s.framer.remaining > 0 || s.framer.lenState != 0;
+  if (!s.open) coalesceLast(s);
+  return true;
+}
+
+void oiShaperConsume(OiShaper &s, uint8_t n) {
+  if (n > s.len) n = s.len;
+  memmove(s.buf, s.buf + n, s.len - n);
+  s.len -= n;
+  while (n > 0 && s.frames > 0) {
+    uint8_t take = n < s.frameLen[0] ? n : s.frameLen[0];
+    s.frameLen[0] -= take;
+    n -= take;
+    s.headStarted = true;
+    if (s.frameLen[0] > 0 || (s.frames == 1 && s.open)) break;
+    // Head command fully sent
+    removeFrame(s, 0);
+    s.headStarted = false;
+  }
+}
+
+void oiShaperDropDrives(OiShaper &s) {
+  for (uint8_t i = s.frames; i-- > 0;) {
+    if (i == 0 && s.headStarted) break;
+    if (i == s.frames - 1 && s.open) continue;
+    if (oiIsMotionOpcode(s.frameOp[i])) removeFrame(s, i);
+  }
+}
+
+void oiShaperDropPending(OiShaper &s) {
+  bool headOpen = s.open && s.frames == 1;
+  uint8_t keep = s.headStarted ? 1 : 0;
+  while (s.frames > keep) removeFrame(s, s.frames - 1);
+  // An unfinished head command still owes the robot its data bytes; later
+  // host bytes complete it. Otherwise start clean at the next opcode.
+  if (s.frames == 0 || !headOpen) {
+    s.open = false;
+    if (s.frames == 0) s.headStarted = false;
+    oiFramerReset(s.framer);
+  }
+}
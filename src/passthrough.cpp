@@ -1,13 +1,18 @@
 #include "passthrough.h"
+#include "cdc_ctl.h"
+#include "control.h"
+#include "dwell.h"
+#include "estop.h"
+#include "oi.h"
 #include "sensors.h"
+#include "timebase.h"
+#include "tx.h"
 #include <Arduino.h>
 
 #ifndef CREATE_SERIAL
 #define CREATE_SERIAL Serial1
 #endif
 
-extern bool tx_paused;
-
 static bool g_passthrough = false;
 // Which OI PLAY song triggers exit from passthrough to interpreter/managed mode.
 // Can be overridden via build flags: -DHANDSHAKE_SONG=<n>
@@ -15,18 +20,172 @@ static bool g_passthrough = false;
 #define HANDSHAKE_SONG 12
 #endif
 static const uint8_t OI_PLAY = 141;
+static const uint8_t OI_DRIVE_DIRECT = 145;
 static int handshakeState = 0; // 0=normal, 1=seen OI_PLAY awaiting song byte
+// Control escape (protocol.md): FF 00 !<cmd>\n while bridging
+static const uint8_t ESC_PREFIX0 = 0xFF;
+static const uint8_t ESC_PREFIX1 = 0x00;
+// 0=normal, 1=seen 0xFF, 2=collecting control line, 3=discarding overlong
+// line, 4=seen 0xFF 0x00 awaiting '!'
+static int escapeState = 0;
+#if !DUAL_CDC
+static char escBuf[32];
+static uint8_t escLen = 0;
+#endif
+// Host → robot command framing, used to hold back motion commands under ESTOP
+static OiFramer hostFramer = { 0, 0, 0 };
+static bool droppingCommand = false;
+static uint32_t bytesToRobot = 0;
+static uint32_t bytesToHost = 0;
+static uint32_t h2rStalls = 0;
+// Burst size for the dual-port bridge copy loops
+static const uint8_t BRIDGE_CHUNK = 32;
+// Latest-wins drive shaping under UART congestion (!coalesce,<0|1>)
+#ifndef BRIDGE_COALESCE
+#define BRIDGE_COALESCE 0
+#endif
+static bool coalesce = BRIDGE_COALESCE;
+static OiShaper shaper;
+// Dwell of bridged bytes, from first seen waiting to handed to the other side
+static DwellQueue h2rDwell;
+static DwellQueue r2hDwell;
+// Host bytes written during the current pump (sampled once at its end)
+static uint16_t h2rOut = 0;
+
+// Bytes that left the shaper other than by being sent
+static void shaperDropped(uint8_t before) {
+  if (shaper.len < before) dwellDrop(h2rDwell, before - shaper.len);
+}
+
+static void shaperPush(uint8_t b) {
+  uint8_t before = shaper.len + 1;
+  oiShaperPush(shaper, b);
+  shaperDropped(before); // coalesced
+}
+
+static void shaperWrite(uint8_t n) {
+  CREATE_SERIAL.write(shaper.buf, n);
+  oiShaperConsume(shaper, n);
+  dwellOut(h2rDwell, n, tbTicks());
+}
+
+// Move staged host commands to the UART as far as it has room
+static void drainShaper() {
+  if (shaper.len == 0) return;
+  if (estopActive()) {
+    uint8_t before = shaper.len;
+    oiShaperDropDrives(shaper);
+    shaperDropped(before);
+  }
+  int room = CREATE_SERIAL.availableForWrite();
+  uint8_t n = room < (int)shaper.len ? (room > 0 ? (uint8_t)room : 0) : shaper.len;
+  if (n) shaperWrite(n);
+}
+
+// Room for host bytes right now: in the shaper when coalescing, else in the UART
+static int hostRoom() {
+  return coalesce ? oiShaperRoom(shaper) : CREATE_SERIAL.availableForWrite();
+}
+
+// Give up staged commands; what is already on the wire is finished first
+static void flushShaper() {
+  uint8_t before = shaper.len;
+  oiShaperDropPending(shaper);
+  shaperDropped(before);
+  if (shaper.len) shaperWrite(shaper.len);
+}
+
+// Complete the command the robot is parsing with zero data bytes
+static void padToRobot(OiFramer &f) {
+  while (f.remaining > 0 || f.lenState != 0) {
+    CREATE_SERIAL.write((uint8_t)0);
+    oiFramerFeed(f, 0);
+  }
+}
+
+bool passthroughMidCommand() {
+  if (!g_passthrough) return false;
+  if (coalesce) return shaper.headStarted;
+  return !droppingCommand && (hostFramer.remaining > 0 || hostFramer.lenState != 0);
+}
+
+void passthroughFinishCommand() {
+  if (!g_passthrough) return;
+  bool hostOpen = hostFramer.remaining > 0 || hostFramer.lenState != 0;
+  if (coalesce) {
+    // Whatever of the head command is staged goes out; then the shaper's
+    // framer knows what the robot is still owed
+    flushShaper();
+    padToRobot(shaper.framer);
+    oiShaperReset(shaper);
+  } else if (hostOpen && !droppingCommand) {
+    OiFramer f = hostFramer;
+    padToRobot(f);
+  }
+  if (hostOpen) droppingCommand = true;
+}
+
+#if !DUAL_CDC
+// Forward one byte to the robot unless it belongs to a drive command issued
+// while ESTOP is latched.
+static void forwardToRobot(uint8_t b) {
+  if (oiFramerFeed(hostFramer, b)) {
+    droppingCommand = estopActive() && oiIsMotionOpcode(b);
+  }
+  if (droppingCommand) {
+    dwellDrop(h2rDwell, 1);
+    return;
+  }
+  bytesToRobot++;
+  if (coalesce) {
+    shaperPush(b);
+    drainShaper();
+    return;
+  }
+  CREATE_SERIAL.write(b);
+  h2rOut++;
+}
+#else
+// Forward a burst in one write. The framer still sees every byte so drive
+// frames can be held back under ESTOP; kept bytes are compacted in place.
+static void forwardBurstToRobot(uint8_t* buf, uint8_t n) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < n; ++i) {
+    uint8_t b = buf[i];
+    if (oiFramerFeed(hostFramer, b)) {
+      droppingCommand = estopActive() && oiIsMotionOpcode(b);
+    }
+    if (!droppingCommand) buf[kept++] = b;
+  }
+  bytesToRobot += kept;
+  dwellDrop(h2rDwell, n - kept);
+  if (coalesce) {
+    for (uint8_t i = 0; i < kept; ++i) shaperPush(buf[i]);
+    drainShaper();
+    return;
+  }
+  if (kept) CREATE_SERIAL.write(buf, kept);
+  h2rOut += kept;
+}
+#endif
 
 void passthroughEnable() {
   if (!g_passthrough) {
+    oiFramerReset(hostFramer);
+    oiShaperReset(shaper);
+    dwellRestart(h2rDwell);
+    dwellRestart(r2hDwell);
+    droppingCommand = false;
     g_passthrough = true;
-    tx_paused = true;
+    // Lines keep flowing when they have a port of their own
+    tx_paused = !DUAL_CDC;
     pauseSensorStream();
   }
 }
 
 void passthroughDisable() {
   if (g_passthrough) {
+    if (coalesce) flushShaper();
     g_passthrough = false;
     tx_paused = false;
     resumeSensorStream();
@@ -34,6 +193,33 @@ void passthroughDisable() {
 }
 
 bool passthroughActive() { return g_passthrough; }
+uint32_t passthroughBytesToRobot() { return bytesToRobot; }
+uint32_t passthroughBytesToHost() { return bytesToHost; }
+uint32_t passthroughStalls() { return h2rStalls; }
+void passthroughSetCoalesce(bool on) {
+  if (on == coalesce) return;
+  if (!on) flushShaper();
+  else oiShaperReset(shaper);
+  coalesce = on;
+}
+bool passthroughCoalesce() { return coalesce; }
+uint16_t passthroughCoalesced() { return shaper.coalesced; }
+const DwellQueue &passthroughDwellToRobot() { return h2rDwell; }
+const DwellQueue &passthroughDwellToHost() { return r2hDwell; }
+void passthroughDwellClear() {
+  dwellClear(h2rDwell);
+  dwellClear(r2hDwell);
+}
+
+void passthroughLinkChanged(bool hostPresent) {
+  if (hostPresent || !g_passthrough) return;
+  // Drop any half-parsed escape/handshake and stop the wheels
+  handshakeState = 0;
+  escapeState = 0;
+  passthroughFinishCommand();
+  const uint8_t stop[] = { OI_DRIVE_DIRECT, 0, 0, 0, 0 };
+  CREATE_SERIAL.write(stop, sizeof(stop));
+}
 
 // Notify core when USB activity occurs (defined in main.cpp for UART build; stubbed in tests)
 extern void usbLinkActivity();
@@ -41,13 +227,122 @@ extern void usbLinkActivity();
 // Extern hook to enter managed mode when handshake is detected (implemented in main.cpp)
 extern void enterForebrainModeFromPassthrough(uint8_t songId);
 
+#if !DUAL_CDC
+// Feed one host byte through the escape detector. Returns true when the byte
+// was consumed as part of a control line.
+static bool escapeByte(uint8_t b) {
+  if (escapeState == 3) {
+    if (b == '\n' || b == '\r') escapeState = 0;
+    dwellDrop(h2rDwell, 1);
+    return true;
+  }
+  if (escapeState == 2) {
+    dwellDrop(h2rDwell, 1);
+    if (b == '\n' || b == '\r') {
+      escBuf[escLen] = '\0';
+      if (escLen > 0) controlHandleLine(escBuf);
+      escLen = 0;
+      escapeState = 0;
+    } else if ((unsigned)escLen + 1 < sizeof(escBuf)) {
+      escBuf[escLen++] = (char)b;
+    } else {
+      // overflow; drop the rest of the line
+      escLen = 0;
+      escapeState = 3;
+    }
+    return true;
+  }
+  if (escapeState == 4) {
+    escapeState = 0;
+    if (b == '!') {
+      escapeState = 2;
+      escBuf[0] = '!';
+      escLen = 1;
+      dwellDrop(h2rDwell, 3);
+      return true;
+    }
+    // Not an escape: the held bytes are ordinary OI data
+    forwardToRobot(ESC_PREFIX0);
+    forwardToRobot(ESC_PREFIX1);
+  }
+  if (escapeState == 1) {
+    escapeState = 0;
+    if (b == ESC_PREFIX1) {
+      escapeState = 4;
+      return true;
+    }
+    forwardToRobot(ESC_PREFIX0);
+  }
+  // Only between OI commands: FF 00 is ordinary data inside one (e.g. a
+  // negative drive speed)
+  bool betweenCommands = hostFramer.remaining == 0 && hostFramer.lenState == 0;
+  if (b == ESC_PREFIX0 && handshakeState == 0 && betweenCommands) {
+    escapeState = 1;
+    return true;
+  }
+  return false;
+}
+#endif
+
 void passthroughPump() {
-  // Host → Robot
-  while (g_passthrough && Serial.available()) {
+  // Start dwell clocks for bytes that arrived since the previous pass
+  uint32_t now = tbTicks();
+  dwellSeen(h2rDwell, (uint16_t)Serial.available(), now);
+  dwellSeen(r2hDwell, (uint16_t)CREATE_SERIAL.available(), now);
+#if DUAL_CDC
+  // Dedicated bridge port: no escapes or handshakes to look for
+  uint8_t buf[BRIDGE_CHUNK];
+  int n;
+  if (coalesce) drainShaper();
+  while (g_passthrough && (n = Serial.available()) > 0) {
+    if (n > h2rDwell.unread) dwellSeen(h2rDwell, (uint16_t)n, tbTicks());
+    // Never more than the UART can take without blocking; the rest waits
+    // in the USB endpoint
+    int room = hostRoom();
+    if (room <= 0) {
+      h2rStalls++;
+      break;
+    }
+    if (n > room) n = room;
+    if (n > BRIDGE_CHUNK) n = BRIDGE_CHUNK;
+    for (int i = 0; i < n; ++i) buf[i] = (uint8_t)Serial.read();
+    dwellRead(h2rDwell, (uint16_t)n);
+    usbLinkActivity();
+    forwardBurstToRobot(buf, (uint8_t)n);
+  }
+  if (h2rOut) {
+    dwellOut(h2rDwell, h2rOut, tbTicks());
+    h2rOut = 0;
+  }
+  if (!g_passthrough) return;
+  while ((n = CREATE_SERIAL.available()) > 0) {
+    if (n > r2hDwell.unread) dwellSeen(r2hDwell, (uint16_t)n, tbTicks());
+    if (n > BRIDGE_CHUNK) n = BRIDGE_CHUNK;
+    for (int i = 0; i < n; ++i) buf[i] = (uint8_t)CREATE_SERIAL.read();
+    dwellRead(r2hDwell, (uint16_t)n);
+    usbLinkActivity();
+    Serial.write(buf, n);
+    bytesToHost += n;
+    dwellOut(r2hDwell, (uint16_t)n, tbTicks());
+  }
+#else
+  // Host → Robot, only as fast as the UART drains: unread bytes stay in the
+  // USB endpoint and the CDC NAKs push back on the host. One byte can
+  // release held ones (0xFF 0x00 or OI_PLAY), so keep room for three.
+  if (coalesce) drainShaper();
+  int avail;
+  while (g_passthrough && (avail = Serial.available()) > 0) {
+    if (hostRoom() < 3) {
+      h2rStalls++;
+      break;
+    }
+    if (h2rDwell.unread == 0) dwellSeen(h2rDwell, (uint16_t)avail, tbTicks());
     int c = Serial.read();
     if (c >= 0) {
+      dwellRead(h2rDwell, 1);
       usbLinkActivity(); // mark USB as active without emitting any messages
       uint8_t b = (uint8_t)c;
+      if (escapeByte(b)) continue;
       // Detect OI_PLAY,<HANDSHAKE_SONG> pattern; swallow it and exit passthrough
       if (handshakeState == 0) {
         if (b == OI_PLAY) {
@@ -56,33 +351,45 @@ void passthroughPump() {
           continue;
         }
         // Normal byte passthrough
-        CREATE_SERIAL.write(b);
+        forwardToRobot(b);
       } else if (handshakeState == 1) {
         // This byte is the song id
         if (b == (uint8_t)HANDSHAKE_SONG) {
           // Swallow the handshake and switch to managed mode
           handshakeState = 0;
+          dwellDrop(h2rDwell, 2);
           enterForebrainModeFromPassthrough(b);
           passthroughDisable();
           break;
         } else {
           // Not our handshake. Forward both bytes (OI_PLAY and this id)
-          CREATE_SERIAL.write(OI_PLAY);
-          CREATE_SERIAL.write(b);
+          forwardToRobot(OI_PLAY);
+          forwardToRobot(b);
           handshakeState = 0;
         }
       }
     }
   }
+  if (h2rOut) {
+    dwellOut(h2rDwell, h2rOut, tbTicks());
+    h2rOut = 0;
+  }
   if (!g_passthrough) return;
 
   // Robot → Host
-  while (CREATE_SERIAL.available()) {
+  uint16_t out = 0;
+  while ((avail = CREATE_SERIAL.available()) > 0) {
+    if (r2hDwell.unread == 0) dwellSeen(r2hDwell, (uint16_t)avail, tbTicks());
     int c = CREATE_SERIAL.read();
     if (c >= 0) {
+      dwellRead(r2hDwell, 1);
       // Writing to USB also implies link is up; mark activity
       usbLinkActivity();
       Serial.write((uint8_t)c);
+      bytesToHost++;
+      out++;
     }
   }
+  if (out) dwellOut(r2hDwell, out, tbTicks());
+#endif
 }
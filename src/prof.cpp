@@ -0,0 +1,179 @@
+#include "prof.h"
+#include "cdc_ctl.h"
+#include <Arduino.h>
+
+struct ProfBucket {
+  uint16_t tag;   // pc >> PROF_SHIFT
+  uint16_t count; // 0 = empty slot
+};
+
+// Linear probes before a sample is counted as dropped
+static const uint8_t PROF_PROBES = 4;
+
+static ProfBucket buckets[PROF_BUCKETS];
+static volatile bool running = false;
+static volatile uint32_t samples = 0;
+static volatile uint16_t dropped = 0;
+static uint16_t sampleHz = 0;
+
+#if defined(ENABLE_PROF) && defined(__AVR__)
+#include <avr/interrupt.h>
+#define PROF_LOCK() uint8_t sreg_ = SREG; cli()
+#define PROF_UNLOCK() SREG = sreg_
+// Timer1 ticks (F_CPU/8) between samples
+static uint16_t periodTicks = 0;
+static uint8_t lfsr = 0xA5;
+#else
+#define PROF_LOCK() do {} while (0)
+#define PROF_UNLOCK() do {} while (0)
+#endif
+
+void profSample(uint16_t pc) {
+  if (!running) return;
+  samples++;
+  uint16_t tag = (uint16_t)(pc >> PROF_SHIFT);
+  // Fibonacci hash of the bucket tag
+  uint8_t h = (uint8_t)((uint16_t)(tag * 40503u) >> 8) & (PROF_BUCKETS - 1);
+  for (uint8_t i = 0; i < PROF_PROBES; ++i) {
+    ProfBucket &b = buckets[(h + i) & (PROF_BUCKETS - 1)];
+    if (b.count == 0) {
+      b.tag = tag;
+      b.count = 1;
+      return;
+    }
+    if (b.tag == tag) {
+      if (b.count != 0xFFFF) b.count++;
+      return;
+    }
+  }
+  if (dropped != 0xFFFF) dropped++;
+}
+
+#if defined(ENABLE_PROF) && defined(__AVR__)
+// C entry for the naked ISR below: sample, then schedule the next compare.
+extern "C" void profIsrSample(uint16_t pc) __attribute__((used));
+extern "C" void profIsrSample(uint16_t pc) {
+  profSample(pc);
+  // Galois LFSR: +/- ~6% jitter on the period
+  lfsr = (uint8_t)((lfsr >> 1) ^ (-(lfsr & 1) & 0xB8));
+  OCR1B += periodTicks - (periodTicks >> 4) + (uint16_t)(((uint32_t)(periodTicks >> 3) * lfsr) >> 8);
+}
+
+// Naked so the return address can be found at a fixed stack offset: save the
+// registers a C call may clobber (15 bytes), then the interrupted PC sits at
+// SP+16 (high) and SP+17 (low) as a word address.
+ISR(TIMER1_COMPB_vect, ISR_NAKED) {
+  asm volatile(
+      "push r0\n\t"
+      "in r0, __SREG__\n\t"
+      "push r0\n\t"
+      "push r1\n\t"
+      "clr r1\n\t"
+      "push r18\n\t" "push r19\n\t" "push r20\n\t" "push r21\n\t" "push r22\n\t"
+      "push r23\n\t" "push r24\n\t" "push r25\n\t" "push r26\n\t" "push r27\n\t"
+      "push r30\n\t" "push r31\n\t"
+      "in r30, __SP_L__\n\t"
+      "in r31, __SP_H__\n\t"
+      "ldd r25, Z+16\n\t"
+      "ldd r24, Z+17\n\t"
+      "call profIsrSample\n\t"
+      "pop r31\n\t" "pop r30\n\t"
+      "pop r27\n\t" "pop r26\n\t" "pop r25\n\t" "pop r24\n\t" "pop r23\n\t"
+      "pop r22\n\t" "pop r21\n\t" "pop r20\n\t" "pop r19\n\t" "pop r18\n\t"
+      "pop r1\n\t"
+      "pop r0\n\t"
+      "out __SREG__, r0\n\t"
+      "pop r0\n\t"
+      "reti\n\t");
+}
+#endif
+
+static void profClear(uint16_t hz) {
+  for (uint8_t i = 0; i < PROF_BUCKETS; ++i) buckets[i].count = 0;
+  samples = 0;
+  dropped = 0;
+  sampleHz = hz;
+}
+
+bool profStart(uint16_t hz) {
+  if (hz < 50) hz = 50;
+#if defined(ENABLE_PROF) && defined(__AVR__)
+  PROF_LOCK();
+  profClear(hz);
+  periodTicks = (uint16_t)((F_CPU / 8) / hz);
+  // Timer1 free-running (normal mode, /8) as set up by the timebase; this is
+  // a no-op when it already runs. Compare B schedules each sample.
+  TCCR1A = 0;
+  TCCR1B = (1 << CS11);
+  OCR1B = TCNT1 + periodTicks;
+  TIFR1 = (1 << OCF1B);
+  TIMSK1 |= (1 << OCIE1B);
+  running = true;
+  PROF_UNLOCK();
+  return true;
+#elif !defined(ARDUINO)
+  // Native tests feed profSample() directly
+  profClear(hz);
+  running = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void profStop() {
+#if defined(ENABLE_PROF) && defined(__AVR__)
+  TIMSK1 &= (uint8_t)~(1 << OCIE1B);
+#endif
+  running = false;
+}
+
+bool profRunning() { return running; }
+
+uint32_t profSamples() {
+  PROF_LOCK();
+  uint32_t n = samples;
+  PROF_UNLOCK();
+  return n;
+}
+
+uint16_t profDropped() {
+  PROF_LOCK();
+  uint16_t d = dropped;
+  PROF_UNLOCK();
+  return d;
+}
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+void profDump() {
+  uint32_t n = profSamples();
+  uint16_t d = profDropped();
+  // Header: PROF,<running>,<samples>,<dropped>,<hz>,<shift>
+  CONTROL_SERIAL.print("PROF,");
+  CONTROL_SERIAL.print(running ? "1," : "0,");
+  CONTROL_SERIAL.print((unsigned long)n);
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.print((unsigned long)d);
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.print((unsigned long)sampleHz);
+  CONTROL_SERIAL.print(",");
+  CONTROL_SERIAL.println((unsigned long)PROF_SHIFT);
+  // One line per used bucket: PROF,<byte address hex>,<count>
+  for (uint8_t i = 0; i < PROF_BUCKETS; ++i) {
+    PROF_LOCK();
+    ProfBucket b = buckets[i];
+    PROF_UNLOCK();
+    if (b.count == 0) continue;
+    uint32_t addr = ((uint32_t)b.tag << PROF_SHIFT) << 1;
+    char line[5 + 6 + 1];
+    char* p = line;
+    *p++ = 'P'; *p++ = 'R'; *p++ = 'O'; *p++ = 'F'; *p++ = ',';
+    for (int8_t s = 20; s >= 0; s -= 4) *p++ = HEX_DIGITS[(addr >> s) & 0x0F];
+    *p = '\0';
+    CONTROL_SERIAL.print(line);
+    CONTROL_SERIAL.print(",");
+    CONTROL_SERIAL.println((unsigned long)b.count);
+  }
+  CONTROL_SERIAL.println("PROF,end");
+}
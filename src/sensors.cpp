@@ -1,11 +1,17 @@
 // Read Create 1 sensors via the Open Interface (OI)
 // Reference: OI opcode 142 (Sensors), with packet IDs such as 7 (Bumps/Wheel Drops)
 // and 9-12 (Cliff Left, Front Left, Front Right, Right). Each of these packets
-// returns one byte where non-zero means the event is active.
+// returns one byte where non-zero means the event is active; 19 (Distance)
+// and 20 (Angle) return a signed 16-bit delta, 22-26 (Voltage, Current,
+// Charge, Capacity) 16-bit values, high byte first.
 
 #include "sensors.h"
+#include "cdc_ctl.h"
+#include "energy.h"
+#include "fdr.h"
 #include "utils.h"
 #include <Arduino.h>
+#include <math.h>
 
 // Select the hardware serial used to talk to the Create OI.
 #ifndef CREATE_SERIAL
@@ -38,8 +44,23 @@ static void bumperIsr() {
 static bool cachedBumpLeft = false;
 static bool cachedBumpRight = false;
 static bool cachedCliffL = false, cachedCliffFL = false, cachedCliffFR = false, cachedCliffR = false;
+static uint8_t cachedWheelDrops = 0;
+static uint8_t cachedOvercurrents = 0;
+// Odometry accumulated since the last sensorsTakeOdometry()
+static int16_t odomDistMm = 0, odomAngleDeg = 0;
+static uint8_t odomSamples = 0;
+// Heading from summed angle deltas, wrapped to -180..179
+static int16_t headingDeg = 0;
+// Dead-reckoned pose since boot: position from each distance sample along the
+// heading at the time, and unwrapped totals for rates
+static float poseXMm = 0, poseYMm = 0;
+static int32_t travelMm = 0, turnDeg = 0;
+static const float RAD_PER_DEG = 0.017453293f;
+static uint16_t cachedVoltageMv = 0;
+static int16_t cachedCurrentMa = 0;
+static uint16_t cachedChargeMah = 0, cachedCapacityMah = 0;
 
-// Stream single-byte packets only to keep parsing simple:
+// Streamed packets:
 //  - 7  = Bumps/Wheel Drops (1 byte)
 //  - 9  = Cliff Left (1 byte)
 //  - 10 = Cliff Front Left (1 byte)
@@ -47,11 +68,25 @@ static bool cachedCliffL = false, cachedCliffFL = false, cachedCliffFR = false,
 //  - 12 = Cliff Right (1 byte)
 //  - 18 = Buttons (1 byte)
 //  - 8  = Wall (boolean, 1 byte)
-static const uint8_t requestedPackets[] = { 7, 9, 10, 11, 12, 18, 8 };
+//  - 14 = Overcurrents (1 byte)
+//  - 19 = Distance (mm since last sample, 2 bytes)
+//  - 20 = Angle (degrees since last sample, 2 bytes)
+//  - 22 = Voltage (mV, 2 bytes)
+//  - 23 = Current (mA, negative while discharging, 2 bytes)
+//  - 25 = Battery Charge (mAh, 2 bytes)
+//  - 26 = Battery Capacity (mAh, 2 bytes)
+static const uint8_t requestedPackets[] = { 7, 9, 10, 11, 12, 18, 8, 14, 19, 20, 22, 23, 25, 26 };
 static unsigned long lastStreamMs = 0;
 // Pair parser state: expect value after seeing an ID
 static bool expectValue = false;
 static uint8_t currentId = 0;
+static uint8_t valueLeft = 0;   // value bytes still to come for currentId
+static uint16_t valueAcc = 0;
+// Stream frame framing: 19, <len>, <len bytes of id/value>, checksum. Inside
+// a frame 19 is the Distance id; outside, bare id/value pairs are accepted.
+static bool expectLen = false;
+static bool inFrame = false;
+static uint8_t frameLeft = 0;   // body bytes still to come
 // Cached wall and button edges
 static bool cachedWall = false;
 static uint8_t lastButtons = 0;
@@ -67,6 +102,8 @@ static bool prevBumpLeft = false, prevBumpRight = false;
 static bool prevCliffL = false, prevCliffFL = false, prevCliffFR = false, prevCliffR = false;
 static bool prevWall = false;
 static uint8_t prevButtons = 0;
+// SENS_CHG_* bits accumulated until telemetry picks them up
+static uint8_t changeMask = 0;
 
 // Polling helpers removed in minimal stream parser build
 
@@ -86,10 +123,11 @@ void beginSensorStream() {
   // Reset parser state and drain any stale bytes
   expectValue = false;
   currentId = 0;
+  expectLen = inFrame = false;
   streamPaused = false;
   while (CREATE_SERIAL.available()) { (void)CREATE_SERIAL.read(); }
 #ifdef ENABLE_DEBUG
-  Serial.println("[SENS] OI stream started (7,9,10,11,12,18,8)");
+  CONTROL_SERIAL.println("[SENS] OI stream started (7,9,10,11,12,18,8,14,19,20,22,23,25,26)");
 #endif
 }
 
@@ -100,7 +138,7 @@ void pauseSensorStream() {
     CREATE_SERIAL.write((uint8_t)0);
     streamPaused = true;
 #ifdef ENABLE_DEBUG
-    Serial.println("[SENS] stream PAUSE");
+    CONTROL_SERIAL.println("[SENS] stream PAUSE");
 #endif
   }
 }
@@ -112,36 +150,83 @@ void resumeSensorStream() {
     CREATE_SERIAL.write((uint8_t)1);
     streamPaused = false;
 #ifdef ENABLE_DEBUG
-    Serial.println("[SENS] stream RESUME");
+    CONTROL_SERIAL.println("[SENS] stream RESUME");
 #endif
   }
 }
 
+void sensorsResync() {
+  expectValue = false;
+  currentId = 0;
+  expectLen = inFrame = false;
+  // Only refresh a stream that was alive; a dead OI must still time out
+  if (lastStreamMs != 0) lastStreamMs = millis();
+}
+
 void updateSensorStream() {
   while (CREATE_SERIAL.available()) {
     int bi = CREATE_SERIAL.read();
     if (bi < 0) break;
     uint8_t b = (uint8_t)bi;
-    // Skip frame header and immediate len if present
-    if (!expectValue && b == 19) {
-      // consume len if present; if not yet available, try next loop
-      if (CREATE_SERIAL.available()) (void)CREATE_SERIAL.read();
+    if (expectLen) {
+      expectLen = false;
+      inFrame = true;
+      frameLeft = b;
       continue;
     }
-    // Ignore lone len marker occasionally observed
-    if (!expectValue && b == 14) {
+    if (inFrame) {
+      if (frameLeft == 0) {
+        // Checksum: the frame is over, realign on the next header
+        inFrame = false;
+        expectValue = false;
+        continue;
+      }
+      frameLeft--;
+    } else if (!expectValue && b == 19) {
+      expectLen = true;
       continue;
     }
     if (!expectValue) {
       switch (b) {
-        case 7: case 8: case 9: case 10: case 11: case 12: case 18:
-          currentId = b; expectValue = true; break;
+        case 7: case 8: case 9: case 10: case 11: case 12: case 14: case 18:
+          currentId = b; expectValue = true; valueLeft = 1; valueAcc = 0; break;
+        case 19: case 20: case 22: case 23: case 25: case 26:
+          currentId = b; expectValue = true; valueLeft = 2; valueAcc = 0; break;
         default: break; // ignore noise/opcodes
       }
     } else {
-      uint8_t val = b;
+      valueAcc = (uint16_t)((valueAcc << 8) | b);
+      if (--valueLeft > 0) continue;
+      uint8_t val = (uint8_t)valueAcc;
       switch (currentId) {
-        case 7:  cachedBumpRight = (val & 0x01) != 0; cachedBumpLeft = (val & 0x02) != 0; break;
+        case 7:
+          cachedBumpRight = (val & 0x01) != 0; cachedBumpLeft = (val & 0x02) != 0;
+          cachedWheelDrops = (uint8_t)((val >> 2) & 0x07);
+          break;
+        case 14: cachedOvercurrents = val; break;
+        case 19:
+          odomDistMm = (int16_t)(odomDistMm + (int16_t)valueAcc);
+          if (odomSamples < 255) odomSamples++;
+          travelMm += (int16_t)valueAcc;
+          poseXMm += (int16_t)valueAcc * cosf(headingDeg * RAD_PER_DEG);
+          poseYMm += (int16_t)valueAcc * sinf(headingDeg * RAD_PER_DEG);
+          energyDistance((int16_t)valueAcc);
+          break;
+        case 22: cachedVoltageMv = valueAcc; break;
+        case 23:
+          cachedCurrentMa = (int16_t)valueAcc;
+          energySample(cachedVoltageMv, cachedCurrentMa, millis());
+          break;
+        case 25: cachedChargeMah = valueAcc; break;
+        case 26: cachedCapacityMah = valueAcc; break;
+        case 20: {
+          int16_t a = (int16_t)valueAcc;
+          odomAngleDeg = (int16_t)(odomAngleDeg + a);
+          turnDeg += a;
+          int32_t h = ((int32_t)headingDeg + a + 180) % 360;
+          headingDeg = (int16_t)((h < 0 ? h + 360 : h) - 180);
+          break;
+        }
         case 8:  cachedWall = (val != 0); break;
         case 9:  cachedCliffL  = (val != 0); break;
         case 10: cachedCliffFL = (val != 0); break;
@@ -156,16 +241,25 @@ void updateSensorStream() {
                      (cachedCliffFR != prevCliffFR) || (cachedCliffR != prevCliffR) ||
                      (cachedWall != prevWall) || (lastButtons != prevButtons);
       if (changed) {
+        if (cachedBumpLeft != prevBumpLeft || cachedBumpRight != prevBumpRight) changeMask |= SENS_CHG_BUMPS;
+        if (cachedCliffL != prevCliffL || cachedCliffFL != prevCliffFL ||
+            cachedCliffFR != prevCliffFR || cachedCliffR != prevCliffR) changeMask |= SENS_CHG_CLIFFS;
+        if (cachedWall != prevWall) changeMask |= SENS_CHG_WALL;
+        if (lastButtons != prevButtons) changeMask |= SENS_CHG_BUTTONS;
+        fdrRecord(FDR_SENSORS, sensorsPackedState(), lastButtons);
+        bool cliffNow = cachedCliffL || cachedCliffFL || cachedCliffFR || cachedCliffR;
+        bool cliffPrev = prevCliffL || prevCliffFL || prevCliffFR || prevCliffR;
+        if (cliffNow && !cliffPrev) fdrTrigger(FDR_TRIG_CLIFF);
 #ifdef ENABLE_DEBUG
-        Serial.print("[SENS] stream bumps L="); Serial.print((int)cachedBumpLeft);
-        Serial.print(" R="); Serial.print((int)cachedBumpRight);
-        Serial.print(" cliffs=");
-        Serial.print((int)cachedCliffL); Serial.print(",");
-        Serial.print((int)cachedCliffFL); Serial.print(",");
-        Serial.print((int)cachedCliffFR); Serial.print(",");
-        Serial.print((int)cachedCliffR);
-        Serial.print(" wall="); Serial.print((int)cachedWall);
-        Serial.print(" btn="); Serial.println((int)lastButtons);
+        CONTROL_SERIAL.print("[SENS] stream bumps L="); CONTROL_SERIAL.print((int)cachedBumpLeft);
+        CONTROL_SERIAL.print(" R="); CONTROL_SERIAL.print((int)cachedBumpRight);
+        CONTROL_SERIAL.print(" cliffs=");
+        CONTROL_SERIAL.print((int)cachedCliffL); CONTROL_SERIAL.print(",");
+        CONTROL_SERIAL.print((int)cachedCliffFL); CONTROL_SERIAL.print(",");
+        CONTROL_SERIAL.print((int)cachedCliffFR); CONTROL_SERIAL.print(",");
+        CONTROL_SERIAL.print((int)cachedCliffR);
+        CONTROL_SERIAL.print(" wall="); CONTROL_SERIAL.print((int)cachedWall);
+        CONTROL_SERIAL.print(" btn="); CONTROL_SERIAL.println((int)lastButtons);
 #endif
       }
       prevBumpLeft = cachedBumpLeft; prevBumpRight = cachedBumpRight;
@@ -192,12 +286,12 @@ void initSensors() {
   if (irq != NOT_AN_INTERRUPT) {
     attachInterrupt(irq, bumperIsr, CHANGE);
 #ifdef ENABLE_DEBUG
-    Serial.print("[SENS] Bumper ISR attached on pin ");
-    Serial.println(BUMPER_PIN);
+    CONTROL_SERIAL.print("[SENS] Bumper ISR attached on pin ");
+    CONTROL_SERIAL.println(BUMPER_PIN);
 #endif
   } else {
 #ifdef ENABLE_DEBUG
-    Serial.println("[SENS] Bumper ISR not available on this pin");
+    CONTROL_SERIAL.println("[SENS] Bumper ISR not available on this pin");
 #endif
   }
 #  endif
@@ -214,10 +308,10 @@ bool bumperTriggered() {
   bool any = (cachedBumpLeft || cachedBumpRight);
   if (any) {
 #ifdef ENABLE_DEBUG
-    Serial.print("[SENS] bumperTriggered via stream L=");
-    Serial.print((int)cachedBumpLeft);
-    Serial.print(" R=");
-    Serial.println((int)cachedBumpRight);
+    CONTROL_SERIAL.print("[SENS] bumperTriggered via stream L=");
+    CONTROL_SERIAL.print((int)cachedBumpLeft);
+    CONTROL_SERIAL.print(" R=");
+    CONTROL_SERIAL.println((int)cachedBumpRight);
 #endif
   }
   return any;
@@ -227,18 +321,60 @@ bool cliffDetected() {
   bool any = (cachedCliffL || cachedCliffFL || cachedCliffFR || cachedCliffR);
   if (any) {
 #ifdef ENABLE_DEBUG
-    Serial.println("[SENS] cliff detected via stream");
+    CONTROL_SERIAL.println("[SENS] cliff detected via stream");
 #endif
   }
   return any;
 }
 
+uint8_t sensorsPackedState() {
+  return (uint8_t)((cachedBumpRight ? 0x01 : 0) | (cachedBumpLeft ? 0x02 : 0) |
+                   (cachedCliffL ? 0x04 : 0) | (cachedCliffFL ? 0x08 : 0) |
+                   (cachedCliffFR ? 0x10 : 0) | (cachedCliffR ? 0x20 : 0) |
+                   (cachedWall ? 0x40 : 0));
+}
+
+uint8_t sensorsButtons() { return lastButtons; }
+
+uint8_t sensorsWheelDrops() { return cachedWheelDrops; }
+
+uint8_t sensorsOvercurrents() { return cachedOvercurrents; }
+
+int16_t sensorsHeadingDeg() { return headingDeg; }
+
+uint16_t sensorsVoltageMv() { return cachedVoltageMv; }
+int16_t sensorsCurrentMa() { return cachedCurrentMa; }
+uint16_t sensorsChargeMah() { return cachedChargeMah; }
+uint16_t sensorsCapacityMah() { return cachedCapacityMah; }
+
+void sensorsPose(float &xMm, float &yMm, int32_t &travel, int32_t &turn) {
+  xMm = poseXMm;
+  yMm = poseYMm;
+  travel = travelMm;
+  turn = turnDeg;
+}
+
+uint8_t sensorsTakeOdometry(int16_t &distMm, int16_t &angleDeg) {
+  uint8_t n = odomSamples;
+  distMm = odomDistMm;
+  angleDeg = odomAngleDeg;
+  odomDistMm = odomAngleDeg = 0;
+  odomSamples = 0;
+  return n;
+}
+
+uint8_t sensorsChangeMaskAndClear() {
+  uint8_t m = changeMask;
+  changeMask = 0;
+  return m;
+}
+
 bool bumperEventTriggeredAndClear() {
   bool was = bumperEventFlag;
   bumperEventFlag = false;
   if (was) {
 #ifdef ENABLE_DEBUG
-    Serial.println("[SENS] bumper ISR event");
+    CONTROL_SERIAL.println("[SENS] bumper ISR event");
 #endif
   }
   return was;
@@ -264,6 +400,8 @@ void setBatteryPercentOverride(int pct) { battery_pct_override = pct; }
 
 int batteryPercent() {
   if (battery_pct_override >= 0) return battery_pct_override;
-  // TODO: query OI for real battery data
-  return 100;
+  // Full until the stream has reported a capacity
+  if (cachedCapacityMah == 0) return 100;
+  uint32_t pct = (uint32_t)cachedChargeMah * 100 / cachedCapacityMah;
+  return pct > 100 ? 100 : (int)pct;
 }
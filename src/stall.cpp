@@ -0,0 +1,124 @@
+#include "stall.h"
+#include "estop.h"
+#include "motion.h"
+#include "sensors.h"
+
+// Create 1 wheel base (mm)
+static const int32_t WHEEL_BASE_MM = 258;
+// Drive wheel bits of packet 14
+static const uint8_t OC_WHEELS = 0x18;
+// A window that never accumulates enough commanded travel is discarded
+static const unsigned long WINDOW_MAX_MS = 1500;
+
+static int16_t lastRight = 0, lastLeft = 0;
+static unsigned long lastMs = 0;
+static unsigned long settleUntil = 0;
+static unsigned long windowStart = 0;
+// Commanded travel this window: um and millidegrees
+static int32_t expectUm = 0, expectMdeg = 0;
+static int32_t measMm = 0, measDeg = 0;
+static uint16_t samples = 0;
+static unsigned long ocSince = 0;
+static bool ocActive = false;
+static uint16_t events = 0;
+
+static int sign(int32_t v) { return (v > 0) - (v < 0); }
+
+static void restartWindow(unsigned long nowMs) {
+  int16_t d, a;
+  (void)sensorsTakeOdometry(d, a);
+  expectUm = expectMdeg = 0;
+  measMm = measDeg = 0;
+  samples = 0;
+  windowStart = nowMs;
+}
+
+void stallReset() {
+  lastRight = lastLeft = 0;
+  lastMs = 0;
+  settleUntil = 0;
+  ocActive = false;
+  restartWindow(0);
+}
+
+static uint8_t fire(uint8_t reason, unsigned long nowMs) {
+  events++;
+  ocActive = false;
+  settleUntil = nowMs + STALL_SETTLE_MS;
+  restartWindow(nowMs);
+  return reason;
+}
+
+uint8_t stallUpdate(unsigned long nowMs) {
+  int16_t right, left;
+  motionLastSent(right, left);
+  // The ESTOP path stops the wheels behind motion's back
+  if (estopActive()) right = left = 0;
+  bool moving = right != 0 || left != 0;
+  unsigned long dt = lastMs ? nowMs - lastMs : 0;
+  lastMs = nowMs;
+
+  // Starting, stopping or reversing either component: let the wheels settle
+  if (sign(right + left) != sign(lastRight + lastLeft) ||
+      sign(right - left) != sign(lastRight - lastLeft)) {
+    settleUntil = nowMs + STALL_SETTLE_MS;
+    restartWindow(nowMs);
+  }
+  lastRight = right;
+  lastLeft = left;
+  if (!moving) {
+    ocActive = false;
+    return STALL_NONE;
+  }
+
+  if (sensorsWheelDrops()) return fire(STALL_WHEELDROP, nowMs);
+
+  if (sensorsOvercurrents() & OC_WHEELS) {
+    if (!ocActive) {
+      ocActive = true;
+      ocSince = nowMs;
+    } else if (nowMs - ocSince >= STALL_OC_MS) {
+      return fire(STALL_OVERCURRENT, nowMs);
+    }
+  } else {
+    ocActive = false;
+  }
+
+  if ((long)(nowMs - settleUntil) < 0) {
+    restartWindow(nowMs);
+    return STALL_NONE;
+  }
+  // mm/s * ms = um; millidegrees = (r - l) * ms * 180 / (pi * base)
+  expectUm += ((int32_t)right + left) / 2 * (int32_t)dt;
+  expectMdeg += ((int32_t)right - left) * (int32_t)dt * 222 / 1000;
+  int16_t d, a;
+  samples += sensorsTakeOdometry(d, a);
+  measMm += d;
+  measDeg += a;
+
+  bool linear = expectUm >= STALL_EXPECT_MM * 1000L || expectUm <= -STALL_EXPECT_MM * 1000L;
+  bool angular = expectMdeg >= STALL_EXPECT_DEG * 1000L || expectMdeg <= -STALL_EXPECT_DEG * 1000L;
+  if (!linear && !angular) {
+    if (nowMs - windowStart >= WINDOW_MAX_MS) restartWindow(nowMs);
+    return STALL_NONE;
+  }
+  // No stream data says nothing about motion
+  bool stuck = samples > 0;
+  // Moving along the commanded direction by at least a quarter of it
+  if (linear && measMm * sign(expectUm) * 4000 >= (expectUm < 0 ? -expectUm : expectUm)) stuck = false;
+  if (angular && measDeg * sign(expectMdeg) * 4000 >= (expectMdeg < 0 ? -expectMdeg : expectMdeg)) stuck = false;
+  if (stuck) return fire(STALL_SLIP, nowMs);
+  restartWindow(nowMs);
+  return STALL_NONE;
+}
+
+const char* stallReasonName(uint8_t reason) {
+  switch (reason) {
+    case STALL_SLIP:        return "slip";
+    case STALL_OVERCURRENT: return "overcurrent";
+    case STALL_WHEELDROP:   return "wheeldrop";
+    default:                return "none";
+  }
+}
+
+uint16_t stallEvents() { return events; }
@@ -0,0 +1,86 @@
+#include "telemetry.h"
+#include "proto.h"
+#include "sensors.h"
+#include "timebase.h"
+#include "tx.h"
+#include <Arduino.h>
+
+static bool keyframeDue = true;
+static uint32_t lastKeyframeMs = 0;
+static uint16_t keyframeMs = TELEM_KEYFRAME_MS;
+// ODOM period (0 = off) and the totals at the previous record, for rates
+static uint16_t odomPeriodMs = 0;
+static uint32_t lastOdomMs = 0;
+static uint32_t odomSeq = 0;
+static int32_t lastTravelMm = 0, lastTurnDeg = 0;
+static const float RAD_PER_DEG = 0.017453293f;
+
+void telemetryForceKeyframe() { keyframeDue = true; }
+
+void telemetrySetKeyframeMs(uint16_t ms) { keyframeMs = ms; }
+
+bool telemetrySetOdomHz(uint16_t hz) {
+  if (hz > TELEM_ODOM_MAX_HZ) return false;
+  odomPeriodMs = hz ? (uint16_t)(1000 / hz) : 0;
+  return true;
+}
+
+static void sendOdom(uint32_t now) {
+  float x, y;
+  int32_t travel, turn;
+  sensorsPose(x, y, travel, turn);
+  uint32_t dt = now - lastOdomMs;
+  // ODOM,<x_m>,<y_m>,<theta_rad>,<vx_mps>,<wz_radps>,<seq>
+  txBegin("ODOM");
+  txFloat(x * 0.001f, 3);
+  txFloat(y * 0.001f, 3);
+  txFloat(sensorsHeadingDeg() * RAD_PER_DEG, 3);
+  txFixed((travel - lastTravelMm) * 1000 / (int32_t)dt, 3); // mm/s as m/s
+  txFloat((turn - lastTurnDeg) * RAD_PER_DEG * 1000.0f / dt, 3);
+  txU32(++odomSeq);
+  txEndLine();
+  lastOdomMs = now;
+  lastTravelMm = travel;
+  lastTurnDeg = turn;
+}
+
+static void sendRecord(uint8_t mask) {
+  uint8_t packed = sensorsPackedState();
+  txBegin("SNS");
+  txU32(mask);
+  if (mask & SNS_BUMPS) {
+    // sensorsPackedState() has bit0 = right, bit1 = left
+    txU32(((packed & 0x02) ? PROTO_MASK_LEFT : 0) | ((packed & 0x01) ? PROTO_MASK_RIGHT : 0));
+  }
+  if (mask & SNS_CLIFFS) txU32((packed >> 2) & 0x0F);
+  if (mask & SNS_WALL) txU32((packed >> 6) & 0x01);
+  if (mask & SNS_BUTTONS) txU32(sensorsButtons());
+  txEndLine();
+}
+
+void telemetryTick() {
+  uint8_t changed = sensorsChangeMaskAndClear();
+  uint32_t now = tbMillis();
+  if (odomPeriodMs && now - lastOdomMs >= odomPeriodMs) sendOdom(now);
+  if (now - lastKeyframeMs >= keyframeMs) keyframeDue = true;
+  uint8_t mask;
+  if (keyframeDue) {
+    mask = SNS_KEYFRAME | SNS_BUMPS | SNS_CLIFFS | SNS_WALL | SNS_BUTTONS;
+  } else if (changed) {
+    mask = changed;
+  } else {
+    return;
+  }
+  uint16_t dropsBefore = txDroppedLines();
+  sendRecord(mask);
+  if (txDroppedLines() != dropsBefore) {
+    // The host never sees a dropped line (no eid is spent), so only a
+    // keyframe can repair its view; retry next loop.
+    keyframeDue = true;
+    return;
+  }
+  if (mask & SNS_KEYFRAME) {
+    keyframeDue = false;
+    lastKeyframeMs = now;
+  }
+}
@@ -0,0 +1,66 @@
+#include "timebase.h"
+#include <Arduino.h>
+
+#if defined(__AVR_ATmega32U4__)
+#include <avr/interrupt.h>
+
+// Ticks per millisecond at F_CPU/8
+static const uint16_t TICKS_PER_MS = (uint16_t)(F_CPU / 8 / 1000);
+
+static volatile uint16_t overflowHigh = 0;
+static volatile uint32_t msCount = 0;
+
+ISR(TIMER1_OVF_vect) {
+  overflowHigh++;
+}
+
+ISR(TIMER1_COMPA_vect) {
+  OCR1A += TICKS_PER_MS;
+  msCount++;
+}
+
+void initTimebase() {
+  uint8_t sreg = SREG;
+  cli();
+  TCCR1A = 0;
+  TCCR1B = (1 << CS11); // normal mode, /8
+  TCNT1 = 0;
+  OCR1A = TICKS_PER_MS;
+  overflowHigh = 0;
+  msCount = 0;
+  TIFR1 = (1 << TOV1) | (1 << OCF1A);
+  TIMSK1 |= (1 << TOIE1) | (1 << OCIE1A);
+  SREG = sreg;
+}
+
+uint32_t tbTicks() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t hi = overflowHigh;
+  uint16_t lo = TCNT1;
+  // Overflow pending but not yet serviced (we may be inside an ISR, or it
+  // happened between the two reads): the low half already wrapped.
+  if ((TIFR1 & (1 << TOV1)) && lo < 0x8000) hi++;
+  SREG = sreg;
+  return ((uint32_t)hi << 16) | lo;
+}
+
+uint32_t tbMillis() {
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t ms = msCount;
+  SREG = sreg;
+  return ms;
+}
+
+#else
+
+void initTimebase() {}
+
+uint32_t tbTicks() { return (uint32_t)micros() * TB_TICKS_PER_US; }
+
+uint32_t tbMillis() { return (uint32_t)(micros() / 1000); }
+
+#endif
+
+uint32_t tbMicros() { return tbTicks() / TB_TICKS_PER_US; }
@@ -0,0 +1,122 @@
+#include "traj.h"
+#include "estop.h"
+#include "motion.h"
+#include "timebase.h"
+#include "tx.h"
+
+static const int16_t MAX_MM_S = TRAJ_MAX_MM_S;
+// How long a moving last point is held before it counts as an underrun
+#ifndef TRAJ_GRACE_MS
+#define TRAJ_GRACE_MS 50
+#endif
+
+struct TrajPoint {
+  uint32_t t;
+  int16_t right;
+  int16_t left;
+};
+
+static TrajPoint points[TRAJ_POINTS];
+static uint8_t head = 0;
+static uint8_t count = 0;
+static bool running = false;
+// Last frame sent and the segment (start time) it belonged to
+static int16_t sentRight = 0, sentLeft = 0;
+static uint32_t sentMs = 0;
+static uint32_t sentSegment = 0;
+static uint16_t underruns = 0;
+static uint16_t late = 0;
+
+static int16_t clampSpeed(int32_t v) {
+  if (v > MAX_MM_S) return MAX_MM_S;
+  if (v < -MAX_MM_S) return -MAX_MM_S;
+  return (int16_t)v;
+}
+
+static TrajPoint &at(uint8_t i) { return points[(head + i) % TRAJ_POINTS]; }
+
+static void pop() {
+  head = (head + 1) % TRAJ_POINTS;
+  count--;
+}
+
+bool trajPush(uint32_t tMs, int16_t right, int16_t left) {
+  if (count == TRAJ_POINTS) return false;
+  if (count > 0 && (int32_t)(tMs - at(count - 1).t) <= 0) return false;
+  if ((int32_t)(tbMillis() - tMs) > 0) late++;
+  TrajPoint &p = at(count);
+  p.t = tMs;
+  p.right = clampSpeed(right);
+  p.left = clampSpeed(left);
+  count++;
+  return true;
+}
+
+bool trajPushTwist(uint32_t tMs, float vx, float wz) {
+  int16_t right, left;
+  motionTwistToWheels(vx, wz, right, left);
+  return trajPush(tMs, right, left);
+}
+
+void trajClear() {
+  head = 0;
+  count = 0;
+  if (running) motionHostDrive(0, 0);
+  running = false;
+}
+
+static void drive(int16_t right, int16_t left, uint32_t nowMs, uint32_t segment) {
+  if (running && right == sentRight && left == sentLeft) return;
+  // Within a segment, interpolated updates go out once per period; a new
+  // point goes out on time
+  if (running && segment == sentSegment && nowMs - sentMs < TRAJ_PERIOD_MS) return;
+  if (!motionHostDrive(right, left)) return;
+  running = true;
+  sentRight = right;
+  sentLeft = left;
+  sentMs = nowMs;
+  sentSegment = segment;
+}
+
+void trajTick(uint32_t nowMs) {
+  if (count == 0) return;
+  if (estopActive()) {
+    trajClear();
+    return;
+  }
+  // Skip to the segment that contains now
+  while (count > 1 && (int32_t)(nowMs - at(1).t) >= 0) pop();
+  const TrajPoint &p0 = at(0);
+  int32_t into = (int32_t)(nowMs - p0.t);
+  if (into < 0) return; // first point still ahead
+  if (count > 1) {
+    const TrajPoint &p1 = at(1);
+    int32_t span = (int32_t)(p1.t - p0.t);
+    int16_t r = (int16_t)(p0.right + (int32_t)(p1.right - p0.right) * into / span);
+    int16_t l = (int16_t)(p0.left + (int32_t)(p1.left - p0.left) * into / span);
+    drive(r, l, nowMs, p0.t);
+    return;
+  }
+  // Last point: a stop ends the trajectory, a moving one waits briefly for more
+  if (p0.right == 0 && p0.left == 0) {
+    drive(0, 0, nowMs, p0.t);
+    head = 0;
+    count = 0;
+    running = false;
+    return;
+  }
+  drive(p0.right, p0.left, nowMs, p0.t);
+  if (into <= TRAJ_GRACE_MS) return;
+  underruns++;
+  trajClear();
+  // TRAJ,underrun,<count>
+  txBegin("TRAJ");
+  txStr("underrun");
+  txU32(underruns);
+  txEndLine();
+}
+
+uint8_t trajDepth() { return count; }
+bool trajRunning() { return running; }
+uint16_t trajUnderruns() { return underruns; }
+uint16_t trajLate() { return late; }
@@ -0,0 +1,101 @@
+#include "trap.h"
+
+struct TrapBump {
+  unsigned long ms;
+  int16_t heading;
+  int8_t side;
+};
+
+static TrapBump history[TRAP_HISTORY];
+static uint8_t count = 0; // oldest first
+static bool active = false;
+static uint8_t level = TRAP_NONE;
+static unsigned long episodeStart = 0;
+static unsigned long lastBump = 0;
+static uint16_t episodes = 0;
+static uint32_t lastEscapeMs = 0;
+static uint32_t maxEscapeMs = 0;
+
+static void expire(unsigned long nowMs) {
+  uint8_t keep = 0;
+  while (keep < count && nowMs - history[keep].ms >= TRAP_WINDOW_MS) keep++;
+  if (keep == 0) return;
+  for (uint8_t i = keep; i < count; ++i) history[i - keep] = history[i];
+  count -= keep;
+}
+
+static int16_t headingDiff(int16_t a, int16_t b) {
+  int16_t d = (int16_t)((a - b) % 360);
+  if (d > 180) d -= 360;
+  if (d < -180) d += 360;
+  return d < 0 ? -d : d;
+}
+
+// Does the history (newest last) look like a trap?
+static bool patterned() {
+  if (count >= TRAP_DENSE_BUMPS) return true;
+  if (count < 3) return false;
+  // Corner: the last three sided bumps alternate
+  uint8_t flips = 0, sided = 0;
+  int8_t prev = 0;
+  for (uint8_t i = count; i-- > 0 && sided < 3;) {
+    if (history[i].side == 0) continue;
+    if (prev != 0 && history[i].side != prev) flips++;
+    prev = history[i].side;
+    sided++;
+  }
+  if (flips >= 2) return true;
+  // Cycle: two earlier bumps at the heading of this one
+  const TrapBump &last = history[count - 1];
+  uint8_t revisits = 0;
+  for (uint8_t i = 0; i + 1 < count; ++i) {
+    if (headingDiff(history[i].heading, last.heading) <= TRAP_HEADING_DEG) revisits++;
+  }
+  return revisits >= 2;
+}
+
+void trapReset() {
+  count = 0;
+  active = false;
+  level = TRAP_NONE;
+}
+
+uint8_t trapBump(int8_t side, int16_t headingDeg, unsigned long nowMs) {
+  expire(nowMs);
+  if (count == TRAP_HISTORY) {
+    for (uint8_t i = 1; i < TRAP_HISTORY; ++i) history[i - 1] = history[i];
+    count--;
+  }
+  history[count++] = { nowMs, headingDeg, side };
+  lastBump = nowMs;
+  if (active) {
+    // The last escape did not get us out
+    if (level < TRAP_WALL_FOLLOW) level++;
+  } else if (patterned()) {
+    active = true;
+    level = TRAP_WIDE_TURN;
+    episodeStart = history[0].ms;
+  }
+  return level;
+}
+
+uint8_t trapRecentBumps(unsigned long nowMs) {
+  expire(nowMs);
+  return count;
+}
+
+bool trapTick(unsigned long nowMs) {
+  if (!active || nowMs - lastBump < TRAP_CLEAR_MS) return false;
+  lastEscapeMs = lastBump - episodeStart;
+  if (lastEscapeMs > maxEscapeMs) maxEscapeMs = lastEscapeMs;
+  episodes++;
+  // The bumps that made up the trap say nothing about the next one
+  trapReset();
+  return true;
+}
+
+bool trapActive() { return active; }
+uint8_t trapLevel() { return level; }
+uint16_t trapEpisodes() { return episodes; }
+uint32_t trapLastEscapeMs() { return lastEscapeMs; }
+uint32_t trapMaxEscapeMs() { return maxEscapeMs; }
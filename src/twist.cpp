@@ -0,0 +1,164 @@
+#include "twist.h"
+#include "estop.h"
+#include "motion.h"
+#include "tx.h"
+
+// Drive frames while holding/decaying go out at most this often (the OI
+// updates every 15 ms)
+static const uint16_t FRAME_MS = 15;
+
+struct TwistCmd {
+  uint32_t seq;
+  uint32_t dueMs;
+  int16_t right;
+  int16_t left;
+};
+
+static TwistCmd slots[TWIST_SLOTS];
+static uint8_t queued = 0;           // oldest first
+static bool haveSeq = false;
+static uint32_t lastSeq = 0;
+static uint32_t lastArrivalMs = 0;
+// Jitter estimate in ms * 16 (RFC 3550 style running mean of |gap - period|)
+static uint32_t jitter16 = 0;
+
+static uint16_t periodMs = 100;
+static uint16_t holdPct = 50;
+static uint16_t deadlineMs = 500;
+
+// Command being played; its hold and decay run from lastArrivalMs
+static bool playing = false;
+static int16_t playRight = 0, playLeft = 0;
+// Last frame sent (none since the last clear when !sent)
+static bool sent = false;
+static int16_t sentRight = 0, sentLeft = 0;
+static uint32_t sentMs = 0;
+
+static uint16_t staleCount = 0;
+static uint16_t dropped = 0;
+
+uint16_t twistJitterMs() { return (uint16_t)(jitter16 / 16); }
+
+uint16_t twistDelayMs() {
+  uint32_t d = jitter16 / 8; // twice the jitter
+  return (uint16_t)(d < periodMs / 2 ? d : periodMs / 2);
+}
+
+bool twistPush(float vx, float wz, uint32_t seq, uint32_t nowMs) {
+  if (haveSeq && (int32_t)(seq - lastSeq) <= 0) {
+    dropped++;
+    return false;
+  }
+  if (haveSeq) {
+    uint32_t gap = nowMs - lastArrivalMs;
+    // Long pauses are the operator letting go, not jitter
+    if (gap < (uint32_t)deadlineMs) {
+      uint32_t dev = gap > periodMs ? gap - periodMs : periodMs - gap;
+      jitter16 = jitter16 + dev - jitter16 / 16;
+    }
+  }
+  haveSeq = true;
+  lastSeq = seq;
+  lastArrivalMs = nowMs;
+  if (queued == TWIST_SLOTS) {
+    for (uint8_t i = 1; i < TWIST_SLOTS; ++i) slots[i - 1] = slots[i];
+    queued--;
+  }
+  TwistCmd &c = slots[queued++];
+  c.seq = seq;
+  c.dueMs = nowMs + twistDelayMs();
+  motionTwistToWheels(vx, wz, c.right, c.left);
+  return true;
+}
+
+static void send(int16_t right, int16_t left, uint32_t nowMs, bool force) {
+  if (sent && right == sentRight && left == sentLeft) return;
+  if (sent && !force && nowMs - sentMs < FRAME_MS) return;
+  if (!motionHostDrive(right, left)) return;
+  sent = true;
+  sentRight = right;
+  sentLeft = left;
+  sentMs = nowMs;
+}
+
+void twistClear() {
+  queued = 0;
+  haveSeq = false; // a new session may restart its seq
+  playing = false;
+  if (sent && (sentRight != 0 || sentLeft != 0)) motionHostDrive(0, 0);
+  sent = false;
+}
+
+void twistTick(uint32_t nowMs) {
+  if (estopActive()) {
+    queued = 0;
+    playing = false;
+    sent = false; // the ESTOP path already stopped the wheels
+    return;
+  }
+  // Newest command that is due wins; older ones are superseded
+  int8_t due = -1;
+  for (uint8_t i = 0; i < queued; ++i) {
+    if ((int32_t)(nowMs - slots[i].dueMs) >= 0) due = (int8_t)i;
+  }
+  if (due >= 0) {
+    playRight = slots[due].right;
+    playLeft = slots[due].left;
+    playing = true;
+    for (uint8_t i = due + 1; i < queued; ++i) slots[i - due - 1] = slots[i];
+    queued -= due + 1;
+    send(playRight, playLeft, nowMs, true);
+    return;
+  }
+  if (!playing) return;
+  // Timed from the arrival, not the playout: the adaptive delay must not
+  // push the deadline (and STALE) back
+  uint32_t gap = nowMs - lastArrivalMs;
+  uint32_t hold = periodMs + (uint32_t)periodMs * holdPct / 100;
+  // The watchdog wins over a long hold (e.g. 1000 ms period at 400%)
+  if (hold > deadlineMs) hold = deadlineMs;
+  if (gap < hold) {
+    send(playRight, playLeft, nowMs, false);
+    return;
+  }
+  if (gap < deadlineMs) {
+    // Linear decay from full speed at the end of the hold to zero at the deadline
+    uint32_t left = deadlineMs - gap, span = deadlineMs - hold;
+    send((int16_t)((int32_t)playRight * (int32_t)left / (int32_t)span),
+         (int16_t)((int32_t)playLeft * (int32_t)left / (int32_t)span), nowMs, false);
+    return;
+  }
+  playing = false;
+  send(0, 0, nowMs, true);
+  if (playRight != 0 || playLeft != 0) {
+    staleCount++;
+    // STALE,twist,<ms_since>
+    txBegin("STALE");
+    txStr("twist");
+    txU32(nowMs - lastArrivalMs);
+    txEndLine();
+  }
+}
+
+bool twistActive() { return playing || queued > 0; }
+
+bool twistSetPeriodMs(uint16_t ms) {
+  if (ms < 10 || ms > 1000) return false;
+  periodMs = ms;
+  return true;
+}
+
+bool twistSetHoldPct(uint16_t pct) {
+  if (pct > 400) return false;
+  holdPct = pct;
+  return true;
+}
+
+bool twistSetDeadlineMs(uint16_t ms) {
+  if (ms < 50 || ms > 10000) return false;
+  deadlineMs = ms;
+  return true;
+}
+
+uint16_t twistStaleCount() { return staleCount; }
+uint16_t twistDropped() { return dropped; }
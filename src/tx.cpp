@@ -0,0 +1,164 @@
+#include "tx.h"
+#include "cdc_ctl.h"
+#include "numfmt.h"
+#include <Arduino.h>
+#include <string.h>
+
+bool tx_paused = false;
+
+// 256-byte ring indexed by uint8_t so wraparound is free
+static char ring[256];
+static uint8_t head = 0;      // next committed byte to send
+static uint8_t tail = 0;      // end of committed data
+static uint8_t lineEnd = 0;   // write position of the line being built
+static bool lineOverflow = false;
+static uint32_t eid = 0;
+// A replay fills the ring at most this far, leaving room for a reply line
+static const uint16_t TX_REPLAY_MAX_BYTES = sizeof(ring) - 1 - 40;
+static uint16_t droppedLines = 0;
+
+static inline uint8_t freeForLine() {
+  // One slot stays empty to tell full from empty
+  return (uint8_t)(head - lineEnd - 1);
+}
+
+static void putBytes(const char* s, uint8_t n) {
+  if (lineOverflow) return;
+  if (n > freeForLine()) { lineOverflow = true; return; }
+  for (uint8_t i = 0; i < n; ++i) ring[lineEnd++] = s[i];
+}
+
+// Format a number straight into the ring when the next NUMFMT_MAX_LEN bytes
+// are contiguous; otherwise via a small scratch buffer at the wrap point.
+template <typename Fmt>
+static void putNumber(Fmt fmt) {
+  if (lineOverflow) return;
+  if (freeForLine() < NUMFMT_MAX_LEN + 1) { lineOverflow = true; return; }
+  ring[lineEnd++] = ',';
+  if ((unsigned)lineEnd + NUMFMT_MAX_LEN <= sizeof(ring)) {
+    lineEnd = (uint8_t)(lineEnd + fmt(&ring[lineEnd]));
+  } else {
+    char tmp[NUMFMT_MAX_LEN];
+    uint8_t n = fmt(tmp);
+    for (uint8_t i = 0; i < n; ++i) ring[lineEnd++] = tmp[i];
+  }
+}
+
+void txBegin(const char* verb) {
+  lineEnd = tail;
+  lineOverflow = false;
+  putBytes(verb, (uint8_t)strlen(verb));
+}
+
+void txStr(const char* s) {
+  putBytes(",", 1);
+  putBytes(s, (uint8_t)strlen(s));
+}
+
+void txU32(uint32_t v) { putNumber([v](char* o) { return fmtU32(o, v); }); }
+void txI32(int32_t v) { putNumber([v](char* o) { return fmtI32(o, v); }); }
+void txFixed(int32_t scaled, uint8_t decimals) {
+  putNumber([scaled, decimals](char* o) { return fmtFixed(o, scaled, decimals); });
+}
+void txFloat(float v, uint8_t decimals) {
+  putNumber([v, decimals](char* o) { return fmtFloat(o, v, decimals); });
+}
+
+void txEndLine() {
+  char suffix[5 + NUMFMT_MAX_LEN + 1];
+  memcpy(suffix, ",eid=", 5);
+  uint8_t n = (uint8_t)(5 + fmtU32(suffix + 5, eid + 1));
+  suffix[n++] = '\n';
+  putBytes(suffix, n);
+  if (lineOverflow) {
+    // Drop the whole line; nothing was committed
+    if (droppedLines < 0xFFFF) droppedLines++;
+    lineEnd = tail;
+    lineOverflow = false;
+    return;
+  }
+  eid++;
+  tail = lineEnd;
+}
+
+void txFlush() {
+  if (tx_paused) return;
+  while (head != tail) {
+    int room = CONTROL_SERIAL.availableForWrite();
+    if (room <= 0) return;
+    // Send the contiguous run up to the wrap point or the committed tail
+    uint8_t run = (tail > head) ? (uint8_t)(tail - head) : (uint8_t)(0 - head);
+    if ((int)run > room) run = (uint8_t)room;
+    CONTROL_SERIAL.write((const uint8_t*)&ring[head], run);
+    head = (uint8_t)(head + run);
+  }
+}
+
+// eid of the committed line ending at ring[nl] == '\n' (0 if none)
+static uint32_t lineEid(uint8_t start, uint8_t nl) {
+  uint8_t p = nl;
+  uint32_t v = 0, scale = 1;
+  while (p != start && ring[(uint8_t)(p - 1)] >= '0' && ring[(uint8_t)(p - 1)] <= '9') {
+    p--;
+    v += (uint32_t)(ring[p] - '0') * scale;
+    scale *= 10;
+  }
+  if (p == nl || (uint8_t)(p - start) < 5) return 0;
+  static const char tag[] = ",eid=";
+  for (uint8_t i = 0; i < 5; ++i) {
+    if (ring[(uint8_t)(p - 5 + i)] != tag[i]) return 0;
+  }
+  return v;
+}
+
+// Call f(start, end, eid) for each complete sent line still in the ring,
+// oldest first. Sent bytes are [tail, head) (the whole ring once all is
+// sent); the first line there may be partly overwritten or never written,
+// so scanning starts after a separator.
+template <typename F>
+static void eachSentLine(F f) {
+  uint16_t left = head == tail ? sizeof(ring) : (uint8_t)(head - tail);
+  uint8_t src = tail;
+  for (; left && ring[src] != '\n' && ring[src] != '\0'; --left) src++;
+  while (left) {
+    for (; left && (ring[src] == '\n' || ring[src] == '\0'); --left) src++;
+    uint8_t start = src;
+    for (; left && ring[src] != '\n'; --left) src++;
+    if (!left) return; // no complete line left
+    uint8_t nl = src++;
+    left--;
+    uint32_t e = lineEid(start, nl);
+    if (e) f(start, src, e);
+  }
+}
+
+uint32_t txReplay(uint32_t sinceEid) {
+  // Leave room for the caller's reply: drop the oldest lines beyond it
+  uint16_t bytes = 0;
+  eachSentLine([&](uint8_t start, uint8_t end, uint32_t e) {
+    if ((int32_t)(e - sinceEid) > 0) bytes += (uint8_t)(end - start);
+  });
+  uint8_t dst = tail;
+  uint32_t first = 0;
+  // Copies go to tail and onward, never past the line being read
+  eachSentLine([&](uint8_t start, uint8_t end, uint32_t e) {
+    if ((int32_t)(e - sinceEid) <= 0) return;
+    uint8_t len = (uint8_t)(end - start);
+    if (bytes > TX_REPLAY_MAX_BYTES) {
+      bytes -= len;
+      return;
+    }
+    if (first == 0) first = e;
+    for (uint8_t p = start; p != end; ++p) ring[dst++] = ring[p];
+  });
+  // Blank the originals behind the copies so a later replay finds each eid
+  // once and in order
+  if (dst != tail) {
+    for (uint8_t p = dst; p != head; ++p) ring[p] = '\0';
+  }
+  tail = lineEnd = dst;
+  return first;
+}
+
+uint32_t txLastEid() { return eid; }
+uint16_t txDroppedLines() { return droppedLines; }
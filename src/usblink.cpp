@@ -0,0 +1,79 @@
+#include "usblink.h"
+#include "cdc_ctl.h"
+#include "passthrough.h"
+#include "tx.h"
+#include <Arduino.h>
+
+// SOFs arrive every 1 ms on an active bus; a few missed frames means the
+// host suspended the bus or the cable is gone.
+static const unsigned long SOF_STALL_US = 3000;
+
+static bool present = false;
+static uint8_t downReason = USB_LINK_NO_VBUS;
+static uint16_t transitions = 0;
+static uint16_t lastFrame = 0;
+static unsigned long lastFrameChangeUs = 0;
+
+#if defined(__AVR_ATmega32U4__) && defined(USBCON)
+static inline bool readVbus() { return (USBSTA & (1 << VBUS)) != 0; }
+static inline uint16_t readFrame() { return (uint16_t)UDFNUML | ((uint16_t)(UDFNUMH & 0x07) << 8); }
+#if DUAL_CDC
+// Either port held open counts: a host may only drive the control port
+static inline bool readDtr() { return Serial.dtr() || SerialCtl.dtr(); }
+#else
+static inline bool readDtr() { return Serial.dtr(); }
+#endif
+#elif !defined(ARDUINO)
+static bool simVbus = false, simSof = false, simDtr = false;
+static uint16_t simFrame = 0;
+void usbLinkSimulate(bool vbus, bool sofRunning, bool dtr) {
+  simVbus = vbus;
+  simSof = sofRunning;
+  simDtr = dtr;
+}
+static inline bool readVbus() { return simVbus; }
+static inline uint16_t readFrame() { if (simSof) simFrame = (uint16_t)((simFrame + 1) & 0x7FF); return simFrame; }
+static inline bool readDtr() { return simDtr; }
+#else
+// Other boards: no USB device registers; treat an open CDC port as present.
+static inline bool readVbus() { return true; }
+static inline uint16_t readFrame() { return (uint16_t)(micros() >> 10); }
+static inline bool readDtr() { return (bool)Serial; }
+#endif
+
+void initUsbLink() {
+  present = false;
+  downReason = USB_LINK_NO_VBUS;
+  lastFrame = readFrame();
+  lastFrameChangeUs = micros();
+}
+
+UsbLinkEvent usbLinkPoll() {
+  unsigned long now = micros();
+  uint16_t frame = readFrame();
+  if (frame != lastFrame) {
+    lastFrame = frame;
+    lastFrameChangeUs = now;
+  }
+  uint8_t reason = 0;
+  if (!readVbus()) reason |= USB_LINK_NO_VBUS;
+  if (now - lastFrameChangeUs > SOF_STALL_US) reason |= USB_LINK_SOF_STALL;
+  if (!readDtr()) reason |= USB_LINK_NO_DTR;
+  downReason = reason;
+
+  bool up = (reason == 0);
+  if (up == present) return USB_LINK_NONE;
+  present = up;
+  transitions++;
+  // LINK,<0|1>,<seq>
+  txBegin("LINK");
+  txU32(up ? 1 : 0);
+  txU32(transitions);
+  txEndLine();
+  passthroughLinkChanged(up);
+  return up ? USB_LINK_UP : USB_LINK_DOWN;
+}
+
+bool usbLinkPresent() { return present; }
+uint8_t usbLinkDownReason() { return downReason; }
+uint16_t usbLinkTransitions() { return transitions; }
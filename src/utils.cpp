@@ -1,4 +1,7 @@
 #include "utils.h"
+#include "cdc_ctl.h"
+#include "energy.h"
+#include "fdr.h"
 #include "motion.h"
 #include "sensors.h"
 #include <Arduino.h>
@@ -92,9 +95,10 @@ void enforceRobotWatchdog() {
   if ((now - lastRobotWatchdogMs) > ROBOT_WATCHDOG_TIMEOUT_MS) {
     if (!watchdogTripped) {
 #ifdef ENABLE_DEBUG
-      Serial.println("[WDOG] Motion watchdog expired; forcing STOP");
+      CONTROL_SERIAL.println("[WDOG] Motion watchdog expired; forcing STOP");
 #endif
       watchdogTripped = true;
+      fdrTrigger(FDR_TRIG_WATCHDOG);
     }
     // Force a stop drive repeatedly as long as expired
     writeHighLow(OI_DRIVE, 0, 0);
@@ -163,18 +167,22 @@ void playBumperSong() {
   // Play the song
   CREATE_SERIAL.write(OI_PLAY);
   CREATE_SERIAL.write(songNum);
+  energyCue(3 * dur * 1000 / 64);
 }
 
 static inline void defineAndPlay(uint8_t songNum, const uint8_t* notes, const uint8_t* durs, uint8_t count) {
+  uint16_t ticks = 0; // 1/64 s
   CREATE_SERIAL.write(OI_SONG);
   CREATE_SERIAL.write(songNum);
   CREATE_SERIAL.write(count);
   for (uint8_t i = 0; i < count; ++i) {
     CREATE_SERIAL.write(notes[i]);
     CREATE_SERIAL.write(durs[i]);
+    ticks += durs[i];
   }
   CREATE_SERIAL.write(OI_PLAY);
   CREATE_SERIAL.write(songNum);
+  energyCue((uint16_t)(ticks * 1000UL / 64));
 }
 
 void playStateSong(uint8_t id) {
@@ -2,35 +2,191 @@
 #include <stdint.h>
 #include <vector>
 #include <cstddef>
+#include <initializer_list>
+#include <stdio.h>
+
+// Forward declaration; the virtual clock is defined below with millis()/micros()
+inline unsigned long& mockClockUs();
+
+// Growable ring used for mock RX: O(1) push/pop, indexable from the front
+// so tests can inspect what is still unread.
+template <typename T>
+class MockRing {
+public:
+  MockRing() {}
+  MockRing(std::initializer_list<T> init) { *this = init; }
+  MockRing& operator=(std::initializer_list<T> init) {
+    clear();
+    for (T v : init) push_back(v);
+    return *this;
+  }
+  void push_back(T v) {
+    if (count == data.size()) grow();
+    data[(head + count) % data.size()] = v;
+    count++;
+  }
+  T front() const { return data[head]; }
+  void pop_front() {
+    head = (head + 1) % data.size();
+    count--;
+  }
+  T operator[](size_t i) const { return data[(head + i) % data.size()]; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  void clear() { head = 0; count = 0; }
+
+private:
+  void grow() {
+    std::vector<T> next(data.empty() ? 64 : data.size() * 2);
+    for (size_t i = 0; i < count; ++i) next[i] = (*this)[i];
+    data.swap(next);
+    head = 0;
+  }
+  std::vector<T> data;
+  size_t head = 0;
+  size_t count = 0;
+};
+typedef MockRing<uint8_t> MockByteRing;
 
 class HardwareSerial {
 public:
   // Bytes written by the device under test
   std::vector<uint8_t> buffer;
-  // Bytes to be read by the device under test
-  std::vector<uint8_t> rx;
+  // Bytes ready to be read by the device under test. Filling this directly
+  // makes them available at once; inject() models the wire instead.
+  MockByteRing rx;
+
+  // Line statistics for timed arrivals (see inject())
+  unsigned long overruns = 0;      // dropped because rx held rxCapacity bytes
+  unsigned long framingErrors = 0; // dropped as framing errors
+  unsigned long noisyBytes = 0;    // delivered with a flipped bit
+  // Writes that found a bounded TX buffer full (see setTxCapacity())
+  unsigned long blockedWrites = 0;
 
-  void begin(unsigned long) {}
+  void begin(unsigned long baud) { baudRate = baud; }
+  void begin(unsigned long baud, uint8_t) { baudRate = baud; }
+
+  // Schedule bytes on the wire: each takes 10 bit times (8N1) at the baud
+  // rate set by begin() and lands in rx when the virtual clock passes its
+  // arrival time. Back-to-back injections queue behind each other.
+  void inject(const uint8_t* data, size_t len) {
+    unsigned long now = mockClockUs();
+    if (wireFreeUs < now) wireFreeUs = now;
+    for (size_t i = 0; i < len; ++i) {
+      wireFreeUs += byteTimeUs();
+      wire.push_back(data[i]);
+      wireArrivalUs.push_back(wireFreeUs);
+    }
+  }
+  void inject(std::initializer_list<uint8_t> data) {
+    std::vector<uint8_t> v(data);
+    inject(v.data(), v.size());
+  }
+  // Hardware receive buffer size for timed arrivals (the AVR core uses 64);
+  // 0 means unbounded.
+  void setRxCapacity(size_t cap) { rxCapacity = cap; }
+  // Per-byte probabilities (0..1) of a flipped bit and of a framing error,
+  // drawn from a deterministic generator.
+  void setLineErrors(double noise, double framing, uint32_t seed = 1) {
+    noiseProb = noise;
+    framingProb = framing;
+    lineSeed = seed ? seed : 1;
+  }
+  // Hardware transmit buffer for timed writes (the AVR core uses 64): bytes
+  // drain at the baud rate and availableForWrite() reports the room left.
+  // A write into a full buffer blocks like the core, advancing the virtual
+  // clock until a byte has gone out. 0 (default) means unbounded.
+  void setTxCapacity(size_t cap) { txCapacity = cap; }
+  unsigned long byteTimeUs() const { return baudRate ? (10000000UL + baudRate / 2) / baudRate : 0; }
+  // Bytes still in flight on the wire
+  size_t pending() const { return wire.size(); }
 
   size_t write(uint8_t b) {
+    txOne();
     buffer.push_back(b);
     return 1;
   }
   size_t write(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) txOne();
     buffer.insert(buffer.end(), data, data + len);
     return len;
   }
-  int available() { return static_cast<int>(rx.size()); }
+  int available() {
+    deliver();
+    return static_cast<int>(rx.size());
+  }
+  int availableForWrite() {
+    if (!txCapacity) return 64;
+    size_t queued = txQueued();
+    return queued >= txCapacity ? 0 : static_cast<int>(txCapacity - queued);
+  }
+  void flush() {}
   int read() {
+    deliver();
     if (rx.empty()) return -1;
     uint8_t b = rx.front();
-    rx.erase(rx.begin());
+    rx.pop_front();
     return b;
   }
   void clear() {
     buffer.clear();
     rx.clear();
+    wire.clear();
+    wireArrivalUs.clear();
+    wireFreeUs = 0;
+    txFreeUs = 0;
+    overruns = framingErrors = noisyBytes = blockedWrites = 0;
+  }
+
+private:
+  // Bytes written but not yet shifted out
+  size_t txQueued() const {
+    unsigned long now = mockClockUs(), bt = byteTimeUs();
+    if (!bt || txFreeUs <= now) return 0;
+    return (txFreeUs - now + bt - 1) / bt;
+  }
+  void txOne() {
+    if (!txCapacity) return;
+    unsigned long bt = byteTimeUs();
+    if (txQueued() >= txCapacity) {
+      blockedWrites++;
+      mockClockUs() = txFreeUs - (txCapacity - 1) * bt;
+    }
+    unsigned long now = mockClockUs();
+    txFreeUs = (txFreeUs > now ? txFreeUs : now) + bt;
+  }
+  // Move every byte whose arrival time has passed from the wire into rx
+  void deliver() {
+    unsigned long now = mockClockUs();
+    while (!wireArrivalUs.empty() && wireArrivalUs.front() <= now) {
+      uint8_t b = wire.front();
+      wire.pop_front();
+      wireArrivalUs.pop_front();
+      if (framingProb > 0 && nextUnit() < framingProb) { framingErrors++; continue; }
+      if (noiseProb > 0 && nextUnit() < noiseProb) {
+        b ^= (uint8_t)(1u << (lineSeed % 8));
+        noisyBytes++;
+      }
+      if (rxCapacity && rx.size() >= rxCapacity) { overruns++; continue; }
+      rx.push_back(b);
+    }
   }
+  double nextUnit() {
+    lineSeed ^= lineSeed << 13;
+    lineSeed ^= lineSeed >> 17;
+    lineSeed ^= lineSeed << 5;
+    return (lineSeed & 0xFFFFFF) / 16777216.0;
+  }
+
+  unsigned long baudRate = 57600;
+  size_t rxCapacity = 64;
+  double noiseProb = 0, framingProb = 0;
+  uint32_t lineSeed = 1;
+  MockByteRing wire;
+  MockRing<unsigned long> wireArrivalUs;
+  unsigned long wireFreeUs = 0;
+  size_t txCapacity = 0;
+  unsigned long txFreeUs = 0;
 };
 
 extern HardwareSerial Serial1;
@@ -79,12 +235,20 @@ inline int analogRead(int) { return 1023; }
 inline int digitalPinToInterrupt(int) { return 0; }
 inline void attachInterrupt(int, void (*)(void), int) {}
 
-// simple millis() stub that advances with calls
-inline unsigned long millis() {
+// Virtual clock shared by millis()/micros(). millis() advances 10 ms per
+// call; micros() advances a few microseconds so back-to-back reads differ.
+inline unsigned long& mockClockUs() {
   static unsigned long t = 0;
-  t += 10;
   return t;
 }
+inline unsigned long millis() {
+  mockClockUs() += 10000;
+  return mockClockUs() / 1000;
+}
+inline unsigned long micros() {
+  mockClockUs() += 4;
+  return mockClockUs();
+}
 
 // simple pseudo-random generator compatible with Arduino's random(max)
 inline long random(long max) {
@@ -97,18 +261,22 @@ inline long random(long max) {
 }
 
 // Minimal USB Serial stub for debug logs and passthrough tests
+// Printed text lands in buffer like written bytes. One instance shared by
+// every translation unit, as on the device.
 class USBSerial : public HardwareSerial {
 public:
-  void print(const char*) {}
-  void println(const char*) {}
-  void print(int) {}
-  void println(int) {}
-  void print(unsigned long) {}
-  void println(unsigned long) {}
-  void println() {}
+  void print(const char* s) { while (*s) write((uint8_t)*s++); }
+  void println(const char* s) { print(s); println(); }
+  void print(int v) { print((long)v); }
+  void println(int v) { print(v); println(); }
+  void print(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); print(b); }
+  void print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); print(b); }
+  void println(unsigned long v) { print(v); println(); }
+  void println() { write('\r'); write('\n'); }
+  bool dtr() { return true; }
 };
 
-static USBSerial Serial;
+inline USBSerial Serial;
 
 // LED helper macros as no-ops if referenced
 #ifndef TXLED0
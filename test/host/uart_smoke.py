@@ -4,10 +4,20 @@ UART smoke tester for the brainstem skeleton.
 
 Examples:
   python3 test/host/uart_smoke.py /dev/ttyACM0 --ping 2 --range 0.18 --set soft_stop_m=0.25 --fuzz --pause --resume --replay
+
+Benchmark mode (real hardware, native pty build or simulator — anything with a
+serial device path):
+  python3 test/host/uart_smoke.py /dev/ttyACM0 --bench all --hello --json report.json
+  python3 test/host/uart_smoke.py /dev/pts/5 --bench rtt --bench-count 500 --bench-rate 100
+  python3 test/host/uart_smoke.py /dev/ttyACM0 --bench throughput --burst-packet 6 --bench-seconds 10
 """
 import sys
 import time
+import json
+import math
 import argparse
+import threading
+from collections import deque
 
 try:
     import serial  # pyserial
@@ -20,6 +30,232 @@ def send_line(ser, s):
     ser.flush()
     print("→", s)
 
+# Reply sizes for OI sensor queries (142,<packet>) on the Create 1
+OI_SENSOR_REPLY_LEN = {0: 26, 1: 10, 2: 6, 3: 10, 6: 52, 7: 1, 8: 1, 14: 1, 18: 1, 19: 2, 20: 2, 22: 2, 23: 2}
+ESCAPE = b"\xFF\x00"
+
+
+def percentiles(samples_ms):
+    """Summary stats with nearest-rank percentiles (ms)."""
+    if not samples_ms:
+        return {"n": 0}
+    xs = sorted(samples_ms)
+
+    def pct(p):
+        k = max(0, min(len(xs) - 1, math.ceil(p / 100.0 * len(xs)) - 1))
+        return round(xs[k], 3)
+
+    return {
+        "n": len(xs),
+        "min": round(xs[0], 3),
+        "mean": round(sum(xs) / len(xs), 3),
+        "p50": pct(50),
+        "p90": pct(90),
+        "p99": pct(99),
+        "max": round(xs[-1], 3),
+    }
+
+
+class BenchReader(threading.Thread):
+    """Background reader: timestamps replies the moment they arrive."""
+
+    def __init__(self, ser):
+        super().__init__(daemon=True)
+        self.ser = ser
+        self.running = True
+        self.lock = threading.Lock()
+        self.buf = b""
+        self.bytes_in = 0
+        self.pending_pings = {}      # seq -> t_sent
+        self.pending_status = deque()  # t_sent, FIFO (STATUS has no seq)
+        self.ping_rtts = []
+        self.status_rtts = []
+        self.last_status = None
+        self.lines = deque(maxlen=50)
+
+    def run(self):
+        while self.running:
+            data = self.ser.read(4096)
+            if not data:
+                continue
+            now = time.perf_counter()
+            with self.lock:
+                self.bytes_in += len(data)
+                self.buf += data
+                while b"\n" in self.buf:
+                    line, self.buf = self.buf.split(b"\n", 1)
+                    self._on_line(line.decode(errors="replace").strip(), now)
+                # Raw OI replies have no newlines; keep the line buffer bounded
+                if len(self.buf) > 4096:
+                    self.buf = self.buf[-256:]
+
+    def _on_line(self, s, now):
+        if not s:
+            return
+        self.lines.append(s)
+        if s.startswith("PONG,"):
+            try:
+                seq = int(s.split(",")[1])
+            except Exception:
+                return
+            t0 = self.pending_pings.pop(seq, None)
+            if t0 is not None:
+                self.ping_rtts.append((now - t0) * 1000.0)
+        elif "STATUS:" in s:
+            self.last_status = s[s.index("STATUS:") + len("STATUS:"):]
+            if self.pending_status:
+                self.status_rtts.append((now - self.pending_status.popleft()) * 1000.0)
+
+    def stop(self):
+        self.running = False
+
+
+def bench_hello(ser, reader, timeout=8.0):
+    ser.write(b"HELLO\n")
+    t0 = time.time()
+    while time.time() - t0 < timeout:
+        with reader.lock:
+            if "READY" in reader.lines:
+                return True
+        time.sleep(0.05)
+    return False
+
+
+def wait_line(reader, prefix, timeout=2.0):
+    t0 = time.time()
+    while time.time() - t0 < timeout:
+        with reader.lock:
+            if any(l.startswith(prefix) for l in reader.lines):
+                return True
+        time.sleep(0.02)
+    return False
+
+
+def bench_rtt(ser, reader, count, rate, song, timeout=1.0):
+    """Pipelined PING and !status at a fixed send rate.
+
+    Managed lines are only read outside the bridge, so this enters forebrain
+    mode with the OI PLAY handshake first and returns to the bridge with PASS
+    at the end. In managed mode !status needs no FF 00 escape.
+
+    Needs the managed stack (env:brainstem_promicro_managed or _dualcdc). The
+    bare bridge only answers HELLO and bridges the rest to the robot, so
+    without a STATE,FOREBRAIN reply nothing is sent and the result carries
+    "error" instead of numbers.
+    """
+    with reader.lock:
+        reader.lines.clear()
+    ser.write(bytes([141, song]))
+    if not wait_line(reader, "STATE,FOREBRAIN"):
+        return {"rate_hz": rate,
+                "error": "no STATE,FOREBRAIN after the OI PLAY handshake (not a managed firmware?)"}
+    period = 1.0 / rate if rate > 0 else 0.0
+    sent_ping = sent_status = 0
+    t_next = time.perf_counter()
+    for i in range(count):
+        now = time.perf_counter()
+        if now < t_next:
+            time.sleep(t_next - now)
+        t_next += period
+        with reader.lock:
+            reader.pending_pings[i] = time.perf_counter()
+        ser.write(f"PING,{i}\n".encode("ascii"))
+        sent_ping += 1
+        # Interleave one status request per ten pings
+        if i % 10 == 0:
+            with reader.lock:
+                reader.pending_status.append(time.perf_counter())
+            ser.write(b"!status\n")
+            sent_status += 1
+    time.sleep(timeout)
+    with reader.lock:
+        ping = percentiles(reader.ping_rtts)
+        status = percentiles(reader.status_rtts)
+        ping.update(sent=sent_ping, lost=sent_ping - ping["n"])
+        status.update(sent=sent_status, lost=sent_status - status["n"])
+        reader.pending_pings.clear()
+        reader.pending_status.clear()
+    ser.write(b"PASS\n")
+    wait_line(reader, "STATE,PASSTHROUGH")
+    return {"rate_hz": rate, "ping": ping, "status": status}
+
+
+def bench_throughput(ser, reader, packet, burst, seconds):
+    """Saturate the bridge with OI sensor-query bursts and count reply bytes."""
+    reply_len = OI_SENSOR_REPLY_LEN.get(packet)
+    if reply_len is None:
+        raise SystemExit(f"unknown reply length for OI packet {packet}")
+    frame = bytes([142, packet]) * burst
+    with reader.lock:
+        start_in = reader.bytes_in
+    bytes_out = 0
+    queries = 0
+    t0 = time.perf_counter()
+    while time.perf_counter() - t0 < seconds:
+        ser.write(frame)
+        ser.flush()
+        bytes_out += len(frame)
+        queries += burst
+    # Let the tail drain
+    time.sleep(0.5)
+    elapsed = time.perf_counter() - t0
+    with reader.lock:
+        got = reader.bytes_in - start_in
+    expected = queries * reply_len
+    return {
+        "packet": packet,
+        "burst": burst,
+        "seconds": round(elapsed, 3),
+        "queries": queries,
+        "bytes_out": bytes_out,
+        "bytes_in": got,
+        "bytes_expected": expected,
+        "tx_Bps": round(bytes_out / elapsed, 1),
+        "rx_Bps": round(got / elapsed, 1),
+        "loss_pct": round(100.0 * max(0, expected - got) / expected, 2) if expected else 0.0,
+    }
+
+
+def run_bench(args, ser):
+    reader = BenchReader(ser)
+    reader.start()
+    report = {"port": args.port, "baud": args.baud, "started": time.strftime("%Y-%m-%dT%H:%M:%S")}
+    failed = False
+    try:
+        if args.hello:
+            report["hello_ready"] = bench_hello(ser, reader)
+        if args.bench in ("rtt", "all"):
+            report["rtt"] = bench_rtt(ser, reader, args.bench_count, args.bench_rate, args.handshake_song)
+            if "error" in report["rtt"]:
+                print(f"bench rtt refused: {report['rtt']['error']}", file=sys.stderr)
+                failed = args.bench == "rtt"
+        if args.bench in ("throughput", "all"):
+            report["throughput"] = bench_throughput(ser, reader, args.burst_packet, args.burst_size,
+                                                    args.bench_seconds)
+        # Final firmware counters, if the target answers the escape (the bare
+        # bridge would hand it to the robot)
+        if "error" not in report.get("rtt", {}):
+            ser.write(ESCAPE + b"!status\n")
+        time.sleep(0.3)
+        with reader.lock:
+            if reader.last_status:
+                try:
+                    report["firmware_status"] = json.loads(reader.last_status)
+                except ValueError:
+                    report["firmware_status"] = reader.last_status
+    finally:
+        reader.stop()
+        reader.join(timeout=1.0)
+    out = json.dumps(report, indent=2)
+    if args.json and args.json != "-":
+        with open(args.json, "w") as f:
+            f.write(out + "\n")
+        print(f"report written to {args.json}", file=sys.stderr)
+    else:
+        print(out)
+    return not failed
+
+
 def main():
     ap = argparse.ArgumentParser()
     ap.add_argument("port")
@@ -33,10 +269,27 @@ def main():
     ap.add_argument("--resume", action="store_true")
     ap.add_argument("--replay", action="store_true")
     ap.add_argument("--rate", type=int, default=None, help="simulate slow reader by sleeping us per read batch")
+    ap.add_argument("--bench", choices=["rtt", "throughput", "all"], default=None,
+                    help="run a benchmark instead of the smoke script (rtt needs a managed firmware)")
+    ap.add_argument("--hello", action="store_true", help="bench: HELLO/READY handshake first")
+    ap.add_argument("--bench-count", type=int, default=200, help="bench: number of PINGs")
+    ap.add_argument("--bench-rate", type=float, default=50.0, help="bench: PING send rate (Hz)")
+    ap.add_argument("--handshake-song", type=int, default=12,
+                    help="bench: OI PLAY song that enters managed mode (firmware HANDSHAKE_SONG)")
+    ap.add_argument("--burst-packet", type=int, default=6, help="bench: OI sensor packet to query")
+    ap.add_argument("--burst-size", type=int, default=4, help="bench: queries per burst")
+    ap.add_argument("--bench-seconds", type=float, default=5.0, help="bench: throughput duration")
+    ap.add_argument("--json", default=None, help="bench: write JSON report here ('-' for stdout)")
     args = ap.parse_args()
     port = args.port
     baud = args.baud
     ser = serial.Serial(port, baudrate=baud, timeout=0.01)
+    if args.bench:
+        try:
+            ok = run_bench(args, ser)
+        finally:
+            ser.close()
+        sys.exit(0 if ok else 1)
     t0 = time.time()
     last = time.time()
     buf = b""
@@ -0,0 +1,60 @@
+#!/bin/bash
+# Native unit tests. Each test/test_*.cpp is a program of its own, built
+# against src/ (without the firmware entry points) and the Arduino mock here.
+#
+#   test/run_native.sh [--dual-cdc] [test_name ...]
+#
+# --dual-cdc builds sources and tests with -DDUAL_CDC=1, like
+# env:brainstem_promicro_dualcdc; test_dual_cdc is empty without it.
+# UNITY_DIR points at a Unity checkout (unity.h, unity.c; default: the one
+# PlatformIO installs). Exits non-zero if any test fails.
+set -euo pipefail
+
+SCRIPT_DIR="$(cd -- "$(dirname -- "${BASH_SOURCE[0]}")" && pwd)"
+REPO_DIR="$(cd -- "$SCRIPT_DIR/.." && pwd)"
+UNITY_DIR=${UNITY_DIR:-$HOME/.platformio/packages/tool-unity}
+CXX=${CXX:-g++}
+CC=${CC:-gcc}
+
+DEFS=()
+SKIP_SRC="cdc_ctl.cpp"
+if [[ ${1:-} == --dual-cdc ]]; then
+  DEFS+=(-DDUAL_CDC=1)
+  SKIP_SRC=""
+  shift
+fi
+
+SRCS=()
+for f in "$REPO_DIR"/src/*.cpp; do
+  name=$(basename "$f")
+  [[ $name == main.cpp || $name == "$SKIP_SRC" ]] && continue
+  SRCS+=("$f")
+done
+
+TESTS=("$@")
+if [[ ${#TESTS[@]} -eq 0 ]]; then
+  for f in "$SCRIPT_DIR"/test_*.cpp; do TESTS+=("$(basename "$f" .cpp)"); done
+fi
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+UNITY_OBJ=()
+if [[ -f $UNITY_DIR/unity.c ]]; then
+  # Weak setUp/tearDown: suites only define what they use
+  "$CC" -c -DUNITY_WEAK_ATTRIBUTE='__attribute__((weak))' -I"$UNITY_DIR" \
+    "$UNITY_DIR/unity.c" -o "$OUT/unity.o"
+  UNITY_OBJ=("$OUT/unity.o")
+fi
+
+failed=0
+for t in "${TESTS[@]}"; do
+  echo "== $t ${DEFS[*]}"
+  if ! "$CXX" -std=c++17 -Wall -Wno-unused-function "${DEFS[@]}" \
+      -I"$REPO_DIR/include" -I"$SCRIPT_DIR" -I"$UNITY_DIR" \
+      "$SCRIPT_DIR/$t.cpp" "${SRCS[@]}" "${UNITY_OBJ[@]}" -o "$OUT/$t"; then
+    failed=1
+    continue
+  fi
+  "$OUT/$t" || failed=1
+done
+exit $failed
@@ -0,0 +1,69 @@
+#include <unity.h>
+#include "arbiter.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+static bool highActive = false;
+static int lowRuns = 0;
+
+static void highLayer(MotionProposal &p, unsigned long) {
+  p.active = highActive;
+  p.right = 0;
+  p.left = 0;
+  p.tag = 1;
+}
+
+static void lowLayer(MotionProposal &p, unsigned long) {
+  lowRuns++;
+  p.active = true;
+  p.right = 100;
+  p.left = 100;
+  p.tag = 2;
+}
+
+static BehaviorLayer layers[] = {
+  { "high", 0,   highLayer, 0, { false, 0, 0, 0 }, 0 },
+  { "low",  100, lowLayer,  0, { false, 0, 0, 0 }, 0 },
+};
+
+void setUp() {
+  highActive = false;
+  lowRuns = 0;
+  arbiterInit(layers, 2, 1000);
+}
+
+void test_low_layer_wins_when_high_is_idle() {
+  MotionProposal w;
+  TEST_ASSERT_EQUAL(1, arbiterStep(1000, w));
+  TEST_ASSERT_EQUAL(100, w.right);
+  TEST_ASSERT_EQUAL(2, w.tag);
+}
+
+void test_high_layer_preempts_at_once() {
+  MotionProposal w;
+  arbiterStep(1000, w);
+  highActive = true;
+  TEST_ASSERT_EQUAL(0, arbiterStep(1001, w));
+  TEST_ASSERT_EQUAL(0, w.right);
+  highActive = false;
+  // The low layer's standing proposal resumes without re-running it
+  TEST_ASSERT_EQUAL(1, arbiterStep(1002, w));
+  TEST_ASSERT_EQUAL(1, lowRuns);
+}
+
+void test_layers_run_at_their_own_period() {
+  MotionProposal w;
+  for (unsigned long t = 1000; t < 1500; t += 10) arbiterStep(t, w);
+  // First step runs everything, then every 100 ms
+  TEST_ASSERT_EQUAL(5, lowRuns);
+  TEST_ASSERT_EQUAL(50, layers[0].runs);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_low_layer_wins_when_high_is_idle);
+  RUN_TEST(test_high_layer_preempts_at_once);
+  RUN_TEST(test_layers_run_at_their_own_period);
+  return UNITY_END();
+}
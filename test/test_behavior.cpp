@@ -0,0 +1,79 @@
+#include <unity.h>
+#include "behavior.h"
+#include "mode.h"
+#include "motion.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+// One stream frame: bumps/drops and wall
+static void frame(uint8_t bumps, uint8_t wall) {
+  const uint8_t body[] = { 7, bumps, 8, wall };
+  Serial1.rx.push_back(19);
+  Serial1.rx.push_back(sizeof(body));
+  uint8_t sum = 19 + sizeof(body);
+  for (uint8_t b : body) {
+    Serial1.rx.push_back(b);
+    sum += b;
+  }
+  Serial1.rx.push_back((uint8_t)(0 - sum));
+}
+
+// Stream a frame per loop pass; count passes that leave the wheels driving
+// forward or backward
+static int forward, backward;
+static void run(int loops, uint8_t bumps, uint8_t wall) {
+  for (int i = 0; i < loops; ++i) {
+    frame(bumps, wall);
+    modeLoop();
+    int16_t right, left;
+    motionLastSent(right, left);
+    if (right > 0 && left > 0) forward++;
+    if (right < 0 && left < 0) backward++;
+  }
+}
+
+void setUp() {
+  initMode(MODE_FOREBRAIN);
+  setBehaviorWanderEnabled(false);
+  forward = backward = 0;
+}
+
+void test_autonomy_drives_through_the_arbiter() {
+  setBehaviorWanderEnabled(true);
+  modeSet(MODE_AUTONOMOUS);
+  Serial1.clear();
+  run(300, 0, 0);
+  TEST_ASSERT_TRUE(forward > 50);
+  TEST_ASSERT_TRUE(Serial1.buffer.size() > 0);
+}
+
+void test_sedate_bump_never_backs_up() {
+  modeSet(MODE_AUTONOMOUS);
+  run(50, 0, 0);
+  run(3, 0x01, 0);
+  run(100, 0, 0);
+  TEST_ASSERT_EQUAL(0, backward);
+  TEST_ASSERT_EQUAL(0, forward);
+}
+
+void test_lost_wall_hands_back_to_seeking() {
+  setBehaviorWanderEnabled(true);
+  modeSet(MODE_AUTONOMOUS);
+  run(50, 0, 0);
+  run(3, 0x01, 0);
+  TEST_ASSERT_TRUE(backward > 0);
+  // Recoil, then the wall run searches in place for the missing wall and
+  // gives up; seeking drives forward again
+  forward = 0;
+  run(400, 0, 0);
+  TEST_ASSERT_TRUE(forward > 0);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_autonomy_drives_through_the_arbiter);
+  RUN_TEST(test_sedate_bump_never_backs_up);
+  RUN_TEST(test_lost_wall_hands_back_to_seeking);
+  return UNITY_END();
+}
@@ -0,0 +1,78 @@
+// Second CDC port tests; build sources and test with -DDUAL_CDC=1
+// (test/run_native.sh --dual-cdc). Without it this suite is empty.
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "mode.h"
+#include "passthrough.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+#if DUAL_CDC
+
+static std::string text(const std::vector<uint8_t>& b) { return std::string(b.begin(), b.end()); }
+
+static void feed(USBSerial& port, const char* s) {
+  while (*s) port.rx.push_back((uint8_t)*s++);
+}
+
+void setUp() {
+  initMode(MODE_PASSTHROUGH);
+  Serial.clear();
+  SerialCtl.clear();
+  Serial1.clear();
+}
+
+void test_bridge_port_is_byte_transparent() {
+  // Escape prefix, a control-looking line and the OI_PLAY handshake are all
+  // just robot bytes on the bridge port
+  const uint8_t bytes[] = { 0xFF, 0x00, '!', 's', '\n', 141, 12, 145, 0, 1, 0, 1 };
+  for (uint8_t b : bytes) Serial.rx.push_back(b);
+  modeLoop();
+  TEST_ASSERT_TRUE(passthroughActive());
+  TEST_ASSERT_EQUAL_INT(sizeof(bytes), Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, Serial1.buffer.data(), sizeof(bytes));
+  TEST_ASSERT_EQUAL_INT(0, SerialCtl.buffer.size());
+}
+
+void test_control_port_answers_while_bridging() {
+  feed(SerialCtl, "!status\n");
+  Serial1.rx = {0x10, 0x20};
+  modeLoop();
+  TEST_ASSERT_TRUE(passthroughActive());
+  TEST_ASSERT_EQUAL(0, text(SerialCtl.buffer).find("STATUS:{"));
+  // Only robot bytes reach the bridge port
+  TEST_ASSERT_EQUAL_INT(2, Serial.buffer.size());
+  TEST_ASSERT_EQUAL_INT(0, Serial1.buffer.size());
+}
+
+void test_mode_switch_and_lines_on_control_port() {
+  feed(SerialCtl, "SET,mode,FOREBRAIN\n");
+  modeLoop();
+  TEST_ASSERT_FALSE(passthroughActive());
+  std::string out = text(SerialCtl.buffer);
+  TEST_ASSERT_TRUE(out.find("STATE,FOREBRAIN,eid=") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ACK,mode,FOREBRAIN,eid=") != std::string::npos);
+  TEST_ASSERT_EQUAL_INT(0, Serial.buffer.size());
+  // Back to bridging from the control port; lines keep flowing there
+  SerialCtl.clear();
+  feed(SerialCtl, "PASS\n");
+  modeLoop();
+  TEST_ASSERT_TRUE(passthroughActive());
+  TEST_ASSERT_TRUE(text(SerialCtl.buffer).find("STATE,PASSTHROUGH,eid=") != std::string::npos);
+}
+
+#else
+void setUp() {}
+#endif
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+#if DUAL_CDC
+  RUN_TEST(test_bridge_port_is_byte_transparent);
+  RUN_TEST(test_control_port_answers_while_bridging);
+  RUN_TEST(test_mode_switch_and_lines_on_control_port);
+#endif
+  return UNITY_END();
+}
@@ -0,0 +1,91 @@
+#include <unity.h>
+#include "dwell.h"
+#include "passthrough.h"
+#include "timebase.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+static DwellQueue q;
+
+void setUp() {
+  dwellRestart(q);
+  dwellClear(q);
+  Serial.clear();
+  Serial1.clear();
+  Serial1.setTxCapacity(0);
+}
+
+static uint32_t total(const DwellQueue &d) {
+  uint32_t n = 0;
+  for (uint8_t i = 0; i < DWELL_BUCKETS; ++i) n += d.hist[i];
+  return n;
+}
+
+void test_buckets_are_log2_from_16us() {
+  TEST_ASSERT_EQUAL(0, dwellBucket(0));
+  TEST_ASSERT_EQUAL(0, dwellBucket(15));
+  TEST_ASSERT_EQUAL(1, dwellBucket(16));
+  TEST_ASSERT_EQUAL(4, dwellBucket(200));
+  TEST_ASSERT_EQUAL(DWELL_BUCKETS - 1, dwellBucket(16384));
+  TEST_ASSERT_EQUAL(DWELL_BUCKETS - 1, dwellBucket(0xFFFFFFFFUL));
+}
+
+void test_dwell_counts_from_previous_look() {
+  const uint32_t us = TB_TICKS_PER_US;
+  uint32_t t = 1000;
+  dwellSeen(q, 0, t);
+  // 3 bytes seen 1 ms after the previous look (so they may have waited that
+  // long) leave 1 ms later: 2 ms
+  dwellSeen(q, 3, t + 1000 * us);
+  dwellRead(q, 3);
+  dwellOut(q, 3, t + 2000 * us);
+  TEST_ASSERT_EQUAL(3, q.hist[dwellBucket(2000)]);
+  TEST_ASSERT_EQUAL(2000, q.maxUs);
+  // Two more seen at 2 ms (previous look at 1 ms), out at 6 ms: 5 ms
+  dwellSeen(q, 2, t + 2000 * us);
+  dwellRead(q, 2);
+  dwellOut(q, 2, t + 6000 * us);
+  TEST_ASSERT_EQUAL(2, q.hist[dwellBucket(5000)]);
+  TEST_ASSERT_EQUAL(5000, q.maxUs);
+  // Dropped bytes leave no sample
+  dwellSeen(q, 4, t + 7000 * us);
+  dwellDrop(q, 4);
+  TEST_ASSERT_EQUAL(5, total(q));
+  TEST_ASSERT_EQUAL(0, q.marks);
+  dwellClear(q);
+  TEST_ASSERT_EQUAL(0, total(q));
+}
+
+void test_bridge_dwell_tracks_pump_interval() {
+  passthroughEnable();
+  passthroughDwellClear();
+  Serial1.buffer.clear();
+  // Pumped every millisecond: host bytes wait at most about a millisecond
+  for (int t = 0; t < 20; ++t) {
+    Serial.rx.push_back((uint8_t)t);
+    mockClockUs() += 1000;
+    passthroughPump();
+  }
+  const DwellQueue &h = passthroughDwellToRobot();
+  TEST_ASSERT_EQUAL(20, total(h));
+  TEST_ASSERT_TRUE(h.maxUs >= 1000 && h.maxUs < 2048);
+  // A stalled loop shows up in the histogram: robot bytes wait 8 ms
+  passthroughPump();
+  Serial1.rx = { 1, 2, 3 };
+  mockClockUs() += 8000;
+  passthroughPump();
+  const DwellQueue &r = passthroughDwellToHost();
+  TEST_ASSERT_EQUAL(3, r.hist[dwellBucket(8000)]);
+  passthroughDwellClear();
+  TEST_ASSERT_EQUAL(0, total(passthroughDwellToHost()));
+  passthroughDisable();
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_buckets_are_log2_from_16us);
+  RUN_TEST(test_dwell_counts_from_previous_look);
+  RUN_TEST(test_bridge_dwell_tracks_pump_interval);
+  return UNITY_END();
+}
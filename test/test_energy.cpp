@@ -0,0 +1,95 @@
+#include <unity.h>
+#include "energy.h"
+#include "motion.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+void setUp() {
+  setMotionOwner(MOTION_OWNER_BEHAVIOR);
+  motionDrive(0, 0);
+  energySetActivity(ENERGY_IDLE);
+  energyReset();
+}
+
+// Stream-rate samples at a constant draw from t0 for ms
+static void draw(unsigned long t0, unsigned long ms, uint16_t mV, int16_t mA) {
+  for (unsigned long t = t0; t <= t0 + ms; t += 15) energySample(mV, mA, t);
+}
+
+void test_idle_baseline() {
+  draw(1000, 1500, 16000, -500); // 8 W
+  EnergyTotals t;
+  energyTotals(ENERGY_IDLE, t);
+  TEST_ASSERT_EQUAL(1500, t.ms);
+  TEST_ASSERT_EQUAL(12000, t.mJ);
+  TEST_ASSERT_EQUAL(8000, energyIdleMilliWatts());
+}
+
+void test_driving_goes_to_the_behavior_state() {
+  motionDrive(200, 200);
+  energySetActivity(ENERGY_ADVANCE);
+  energySample(15000, -1000, 1000);
+  for (unsigned long t = 1015; t <= 3000; t += 15) {
+    energySample(15000, -1000, t); // 15 W
+    energyDistance(1);
+  }
+  EnergyTotals t;
+  energyTotals(ENERGY_ADVANCE, t);
+  TEST_ASSERT_EQUAL(1995, t.ms);
+  TEST_ASSERT_EQUAL(29925, t.mJ);
+  // 30 J over 133 mm
+  TEST_ASSERT_EQUAL(133, t.mm);
+  TEST_ASSERT_EQUAL(29925UL * 1000 / 133, energyMilliJoulesPerMetre());
+  energyTotals(ENERGY_IDLE, t);
+  TEST_ASSERT_EQUAL(0, t.mJ);
+}
+
+void test_cues_gaps_and_charging() {
+  unsigned long now = millis();
+  energyCue(200);
+  energySample(16000, -600, now);
+  energySample(16000, -600, now + 15);
+  EnergyTotals t;
+  energyTotals(ENERGY_CUE, t);
+  TEST_ASSERT_EQUAL(15, t.ms);
+  TEST_ASSERT_EQUAL(144, t.mJ);
+  // A stream gap is not integrated
+  energySample(16000, -600, now + 1000);
+  energyTotals(ENERGY_IDLE, t);
+  TEST_ASSERT_EQUAL(0, t.ms);
+  // Charging counts time but no energy
+  energySample(16000, 1200, now + 1015);
+  energyTotals(ENERGY_IDLE, t);
+  TEST_ASSERT_EQUAL(15, t.ms);
+  TEST_ASSERT_EQUAL(0, t.mJ);
+}
+
+void test_cue_while_driving_takes_only_the_increment() {
+  motionDrive(200, 200);
+  energySetActivity(ENERGY_ADVANCE);
+  unsigned long now = millis();
+  draw(now, 300, 15000, -1000); // 15 W
+  energyCue(1000);
+  energySample(15000, -1200, now + 315); // 18 W with the song
+  energyDistance(2);
+  EnergyTotals t;
+  energyTotals(ENERGY_ADVANCE, t);
+  TEST_ASSERT_EQUAL(315, t.ms);
+  TEST_ASSERT_EQUAL(4725, t.mJ);
+  TEST_ASSERT_EQUAL(2, t.mm);
+  energyTotals(ENERGY_CUE, t);
+  TEST_ASSERT_EQUAL(15, t.ms);
+  TEST_ASSERT_EQUAL(45, t.mJ);
+  TEST_ASSERT_EQUAL(0, t.mm);
+  TEST_ASSERT_EQUAL(4725UL * 1000 / 2, energyMilliJoulesPerMetre());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_baseline);
+  RUN_TEST(test_driving_goes_to_the_behavior_state);
+  RUN_TEST(test_cues_gaps_and_charging);
+  RUN_TEST(test_cue_while_driving_takes_only_the_increment);
+  return UNITY_END();
+}
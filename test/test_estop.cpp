@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "control.h"
+#include "estop.h"
+#include "mode.h"
+#include "passthrough.h"
+#include "tx.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+void setUp() {
+  passthroughDisable();
+  initMode(MODE_FOREBRAIN);
+  estopClear();
+  txFlush();
+  Serial.clear();
+  CONTROL_SERIAL.clear();
+  Serial1.clear();
+}
+
+static std::string hostOut() {
+  txFlush();
+  return std::string(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+}
+
+// Stop frames (145,0,0,0,0) written to the robot
+static int stopFrames() {
+  const std::vector<uint8_t> &b = Serial1.buffer;
+  int n = 0;
+  for (size_t i = 0; i + 5 <= b.size(); ++i) {
+    if (b[i] == 145 && b[i + 1] == 0 && b[i + 2] == 0 && b[i + 3] == 0 && b[i + 4] == 0) n++;
+  }
+  return n;
+}
+
+void test_latch_accumulates_sources_and_clears_once() {
+  uint16_t count = estopCount();
+  estopSet(ESTOP_SRC_HOST);
+  TEST_ASSERT_TRUE(estopActive());
+  TEST_ASSERT_EQUAL(1, stopFrames());
+  estopSet(ESTOP_SRC_BUTTON); // already latched: stop again, no new edge
+  TEST_ASSERT_EQUAL_UINT8(ESTOP_SRC_HOST | ESTOP_SRC_BUTTON, estopSources());
+  TEST_ASSERT_EQUAL(2, stopFrames());
+  TEST_ASSERT_EQUAL_UINT16(count + 1, estopCount());
+  TEST_ASSERT_TRUE(estopClear());
+  TEST_ASSERT_FALSE(estopActive());
+  TEST_ASSERT_FALSE(estopClear());
+  std::string out = hostOut();
+  std::string seq = std::to_string(count + 1);
+  TEST_ASSERT_TRUE(out.find("ESTOP,1," + seq + ",eid=") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ESTOP,0," + seq + ",eid=") != std::string::npos);
+  TEST_ASSERT_EQUAL(out.find("ESTOP,1,"), out.rfind("ESTOP,1,"));
+}
+
+void test_stop_is_resent_every_100ms_while_latched() {
+  estopSet(ESTOP_SRC_HOST);
+  Serial1.clear();
+  unsigned long start = millis();
+  while (millis() - start < 350) estopTick();
+  int frames = stopFrames();
+  TEST_ASSERT_TRUE(frames >= 3 && frames <= 4);
+  estopClear();
+  Serial1.clear();
+  start = millis();
+  while (millis() - start < 350) estopTick();
+  TEST_ASSERT_EQUAL(0, stopFrames());
+}
+
+void test_bridge_drops_drive_frames_while_latched() {
+  modeSet(MODE_PASSTHROUGH);
+  estopSet(ESTOP_SRC_HOST);
+  Serial1.clear();
+  // Drive Direct, a sensor query, then Drive
+  Serial.rx = {145, 0, 100, 0, 100, 142, 7, 137, 0, 200, 0x80, 0x00};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_INT(2, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8(142, Serial1.buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(7, Serial1.buffer[1]);
+  // Cleared: drive frames pass again
+  estopClear();
+  Serial1.clear();
+  Serial.rx = {145, 0, 100, 0, 100};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_INT(5, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8(145, Serial1.buffer[0]);
+}
+
+void test_stop_completes_a_half_sent_bridged_command() {
+  // Same with and without drive shaping
+  for (int coalesce = 0; coalesce < 2; ++coalesce) {
+    passthroughSetCoalesce(coalesce != 0);
+    modeSet(MODE_PASSTHROUGH);
+    Serial1.clear();
+    // Drive Direct cut short after its first data byte pair
+    Serial.rx = {145, 0, 200};
+    passthroughPump();
+    estopSet(ESTOP_SRC_BUTTON);
+    const uint8_t want[] = {145, 0, 200, 0, 0, 145, 0, 0, 0, 0};
+    TEST_ASSERT_TRUE(Serial1.buffer.size() >= sizeof(want));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(want, Serial1.buffer.data(), sizeof(want));
+    // The rest of the cut command is dropped; the next one is framed as usual
+    Serial1.clear();
+    Serial.rx = {0, 200, 142, 7};
+    passthroughPump();
+    TEST_ASSERT_EQUAL_INT(2, Serial1.buffer.size());
+    TEST_ASSERT_EQUAL_UINT8(142, Serial1.buffer[0]);
+    estopClear();
+    modeSet(MODE_FOREBRAIN);
+  }
+  passthroughSetCoalesce(false);
+}
+
+void test_demos_and_scripts_are_held_while_latched() {
+  modeSet(MODE_PASSTHROUGH);
+  estopSet(ESTOP_SRC_HOST);
+  Serial1.clear();
+  // Spot, cover, demo 1, cover and dock, define a 2-byte script, play it
+  Serial.rx = {134, 135, 136, 1, 143, 152, 2, 137, 0, 153, 142, 7};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_INT(2, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8(142, Serial1.buffer[0]);
+}
+
+void test_safe_lines_latch_and_clear() {
+  controlHandleLine("SAFE,0");
+  TEST_ASSERT_TRUE(estopActive());
+  TEST_ASSERT_EQUAL_UINT8(ESTOP_SRC_HOST, estopSources());
+  controlHandleLine("SAFE,1");
+  TEST_ASSERT_FALSE(estopActive());
+  std::string out = hostOut();
+  TEST_ASSERT_TRUE(out.find("ESTOP,1,") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ESTOP,0,") != std::string::npos);
+  // No edge, no line
+  CONTROL_SERIAL.clear();
+  controlHandleLine("SAFE,1");
+  TEST_ASSERT_TRUE(hostOut().find("ESTOP") == std::string::npos);
+  controlHandleLine("SAFE,2");
+  TEST_ASSERT_FALSE(estopActive());
+  TEST_ASSERT_TRUE(hostOut().find("ERR,param,safe,eid=") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_latch_accumulates_sources_and_clears_once);
+  RUN_TEST(test_stop_is_resent_every_100ms_while_latched);
+  RUN_TEST(test_bridge_drops_drive_frames_while_latched);
+  RUN_TEST(test_stop_completes_a_half_sent_bridged_command);
+  RUN_TEST(test_demos_and_scripts_are_held_while_latched);
+  RUN_TEST(test_safe_lines_latch_and_clear);
+  return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+#include "fdr.h"
+#include "cdc_ctl.h"
+#include "Arduino.h"
+#include <string>
+#include <vector>
+
+HardwareSerial Serial1; // mock
+
+void setUp() {
+  fdrInit();
+  fdrSetTriggerMask(FDR_TRIG_CLIFF | FDR_TRIG_WATCHDOG);
+  CONTROL_SERIAL.clear();
+}
+
+// Dump the ring and return its record lines (hex payload only), oldest first
+static std::vector<std::string> dumpRecords() {
+  CONTROL_SERIAL.clear();
+  fdrDump();
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  std::vector<std::string> recs;
+  size_t pos = 0;
+  while (pos < out.size()) {
+    size_t nl = out.find('\n', pos);
+    if (nl == std::string::npos) nl = out.size();
+    std::string line = out.substr(pos, nl - pos);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.size() == 4 + 16 && line.compare(0, 4, "FDR,") == 0) recs.push_back(line.substr(4));
+    pos = nl + 1;
+  }
+  return recs;
+}
+
+// Record kind and a-field from a hex payload
+static unsigned recKind(const std::string &r) { return std::stoul(r.substr(4, 2), nullptr, 16); }
+static unsigned recA(const std::string &r) { return std::stoul(r.substr(6, 2), nullptr, 16); }
+
+void test_records_until_trigger_then_freezes() {
+  fdrRecord(FDR_DRIVE, 0, 50, 50);
+  TEST_ASSERT_FALSE(fdrFrozen());
+  fdrTrigger(FDR_TRIG_CLIFF);
+  TEST_ASSERT_TRUE(fdrFrozen());
+}
+
+void test_disabled_trigger_is_ignored() {
+  fdrTrigger(FDR_TRIG_BUMPS);
+  TEST_ASSERT_FALSE(fdrFrozen());
+}
+
+void test_frozen_ring_ignores_new_records_until_armed() {
+  fdrRecord(FDR_STATE, 7);
+  fdrTrigger(FDR_TRIG_WATCHDOG);
+  TEST_ASSERT_TRUE(fdrFrozen());
+  fdrRecord(FDR_STATE, 8);    // ignored while frozen
+  fdrTrigger(FDR_TRIG_CLIFF); // already frozen; first trigger wins
+  std::vector<std::string> recs = dumpRecords();
+  TEST_ASSERT_EQUAL_INT(2, recs.size());
+  TEST_ASSERT_EQUAL_UINT(FDR_STATE, recKind(recs[0]));
+  TEST_ASSERT_EQUAL_UINT(7, recA(recs[0]));
+  TEST_ASSERT_EQUAL_UINT(FDR_TRIGGER, recKind(recs[1]));
+  TEST_ASSERT_EQUAL_UINT(FDR_TRIG_WATCHDOG, recA(recs[1]));
+  fdrArm();
+  TEST_ASSERT_FALSE(fdrFrozen());
+  fdrRecord(FDR_STATE, 9);
+  recs = dumpRecords();
+  TEST_ASSERT_EQUAL_INT(3, recs.size());
+  TEST_ASSERT_EQUAL_UINT(9, recA(recs[2]));
+}
+
+void test_ring_wraps_without_overflow() {
+  const int total = FDR_RECORDS * 3 + 5;
+  for (int i = 0; i < total; ++i) fdrRecord(FDR_STATE, (uint8_t)i);
+  TEST_ASSERT_FALSE(fdrFrozen());
+  // Only the newest FDR_RECORDS survive, oldest first
+  std::vector<std::string> recs = dumpRecords();
+  TEST_ASSERT_EQUAL_INT(FDR_RECORDS, recs.size());
+  for (int i = 0; i < FDR_RECORDS; ++i) {
+    TEST_ASSERT_EQUAL_UINT(FDR_STATE, recKind(recs[i]));
+    TEST_ASSERT_EQUAL_UINT((uint8_t)(total - FDR_RECORDS + i), recA(recs[i]));
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_records_until_trigger_then_freezes);
+  RUN_TEST(test_disabled_trigger_is_ignored);
+  RUN_TEST(test_frozen_ring_ignores_new_records_until_armed);
+  RUN_TEST(test_ring_wraps_without_overflow);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "control.h"
+#include "governor.h"
+#include "mode.h"
+#include "sensors.h"
+#include "tx.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+// One stream frame with the battery packets
+static void battery(uint16_t mV, int16_t mA, uint16_t chargeMah, uint16_t capacityMah) {
+  const uint8_t body[] = { 22, (uint8_t)(mV >> 8), (uint8_t)mV,
+                           23, (uint8_t)((uint16_t)mA >> 8), (uint8_t)mA,
+                           25, (uint8_t)(chargeMah >> 8), (uint8_t)chargeMah,
+                           26, (uint8_t)(capacityMah >> 8), (uint8_t)capacityMah };
+  Serial1.rx.push_back(19);
+  Serial1.rx.push_back(sizeof(body));
+  for (uint8_t b : body) Serial1.rx.push_back(b);
+  Serial1.rx.push_back(0); // checksum (not verified)
+  updateSensorStream();
+}
+
+static uint32_t now = 100000;
+
+static void tick(uint8_t n) {
+  for (uint8_t i = 0; i < n; ++i) {
+    now += GOV_TICK_MS;
+    governorTick(now);
+  }
+}
+
+void setUp() {
+  governorSetFullPct(60);
+  governorSetFloorPct(25);
+  governorSetMinLevel(30);
+  governorSetBudgetMin(0, now);
+  governorReset();
+  setBatteryPercentOverride(-1);
+  battery(0, 0, 0, 0);
+  txFlush();
+  CONTROL_SERIAL.clear();
+}
+
+void test_policy_curve() {
+  setBatteryPercentOverride(100);
+  tick(1);
+  TEST_ASSERT_EQUAL(100, governorLevel());
+  setBatteryPercentOverride(42);
+  tick(1);
+  TEST_ASSERT_EQUAL(30 + 70 * 17 / 35, governorLevel());
+  setBatteryPercentOverride(10);
+  tick(1);
+  TEST_ASSERT_EQUAL(30, governorLevel());
+  // No discharge seen: runtime unknown
+  TEST_ASSERT_EQUAL(GOV_RUNTIME_UNKNOWN, governorRuntimeMin());
+}
+
+void test_runtime_from_charge_and_draw() {
+  battery(16000, -1000, 1500, 3000);
+  TEST_ASSERT_EQUAL(50, batteryPercent());
+  tick(1);
+  // (1500 - 20% of 3000) mAh at 1 A
+  TEST_ASSERT_EQUAL(54, governorRuntimeMin());
+  TEST_ASSERT_EQUAL(80, governorLevel());
+  // Charging: no prediction
+  battery(16000, 500, 1500, 3000);
+  tick(1);
+  TEST_ASSERT_EQUAL(GOV_RUNTIME_UNKNOWN, governorRuntimeMin());
+}
+
+void test_budget_trims_then_recovers() {
+  battery(16000, -1000, 1500, 3000);
+  governorSetBudgetMin(120, now);
+  tick(10);
+  TEST_ASSERT_EQUAL(80 * 80 / 100, governorLevel());
+  tick(60);
+  TEST_ASSERT_EQUAL(30, governorLevel()); // never below the minimum
+  // A budget the battery covers lets the level climb back
+  governorSetBudgetMin(30, now);
+  tick(100);
+  TEST_ASSERT_EQUAL(80, governorLevel());
+}
+
+void test_bridge_session_drops_the_budget() {
+  initMode(MODE_FOREBRAIN);
+  battery(16000, -1000, 1500, 3000);
+  governorSetBudgetMin(120, now);
+  tick(10);
+  TEST_ASSERT_EQUAL(80 * 80 / 100, governorLevel());
+  modeSet(MODE_PASSTHROUGH);
+  TEST_ASSERT_EQUAL(100, governorLevel());
+  // Back in managed mode only the curve applies
+  modeSet(MODE_FOREBRAIN);
+  tick(10);
+  TEST_ASSERT_EQUAL(80, governorLevel());
+}
+
+void test_set_keys_and_bat_report() {
+  controlHandleLine("SET,gov_floor_pct,70"); // not below full
+  controlHandleLine("SET,gov_full_pct,80");
+  controlHandleLine("SET,task_budget_min,45");
+  battery(15800, -800, 2400, 3000);
+  tick(GOV_REPORT_MS / GOV_TICK_MS + 1);
+  txFlush();
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  TEST_ASSERT_TRUE(out.find("ERR,param,gov_floor_pct") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ACK,gov_full_pct,80") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ACK,task_budget_min,45") != std::string::npos);
+  // 80% is at the top of the curve; (2400 - 600) mAh at 0.8 A = 135 min
+  TEST_ASSERT_TRUE(out.find("BAT,15800,80,0,135,100,eid=") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_policy_curve);
+  RUN_TEST(test_runtime_from_charge_and_draw);
+  RUN_TEST(test_budget_trims_then_recovers);
+  RUN_TEST(test_bridge_session_drops_the_budget);
+  RUN_TEST(test_set_keys_and_bat_report);
+  return UNITY_END();
+}
@@ -0,0 +1,52 @@
+#include <unity.h>
+#include "mode.h"
+#include "motion.h"
+#include "passthrough.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+void setUp() {
+  initMode(MODE_PASSTHROUGH);
+}
+
+void test_leaving_passthrough_hands_motion_to_host() {
+  TEST_ASSERT_TRUE(passthroughActive());
+  TEST_ASSERT_EQUAL(MOTION_OWNER_BRIDGE, motionOwner());
+  modeSet(MODE_FOREBRAIN);
+  TEST_ASSERT_FALSE(passthroughActive());
+  TEST_ASSERT_EQUAL(MODE_FOREBRAIN, modeCurrent());
+  TEST_ASSERT_EQUAL(MOTION_OWNER_HOST, motionOwner());
+}
+
+void test_switch_resumes_stream_without_reconfiguring() {
+  modeSet(MODE_FOREBRAIN);
+  Serial1.buffer.clear();
+  modeSet(MODE_PASSTHROUGH);
+  modeSet(MODE_AUTONOMOUS);
+  // Two handoff stops and pause/resume only -- no STREAM (148) setup
+  for (size_t i = 0; i < Serial1.buffer.size(); ++i) {
+    TEST_ASSERT_NOT_EQUAL(148, Serial1.buffer[i]);
+  }
+  TEST_ASSERT_EQUAL(MOTION_OWNER_BEHAVIOR, motionOwner());
+  TEST_ASSERT_TRUE(modeSwitches() >= 3);
+}
+
+void test_pause_and_resume_keep_mode() {
+  modeSet(MODE_AUTONOMOUS);
+  modePause();
+  TEST_ASSERT_TRUE(modePaused());
+  TEST_ASSERT_EQUAL(MOTION_OWNER_NONE, motionOwner());
+  modeResume();
+  TEST_ASSERT_FALSE(modePaused());
+  TEST_ASSERT_EQUAL(MODE_AUTONOMOUS, modeCurrent());
+  TEST_ASSERT_EQUAL(MOTION_OWNER_BEHAVIOR, motionOwner());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_leaving_passthrough_hands_motion_to_host);
+  RUN_TEST(test_switch_resumes_stream_without_reconfiguring);
+  RUN_TEST(test_pause_and_resume_keep_mode);
+  return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include "numfmt.h"
+#include "Arduino.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+HardwareSerial Serial1; // mock
+
+// Host-side reference: the C library's integer formatting.
+static void refFixed(char* out, size_t n, int32_t scaled, uint8_t decimals) {
+  if (decimals == 0) { snprintf(out, n, "%ld", (long)scaled); return; }
+  long long p = 1;
+  for (uint8_t i = 0; i < decimals; ++i) p *= 10;
+  long long u = scaled < 0 ? -(long long)scaled : scaled;
+  snprintf(out, n, "%s%lld.%0*lld", scaled < 0 ? "-" : "", u / p, (int)decimals, u % p);
+}
+
+static void checkFixed(int32_t scaled, uint8_t decimals) {
+  char got[NUMFMT_MAX_LEN + 1];
+  char want[32];
+  got[fmtFixed(got, scaled, decimals)] = '\0';
+  refFixed(want, sizeof(want), scaled, decimals);
+  TEST_ASSERT_EQUAL_STRING(want, got);
+}
+
+void setUp() {}
+
+void test_u32_matches_reference_exhaustive_low_range() {
+  char got[NUMFMT_MAX_LEN + 1];
+  char want[16];
+  for (uint32_t v = 0; v < 100000; ++v) {
+    got[fmtU32(got, v)] = '\0';
+    snprintf(want, sizeof(want), "%lu", (unsigned long)v);
+    TEST_ASSERT_EQUAL_STRING(want, got);
+  }
+}
+
+void test_u32_matches_reference_sampled_full_range() {
+  char got[NUMFMT_MAX_LEN + 1];
+  char want[16];
+  uint32_t v = 1;
+  for (int i = 0; i < 200000; ++i) {
+    v = v * 1664525u + 1013904223u;
+    got[fmtU32(got, v)] = '\0';
+    snprintf(want, sizeof(want), "%lu", (unsigned long)v);
+    TEST_ASSERT_EQUAL_STRING(want, got);
+  }
+  got[fmtU32(got, 0xFFFFFFFFu)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("4294967295", got);
+}
+
+void test_i32_extremes() {
+  char got[NUMFMT_MAX_LEN + 1];
+  got[fmtI32(got, INT32_MIN)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("-2147483648", got);
+  got[fmtI32(got, -7)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("-7", got);
+}
+
+void test_fixed_matches_reference() {
+  const int32_t samples[] = { 0, 1, -1, 5, -5, 999, 1000, -1000, 1234, -31416, 123456789, INT32_MAX, INT32_MIN + 1 };
+  for (uint8_t d = 0; d <= NUMFMT_MAX_DECIMALS; ++d) {
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i) checkFixed(samples[i], d);
+  }
+}
+
+void test_float_rounds_half_away_from_zero() {
+  char got[NUMFMT_MAX_LEN + 1];
+  got[fmtFloat(got, 1.2346f, 3)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("1.235", got);
+  got[fmtFloat(got, -0.0004f, 3)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("0.000", got);
+  got[fmtFloat(got, -3.14159f, 2)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("-3.14", got);
+}
+
+void test_float_non_finite_is_bounded() {
+  char got[NUMFMT_MAX_LEN + 1];
+  got[fmtFloat(got, NAN, 3)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("0.000", got);
+  got[fmtFloat(got, INFINITY, 3)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("2147483.520", got);
+  got[fmtFloat(got, -INFINITY, 0)] = '\0';
+  TEST_ASSERT_EQUAL_STRING("-2147483520", got);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_u32_matches_reference_exhaustive_low_range);
+  RUN_TEST(test_u32_matches_reference_sampled_full_range);
+  RUN_TEST(test_i32_extremes);
+  RUN_TEST(test_fixed_matches_reference);
+  RUN_TEST(test_float_rounds_half_away_from_zero);
+  RUN_TEST(test_float_non_finite_is_bounded);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#include <unity.h>
+#include "oi.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+static OiFramer f;
+static OiShaper s;
+
+void setUp() {
+  oiFramerReset(f);
+  oiShaperReset(s);
+  s.coalesced = 0;
+}
+
+static void push(const uint8_t* b, int n) {
+  for (int i = 0; i < n; ++i) TEST_ASSERT_TRUE(oiShaperPush(s, b[i]));
+}
+
+// Count opcode starts in a byte sequence
+static int opcodes(const uint8_t* b, int n) {
+  int c = 0;
+  for (int i = 0; i < n; ++i) if (oiFramerFeed(f, b[i])) c++;
+  return c;
+}
+
+void test_drive_data_bytes_are_not_opcodes() {
+  // Drive Direct with data bytes that look like opcodes (137, 145)
+  const uint8_t b[] = { 145, 0, 137, 0, 145, 128 };
+  TEST_ASSERT_EQUAL(2, opcodes(b, sizeof(b)));
+  TEST_ASSERT_TRUE(oiIsDriveOpcode(145));
+  TEST_ASSERT_FALSE(oiIsDriveOpcode(128));
+}
+
+void test_stream_and_query_lists_are_counted() {
+  // Stream: count 2, ids 137 145; Query List: count 1, id 145; then Start
+  const uint8_t b[] = { 148, 2, 137, 145, 149, 1, 145, 128 };
+  TEST_ASSERT_EQUAL(3, opcodes(b, sizeof(b)));
+}
+
+void test_song_definition_spans_2n_bytes() {
+  // Song #0 with 2 notes, then Play song 0, then Drive Direct
+  const uint8_t b[] = { 140, 0, 2, 145, 16, 137, 16, 141, 0, 145, 0, 0, 0, 0 };
+  TEST_ASSERT_EQUAL(3, opcodes(b, sizeof(b)));
+}
+
+void test_shaper_newest_drive_replaces_queued_one() {
+  // Drive, sensor request, drive: the second drive takes the first's place
+  const uint8_t b[] = { 145, 0, 100, 0, 100, 142, 7, 145, 0, 200, 0, 200 };
+  push(b, sizeof(b));
+  const uint8_t want[] = { 145, 0, 200, 0, 200, 142, 7 };
+  TEST_ASSERT_EQUAL(sizeof(want), s.len);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(want, s.buf, sizeof(want));
+  TEST_ASSERT_EQUAL(1, s.coalesced);
+}
+
+void test_shaper_keeps_order_across_other_commands() {
+  // A mode change between drives pins the older one; a drive already
+  // partly on the wire is never rewritten
+  const uint8_t b[] = { 137, 0, 50, 128, 0, 131, 137, 0, 60, 128, 0 };
+  push(b, sizeof(b));
+  TEST_ASSERT_EQUAL(sizeof(b), s.len);
+  oiShaperConsume(s, 7);
+  const uint8_t c[] = { 137, 0, 70, 128, 0 };
+  push(c, sizeof(c));
+  TEST_ASSERT_EQUAL(0, s.coalesced);
+  TEST_ASSERT_EQUAL(4 + 5, s.len);
+  TEST_ASSERT_EQUAL(60, s.buf[1]);
+}
+
+void test_shaper_drops_pending_drives() {
+  const uint8_t b[] = { 145, 0, 1, 0, 1, 141, 0, 145, 0 };
+  push(b, sizeof(b));
+  oiShaperConsume(s, 2);
+  // Under ESTOP: the started head stays, the open tail is still arriving
+  oiShaperDropDrives(s);
+  TEST_ASSERT_EQUAL(3 + 2 + 2, s.len);
+  oiShaperDropPending(s);
+  TEST_ASSERT_EQUAL(3, s.len);
+  TEST_ASSERT_EQUAL(OI_SHAPER_FRAMES - 1, oiShaperRoom(s));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_drive_data_bytes_are_not_opcodes);
+  RUN_TEST(test_stream_and_query_lists_are_counted);
+  RUN_TEST(test_song_definition_spans_2n_bytes);
+  RUN_TEST(test_shaper_newest_drive_replaces_queued_one);
+  RUN_TEST(test_shaper_keeps_order_across_other_commands);
+  RUN_TEST(test_shaper_drops_pending_drives);
+  return UNITY_END();
+}
@@ -58,11 +58,56 @@ void test_reenable_passthrough() {
   TEST_ASSERT_EQUAL_UINT8(0x33, Serial1.buffer[0]);
 }
 
+void test_bridged_bytes_are_counted() {
+  passthroughEnable();
+  Serial.clear();
+  Serial1.clear();
+  uint32_t toRobot = passthroughBytesToRobot();
+  uint32_t toHost = passthroughBytesToHost();
+  Serial.rx = {0x80, 0x83};
+  Serial1.rx = {0x01, 0x02, 0x03};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_UINT32(toRobot + 2, passthroughBytesToRobot());
+  TEST_ASSERT_EQUAL_UINT32(toHost + 3, passthroughBytesToHost());
+}
+
+void test_negative_drive_is_not_an_escape() {
+  passthroughEnable();
+  Serial.clear();
+  Serial1.clear();
+  // Drive at -256 mm/s, straight, then a sensor request
+  Serial.rx = {137, 0xFF, 0x00, 0x80, 0x00, 142, 7};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_INT(7, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8(137, Serial1.buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(0xFF, Serial1.buffer[1]);
+  TEST_ASSERT_EQUAL_UINT8(0x00, Serial1.buffer[2]);
+  TEST_ASSERT_EQUAL_UINT8(0x80, Serial1.buffer[3]);
+  TEST_ASSERT_EQUAL_UINT8(0x00, Serial1.buffer[4]);
+  TEST_ASSERT_EQUAL_UINT8(142, Serial1.buffer[5]);
+  TEST_ASSERT_EQUAL_UINT8(7, Serial1.buffer[6]);
+}
+
+void test_escape_needs_bang() {
+  passthroughEnable();
+  Serial.clear();
+  Serial1.clear();
+  Serial.rx = {0xFF, 0x00, 0x80};
+  passthroughPump();
+  TEST_ASSERT_EQUAL_INT(3, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL_UINT8(0xFF, Serial1.buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(0x00, Serial1.buffer[1]);
+  TEST_ASSERT_EQUAL_UINT8(0x80, Serial1.buffer[2]);
+}
+
 int main(int argc, char **argv) {
   UNITY_BEGIN();
   RUN_TEST(test_usb_to_robot);
   RUN_TEST(test_robot_to_usb);
   RUN_TEST(test_exit_on_nul);
   RUN_TEST(test_reenable_passthrough);
+  RUN_TEST(test_bridged_bytes_are_counted);
+  RUN_TEST(test_negative_drive_is_not_an_escape);
+  RUN_TEST(test_escape_needs_bang);
   return UNITY_END();
 }
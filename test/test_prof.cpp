@@ -0,0 +1,40 @@
+#include <unity.h>
+#include "prof.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+void setUp() { profStart(1000); }
+void tearDown() { profStop(); }
+
+void test_samples_in_one_bucket_share_a_count() {
+  // Word addresses 0x100..0x107 fall in one 8-word bucket
+  for (uint16_t pc = 0x100; pc < 0x108; ++pc) profSample(pc);
+  TEST_ASSERT_TRUE(profRunning());
+  TEST_ASSERT_EQUAL(8, profSamples());
+  TEST_ASSERT_EQUAL(0, profDropped());
+  profDump();
+}
+
+void test_stopped_profiler_ignores_samples() {
+  profStop();
+  TEST_ASSERT_FALSE(profRunning());
+  profSample(0x200);
+  TEST_ASSERT_EQUAL(0, profSamples());
+}
+
+void test_full_table_counts_drops_without_overrun() {
+  // Far more distinct buckets than slots
+  for (uint16_t i = 0; i < PROF_BUCKETS * 4; ++i) profSample((uint16_t)(i << PROF_SHIFT));
+  TEST_ASSERT_EQUAL(PROF_BUCKETS * 4, profSamples());
+  TEST_ASSERT_EQUAL(PROF_BUCKETS * 3, profDropped());
+  profDump();
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_samples_in_one_bucket_share_a_count);
+  RUN_TEST(test_stopped_profiler_ignores_samples);
+  RUN_TEST(test_full_table_counts_drops_without_overrun);
+  return UNITY_END();
+}
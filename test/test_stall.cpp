@@ -0,0 +1,96 @@
+#include <unity.h>
+#include "motion.h"
+#include "sensors.h"
+#include "stall.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+// One stream frame: bumps/drops, overcurrents, distance and angle
+static void frame(uint8_t bumps, uint8_t oc, int16_t distMm, int16_t angleDeg) {
+  const uint8_t body[] = { 7, bumps, 14, oc,
+                           19, (uint8_t)(distMm >> 8), (uint8_t)distMm,
+                           20, (uint8_t)(angleDeg >> 8), (uint8_t)angleDeg };
+  Serial1.rx.push_back(19);
+  Serial1.rx.push_back(sizeof(body));
+  uint8_t sum = 19 + sizeof(body);
+  for (uint8_t b : body) {
+    Serial1.rx.push_back(b);
+    sum += b;
+  }
+  Serial1.rx.push_back((uint8_t)(0 - sum));
+  updateSensorStream();
+}
+
+void setUp() {
+  setMotionOwner(MOTION_OWNER_BEHAVIOR);
+  motionDrive(0, 0);
+  frame(0, 0, 0, 0);
+  stallReset();
+  Serial1.clear();
+}
+
+void test_frames_carry_odometry_and_drops() {
+  frame(0, 0, 10, -2);
+  frame(0x0C, 0x10, 5, 0); // both wheels dropped, left wheel overcurrent
+  int16_t d, a;
+  TEST_ASSERT_EQUAL(2, sensorsTakeOdometry(d, a));
+  TEST_ASSERT_EQUAL(15, d);
+  TEST_ASSERT_EQUAL(-2, a);
+  TEST_ASSERT_EQUAL(3, sensorsWheelDrops());
+  TEST_ASSERT_EQUAL(0x10, sensorsOvercurrents());
+  TEST_ASSERT_EQUAL(0, sensorsTakeOdometry(d, a));
+  // Bare id/value pairs still parse outside a frame
+  Serial1.rx.push_back(9);
+  Serial1.rx.push_back(1);
+  updateSensorStream();
+  TEST_ASSERT_TRUE(cliffDetected());
+  Serial1.rx.push_back(9);
+  Serial1.rx.push_back(0);
+  updateSensorStream();
+}
+
+// Drive at the behavior's cruise speed, stream frames every 15 ms and return
+// the time stallUpdate() first reported reason (0 if it never did)
+static unsigned long driveUntil(uint8_t reason, uint8_t oc, int16_t mmPerFrame, unsigned long forMs) {
+  motionDrive(200, 200);
+  for (unsigned long now = 1000; now < 1000 + forMs; now += 15) {
+    frame(0, oc, mmPerFrame, 0);
+    if (stallUpdate(now) == reason) return now - 1000;
+  }
+  return 0;
+}
+
+void test_wedged_wheels_are_a_slip_within_a_second() {
+  unsigned long at = driveUntil(STALL_SLIP, 0, 0, 3000);
+  TEST_ASSERT_TRUE(at > 0);
+  TEST_ASSERT_TRUE(at < 1000);
+}
+
+void test_free_driving_is_not_stuck() {
+  uint16_t before = stallEvents();
+  // 50 mm/s sent (25% scale) shows up as ~1 mm per 15 ms frame
+  TEST_ASSERT_EQUAL(0, driveUntil(STALL_SLIP, 0, 1, 3000));
+  TEST_ASSERT_EQUAL(before, stallEvents());
+}
+
+void test_wheel_overcurrent_trips_quickly() {
+  unsigned long at = driveUntil(STALL_OVERCURRENT, 0x08, 1, 1000);
+  TEST_ASSERT_TRUE(at >= STALL_OC_MS);
+  TEST_ASSERT_TRUE(at < STALL_OC_MS + 50);
+  // Stopped wheels never stall
+  motionDrive(0, 0);
+  for (unsigned long now = 2000; now < 3000; now += 15) {
+    frame(0x0C, 0x18, 0, 0);
+    TEST_ASSERT_EQUAL(STALL_NONE, stallUpdate(now));
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_carry_odometry_and_drops);
+  RUN_TEST(test_wedged_wheels_are_a_slip_within_a_second);
+  RUN_TEST(test_free_driving_is_not_stuck);
+  RUN_TEST(test_wheel_overcurrent_trips_quickly);
+  return UNITY_END();
+}
@@ -0,0 +1,156 @@
+#include <unity.h>
+#include "cdc_ctl.h"
+#include "control.h"
+#include "telemetry.h"
+#include "sensors.h"
+#include "tx.h"
+#include "Arduino.h"
+#include <string>
+
+HardwareSerial Serial1; // mock
+
+static void feed(uint8_t id, uint8_t value) {
+  Serial1.rx.push_back(id);
+  Serial1.rx.push_back(value);
+  updateSensorStream();
+}
+
+// One stream frame with distance and angle
+static void odomFrame(int16_t distMm, int16_t angleDeg) {
+  const uint8_t body[] = { 19, (uint8_t)(distMm >> 8), (uint8_t)distMm,
+                           20, (uint8_t)(angleDeg >> 8), (uint8_t)angleDeg };
+  Serial1.rx.push_back(19);
+  Serial1.rx.push_back(sizeof(body));
+  uint8_t sum = 19 + sizeof(body);
+  for (uint8_t b : body) {
+    Serial1.rx.push_back(b);
+    sum += b;
+  }
+  Serial1.rx.push_back((uint8_t)(0 - sum));
+  updateSensorStream();
+}
+
+void setUp() {
+  telemetryForceKeyframe();
+  telemetryTick();
+  txFlush();
+}
+
+void test_quiet_snapshot_sends_nothing_between_keyframes() {
+  uint32_t eid = txLastEid();
+  telemetryTick();
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid, txLastEid());
+}
+
+void test_change_sends_one_record() {
+  uint32_t eid = txLastEid();
+  feed(9, 1); // cliff left
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid + 1, txLastEid());
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid + 1, txLastEid());
+  feed(9, 0);
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid + 2, txLastEid());
+}
+
+void test_keyframe_after_period() {
+  uint32_t eid = txLastEid();
+  mockClockUs() += (unsigned long)TELEM_KEYFRAME_MS * 1000;
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid + 1, txLastEid());
+}
+
+void test_odom_dead_reckons_with_three_decimals() {
+  TEST_ASSERT_FALSE(telemetrySetOdomHz(TELEM_ODOM_MAX_HZ + 1));
+  // 100 mm ahead, a quarter turn left, 100 mm ahead
+  odomFrame(100, 90);
+  odomFrame(100, 0);
+  TEST_ASSERT_TRUE(telemetrySetOdomHz(10));
+  CONTROL_SERIAL.buffer.clear();
+  uint32_t eid = txLastEid();
+  telemetryTick();
+  txFlush();
+  TEST_ASSERT_EQUAL(eid + 1, txLastEid());
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  TEST_ASSERT_EQUAL(0, (int)out.find("ODOM,0.100,0.100,1.571,"));
+  TEST_ASSERT_TRUE(out.find(",1,eid=") != std::string::npos);
+  // Nothing more until the period has passed
+  telemetryTick();
+  TEST_ASSERT_EQUAL(eid + 1, txLastEid());
+  telemetrySetOdomHz(0);
+}
+
+// eids of the lines in the control port output, in order
+static std::vector<uint32_t> sentEids() {
+  txFlush();
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  std::vector<uint32_t> eids;
+  for (size_t p = out.find(",eid="); p != std::string::npos; p = out.find(",eid=", p + 1)) {
+    eids.push_back((uint32_t)strtoul(out.c_str() + p + 5, nullptr, 10));
+  }
+  return eids;
+}
+
+static std::string sentText() {
+  return std::string(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+}
+
+void test_replay_resends_recent_lines_once() {
+  controlHandleLine("PING,1");
+  controlHandleLine("PING,2");
+  controlHandleLine("PING,3");
+  txFlush();
+  uint32_t last = txLastEid();
+  CONTROL_SERIAL.clear();
+  controlHandleLine(("REPLAY," + std::to_string(last - 2)).c_str());
+  std::vector<uint32_t> eids = sentEids();
+  TEST_ASSERT_EQUAL(2, eids.size());
+  TEST_ASSERT_EQUAL(last - 1, eids[0]);
+  TEST_ASSERT_EQUAL(last, eids[1]);
+  TEST_ASSERT_TRUE(sentText().find("PONG,2,eid=") == 0);
+  // Replays spend no eids, and a second one finds each line once
+  TEST_ASSERT_EQUAL(last, txLastEid());
+  CONTROL_SERIAL.clear();
+  controlHandleLine(("REPLAY," + std::to_string(last - 2)).c_str());
+  eids = sentEids();
+  TEST_ASSERT_EQUAL(2, eids.size());
+  TEST_ASSERT_EQUAL(last - 1, eids[0]);
+  TEST_ASSERT_EQUAL(last, eids[1]);
+}
+
+void test_replay_past_the_ring_reports_missing() {
+  uint32_t since = txLastEid();
+  for (int i = 0; i < 40; ++i) {
+    controlHandleLine(("PING," + std::to_string(i)).c_str());
+    txFlush();
+  }
+  uint32_t last = txLastEid();
+  CONTROL_SERIAL.clear();
+  controlHandleLine(("REPLAY," + std::to_string(since)).c_str());
+  std::vector<uint32_t> eids = sentEids();
+  // The newest lines come back in order, then the ERR on a fresh eid
+  TEST_ASSERT_TRUE(eids.size() > 3);
+  TEST_ASSERT_TRUE(eids[0] > since + 1);
+  for (size_t i = 1; i + 1 < eids.size(); ++i) TEST_ASSERT_EQUAL(eids[i - 1] + 1, eids[i]);
+  TEST_ASSERT_EQUAL(last, eids[eids.size() - 2]);
+  TEST_ASSERT_EQUAL(last + 1, eids.back());
+  TEST_ASSERT_TRUE(sentText().find("ERR,evt,missing") != std::string::npos);
+  // ...and the snapshot is repaired by a keyframe
+  CONTROL_SERIAL.clear();
+  telemetryTick();
+  txFlush();
+  TEST_ASSERT_TRUE(sentText().find("SNS,143,") == 0);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_quiet_snapshot_sends_nothing_between_keyframes);
+  RUN_TEST(test_change_sends_one_record);
+  RUN_TEST(test_keyframe_after_period);
+  RUN_TEST(test_odom_dead_reckons_with_three_decimals);
+  RUN_TEST(test_replay_resends_recent_lines_once);
+  RUN_TEST(test_replay_past_the_ring_reports_missing);
+  return UNITY_END();
+}
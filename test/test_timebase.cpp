@@ -0,0 +1,31 @@
+#include <unity.h>
+#include "timebase.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+void setUp() { initTimebase(); }
+
+void test_ticks_are_half_microseconds() {
+  uint32_t t0 = tbTicks();
+  mockClockUs() += 1000;
+  uint32_t dt = tbTicks() - t0;
+  // 1000 us plus the few microseconds each virtual-clock read advances
+  TEST_ASSERT_TRUE(tbTicksToUs(dt) >= 1000 && tbTicksToUs(dt) < 1010);
+  TEST_ASSERT_EQUAL(0, dt % TB_TICKS_PER_US);
+}
+
+void test_millis_follow_the_same_clock() {
+  uint32_t m0 = tbMillis();
+  mockClockUs() += 25000;
+  uint32_t m1 = tbMillis();
+  TEST_ASSERT_EQUAL(25, m1 - m0);
+  TEST_ASSERT_TRUE(tbMicros() / 1000 >= m1);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ticks_are_half_microseconds);
+  RUN_TEST(test_millis_follow_the_same_clock);
+  return UNITY_END();
+}
@@ -0,0 +1,127 @@
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "control.h"
+#include "mode.h"
+#include "motion.h"
+#include "traj.h"
+#include "tx.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+void setUp() {
+  initMode(MODE_FOREBRAIN);
+  setMotionOwner(MOTION_OWNER_HOST);
+  trajClear();
+  CONTROL_SERIAL.clear();
+  Serial1.clear();
+}
+
+// Wheel speeds of the last Drive Direct frame sent (false if none)
+static bool lastDrive(int16_t &right, int16_t &left) {
+  const std::vector<uint8_t> &b = Serial1.buffer;
+  if (b.size() < 5 || b[b.size() - 5] != 145) return false;
+  right = (int16_t)((b[b.size() - 4] << 8) | b[b.size() - 3]);
+  left = (int16_t)((b[b.size() - 2] << 8) | b[b.size() - 1]);
+  return true;
+}
+
+static size_t frames() { return Serial1.buffer.size() / 5; }
+
+void test_points_are_interpolated_on_schedule() {
+  int16_t r, l;
+  TEST_ASSERT_TRUE(trajPush(1000, 0, 0));
+  TEST_ASSERT_TRUE(trajPush(1100, 200, 100));
+  TEST_ASSERT_TRUE(trajPush(1200, 0, 0));
+  TEST_ASSERT_FALSE(trajPush(1200, 50, 50)); // not after the last point
+  trajTick(990);
+  TEST_ASSERT_EQUAL(0, frames());
+  trajTick(1050);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(100, r);
+  TEST_ASSERT_EQUAL(50, l);
+  // Inside the frame period: nothing new
+  trajTick(1055);
+  TEST_ASSERT_EQUAL(1, frames());
+  // A point goes out on its own time
+  trajTick(1100);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200, r);
+  trajTick(1150);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(100, r);
+  TEST_ASSERT_EQUAL(50, l);
+  // The final stop ends the trajectory
+  trajTick(1201);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(0, r);
+  TEST_ASSERT_EQUAL(0, trajDepth());
+  TEST_ASSERT_FALSE(trajRunning());
+  TEST_ASSERT_EQUAL(0, trajUnderruns());
+}
+
+void test_running_dry_is_an_underrun() {
+  int16_t r, l;
+  trajPush(1000, 150, 150);
+  trajTick(1000);
+  trajTick(1040);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(150, r);
+  // Past the grace period with no next point: stop and report
+  trajTick(1060);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(0, r);
+  TEST_ASSERT_EQUAL(0, l);
+  TEST_ASSERT_EQUAL(1, trajUnderruns());
+  txFlush();
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  TEST_ASSERT_TRUE(out.find("TRAJ,underrun,1,eid=") != std::string::npos);
+}
+
+void test_host_lines_queue_points() {
+  controlHandleLine("TRAJ,5000,100,-100");
+  controlHandleLine("TRAJV,5100,0.2,0");
+  TEST_ASSERT_EQUAL(2, trajDepth());
+  controlHandleLine("TRAJ,4000,0,0"); // out of order
+  controlHandleLine("TRAJ,6000,abc");
+  TEST_ASSERT_EQUAL(2, trajDepth());
+  int16_t r, l;
+  trajTick(5100);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200, r);
+  TEST_ASSERT_EQUAL(200, l);
+  controlHandleLine("TRAJ,clear");
+  TEST_ASSERT_EQUAL(0, trajDepth());
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(0, r);
+  txFlush();
+  std::string out(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+  TEST_ASSERT_TRUE(out.find("ERR,param,traj") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ERR,parse,traj") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ACK,traj,clear") != std::string::npos);
+  // Only the forebrain plays trajectories
+  modeSet(MODE_AUTONOMOUS);
+  controlHandleLine("TRAJ,7000,100,100");
+  TEST_ASSERT_EQUAL(0, trajDepth());
+}
+
+void test_out_of_range_speeds_clamp_not_wrap() {
+  // 65636 would narrow to 100 before the clamp
+  controlHandleLine("TRAJ,9000,65636,-65636");
+  controlHandleLine("TRAJ,9100,0,0");
+  int16_t r, l;
+  trajTick(9000);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(TRAJ_MAX_MM_S, r);
+  TEST_ASSERT_EQUAL(-TRAJ_MAX_MM_S, l);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_points_are_interpolated_on_schedule);
+  RUN_TEST(test_running_dry_is_an_underrun);
+  RUN_TEST(test_host_lines_queue_points);
+  RUN_TEST(test_out_of_range_speeds_clamp_not_wrap);
+  return UNITY_END();
+}
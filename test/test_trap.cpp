@@ -0,0 +1,60 @@
+#include <unity.h>
+#include "trap.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock
+
+void setUp() { trapReset(); }
+
+void test_corner_alternation_escalates() {
+  // Right, left, right at the same spot a few seconds apart
+  TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(1, 0, 1000));
+  TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(-1, 90, 3000));
+  TEST_ASSERT_EQUAL(TRAP_WIDE_TURN, trapBump(1, 180, 5000));
+  TEST_ASSERT_TRUE(trapActive());
+  TEST_ASSERT_EQUAL(TRAP_REVERSE_ARC, trapBump(-1, 90, 7000));
+  TEST_ASSERT_EQUAL(TRAP_WALL_FOLLOW, trapBump(1, 0, 9000));
+  TEST_ASSERT_EQUAL(TRAP_WALL_FOLLOW, trapBump(-1, 90, 11000));
+}
+
+void test_same_heading_cycle_is_a_trap() {
+  TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(1, 170, 1000));
+  TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(1, 60, 4000));
+  // Third bump near the first heading (across the ±180 wrap) is not enough...
+  TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(1, -175, 7000));
+  // ...the fourth, with two earlier revisits, is
+  TEST_ASSERT_EQUAL(TRAP_WIDE_TURN, trapBump(1, 180, 10000));
+}
+
+void test_old_bumps_decay() {
+  // Sparse bumps across a large room never build up
+  for (unsigned long t = 1000; t < 200000; t += 25000) {
+    TEST_ASSERT_EQUAL(TRAP_NONE, trapBump(t % 2 ? 1 : -1, 0, t));
+    TEST_ASSERT_EQUAL(1, trapRecentBumps(t));
+  }
+  TEST_ASSERT_FALSE(trapActive());
+}
+
+void test_escape_time_is_reported_once_clear() {
+  uint16_t episodes = trapEpisodes();
+  trapBump(1, 0, 1000);
+  trapBump(-1, 90, 2000);
+  trapBump(1, 0, 3000);
+  trapBump(-1, 90, 4500);
+  TEST_ASSERT_FALSE(trapTick(4500 + TRAP_CLEAR_MS - 1));
+  TEST_ASSERT_TRUE(trapTick(4500 + TRAP_CLEAR_MS));
+  TEST_ASSERT_FALSE(trapTick(4500 + TRAP_CLEAR_MS + 100));
+  TEST_ASSERT_EQUAL(episodes + 1, trapEpisodes());
+  TEST_ASSERT_EQUAL(3500, trapLastEscapeMs());
+  TEST_ASSERT_FALSE(trapActive());
+  TEST_ASSERT_EQUAL(0, trapRecentBumps(4500 + TRAP_CLEAR_MS));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_corner_alternation_escalates);
+  RUN_TEST(test_same_heading_cycle_is_a_trap);
+  RUN_TEST(test_old_bumps_decay);
+  RUN_TEST(test_escape_time_is_reported_once_clear);
+  return UNITY_END();
+}
@@ -0,0 +1,173 @@
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "control.h"
+#include "mode.h"
+#include "motion.h"
+#include "twist.h"
+#include "tx.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+void setUp() {
+  initMode(MODE_FOREBRAIN);
+  setMotionOwner(MOTION_OWNER_HOST);
+  twistClear();
+  twistSetPeriodMs(100);
+  twistSetHoldPct(50);
+  twistSetDeadlineMs(500);
+  CONTROL_SERIAL.clear();
+  Serial1.clear();
+}
+
+// Wheel speeds of the last Drive Direct frame sent (false if none)
+static bool lastDrive(int16_t &right, int16_t &left) {
+  const std::vector<uint8_t> &b = Serial1.buffer;
+  if (b.size() < 5 || b[b.size() - 5] != 145) return false;
+  right = (int16_t)((b[b.size() - 4] << 8) | b[b.size() - 3]);
+  left = (int16_t)((b[b.size() - 2] << 8) | b[b.size() - 1]);
+  return true;
+}
+
+static std::string hostOut() {
+  txFlush();
+  return std::string(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+}
+
+void test_jittered_arrivals_keep_full_speed() {
+  // 100 ms nominal, arriving 30 ms early or late
+  static const int16_t offsets[] = {0, 30, -30, 20, -10, 30, -30, 0};
+  uint32_t next = 1000;
+  uint32_t seq = 1;
+  bool started = false;
+  for (uint32_t now = 1000; now < 3000; now += 5) {
+    if (now == next) {
+      twistPush(0.2f, 0, seq, now);
+      next = 1000 + seq * 100 + offsets[seq % 8];
+      seq++;
+    }
+    twistTick(now);
+    int16_t r, l;
+    if (!lastDrive(r, l)) continue;
+    started = true;
+    TEST_ASSERT_EQUAL(200, r);
+    TEST_ASSERT_EQUAL(200, l);
+  }
+  TEST_ASSERT_TRUE(started);
+  TEST_ASSERT_TRUE(twistJitterMs() > 10);
+  TEST_ASSERT_EQUAL(50, twistDelayMs()); // capped at half the period
+  TEST_ASSERT_EQUAL(0, twistStaleCount());
+}
+
+void test_old_and_duplicate_seq_are_dropped() {
+  uint16_t dropped = twistDropped();
+  TEST_ASSERT_TRUE(twistPush(0.1f, 0, 10, 5000));
+  TEST_ASSERT_FALSE(twistPush(0.3f, 0, 10, 5010));
+  TEST_ASSERT_FALSE(twistPush(0.3f, 0, 9, 5020));
+  TEST_ASSERT_EQUAL(dropped + 2, twistDropped());
+  twistTick(5100);
+  int16_t r, l;
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(100, r);
+  // A clear (new session) accepts a restarted seq
+  twistClear();
+  TEST_ASSERT_TRUE(twistPush(0.1f, 0, 1, 5200));
+}
+
+void test_loss_holds_then_decays_to_stale() {
+  uint16_t stale = twistStaleCount();
+  uint32_t t0 = 10000, d = twistDelayMs();
+  twistPush(0.2f, 0, 1, t0);
+  int16_t r, l;
+  twistTick(t0 + d);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200, r);
+  // Held until period * 1.5 after the arrival, not after the playout delay
+  twistTick(t0 + 140);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200, r);
+  // Then linear toward zero at the deadline
+  twistTick(t0 + 200);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200 * 300 / 350, r);
+  TEST_ASSERT_EQUAL(0, hostOut().size());
+  twistTick(t0 + 499);
+  TEST_ASSERT_TRUE(twistActive());
+  twistTick(t0 + 500);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(0, r);
+  TEST_ASSERT_EQUAL(0, l);
+  TEST_ASSERT_EQUAL(stale + 1, twistStaleCount());
+  TEST_ASSERT_FALSE(twistActive());
+  TEST_ASSERT_TRUE(hostOut().find("STALE,twist,500,eid=") != std::string::npos);
+}
+
+void test_stale_is_not_late_by_the_playout_delay() {
+  // Jittered arrivals build up the full period/2 delay first
+  uint32_t now = 30000;
+  for (uint32_t seq = 1; seq <= 40; ++seq) {
+    now += seq % 2 ? 60 : 140;
+    twistPush(0.2f, 0, seq, now);
+    twistTick(now);
+  }
+  TEST_ASSERT_EQUAL(50, twistDelayMs());
+  uint16_t stale = twistStaleCount();
+  for (uint32_t t = now; t <= now + 500; t += 5) twistTick(t);
+  TEST_ASSERT_EQUAL(stale + 1, twistStaleCount());
+  std::string want = "STALE,twist,500,eid=";
+  TEST_ASSERT_TRUE(hostOut().find(want) != std::string::npos);
+}
+
+void test_long_hold_still_stops_at_deadline() {
+  // 1000 ms period held 400% would run 5 s; the 500 ms deadline wins
+  twistSetPeriodMs(1000);
+  twistSetHoldPct(400);
+  uint16_t stale = twistStaleCount();
+  uint32_t t0 = 20000, d = twistDelayMs();
+  twistPush(0.2f, 0, 1, t0);
+  int16_t r, l;
+  twistTick(t0 + d);
+  twistTick(t0 + 490);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(200, r);
+  twistTick(t0 + 500);
+  TEST_ASSERT_TRUE(lastDrive(r, l));
+  TEST_ASSERT_EQUAL(0, r);
+  TEST_ASSERT_EQUAL(0, l);
+  TEST_ASSERT_EQUAL(stale + 1, twistStaleCount());
+  TEST_ASSERT_FALSE(twistActive());
+}
+
+void test_host_lines_set_and_drive() {
+  controlHandleLine("SET,twist_period_ms,200");
+  controlHandleLine("SET,twist_hold_pct,25");
+  controlHandleLine("SET,watchdog_ms,20");
+  controlHandleLine("SET,bogus,1");
+  controlHandleLine("TWIST,0.1,x,1");
+  std::string out = hostOut();
+  TEST_ASSERT_TRUE(out.find("ACK,twist_period_ms,200") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ACK,twist_hold_pct,25") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ERR,param,watchdog_ms") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ERR,param,bogus") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("ERR,parse,twist") != std::string::npos);
+  controlHandleLine("TWIST,0.1,0,1");
+  TEST_ASSERT_TRUE(twistActive());
+  // Only the forebrain takes teleop
+  modeSet(MODE_AUTONOMOUS);
+  TEST_ASSERT_FALSE(twistActive());
+  controlHandleLine("TWIST,0.1,0,2");
+  TEST_ASSERT_FALSE(twistActive());
+  TEST_ASSERT_TRUE(hostOut().find("ERR,cmd,TWIST") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_jittered_arrivals_keep_full_speed);
+  RUN_TEST(test_old_and_duplicate_seq_are_dropped);
+  RUN_TEST(test_loss_holds_then_decays_to_stale);
+  RUN_TEST(test_stale_is_not_late_by_the_playout_delay);
+  RUN_TEST(test_long_hold_still_stops_at_deadline);
+  RUN_TEST(test_host_lines_set_and_drive);
+  return UNITY_END();
+}
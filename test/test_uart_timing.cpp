@@ -0,0 +1,159 @@
+#include <unity.h>
+#include "oi.h"
+#include "passthrough.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+static uint8_t frame[200];
+
+void setUp() {
+  Serial.clear();
+  Serial1.clear();
+  Serial1.begin(57600);
+  Serial1.setRxCapacity(64);
+  Serial1.setLineErrors(0, 0);
+  Serial1.setTxCapacity(0);
+  for (int i = 0; i < 200; ++i) frame[i] = (uint8_t)i;
+}
+
+void test_bytes_arrive_at_baud_rate() {
+  // 10 bits per byte at 57600 baud ~ 174 us
+  TEST_ASSERT_EQUAL(174, Serial1.byteTimeUs());
+  Serial1.inject(frame, 10);
+  TEST_ASSERT_EQUAL(0, Serial1.available());
+  mockClockUs() += 5 * 174;
+  TEST_ASSERT_EQUAL(5, Serial1.available());
+  mockClockUs() += 5 * 174;
+  TEST_ASSERT_EQUAL(10, Serial1.available());
+  TEST_ASSERT_EQUAL(0, Serial1.read());
+}
+
+void test_slow_reader_overruns_rx_buffer() {
+  Serial1.inject(frame, 100);
+  mockClockUs() += 100 * 174;
+  TEST_ASSERT_EQUAL(64, Serial1.available());
+  TEST_ASSERT_EQUAL(36, Serial1.overruns);
+}
+
+void test_bridge_keeps_up_when_pumped_often() {
+  passthroughEnable();
+  Serial1.inject(frame, 200);
+  while (Serial1.pending() > 0 || Serial1.available() > 0) {
+    mockClockUs() += 1000; // pump once per millisecond
+    passthroughPump();
+  }
+  TEST_ASSERT_EQUAL(0, Serial1.overruns);
+  TEST_ASSERT_EQUAL(200, Serial.buffer.size());
+  passthroughDisable();
+}
+
+void test_host_flood_is_held_in_usb_not_blocking() {
+  // Host dumps 400 bytes at once (USB is far faster than the OI UART) while
+  // the robot streams 100 bytes back
+  Serial1.setTxCapacity(64);
+  passthroughEnable();
+  Serial1.buffer.clear(); // stream pause sent on entry
+  uint32_t stalls0 = passthroughStalls();
+  for (int i = 0; i < 400; ++i) Serial.rx.push_back((uint8_t)(i & 0x7f));
+  Serial1.inject(frame, 100);
+  for (int t = 0; t < 100; ++t) {
+    mockClockUs() += 1000;
+    passthroughPump();
+  }
+  // The UART was never written while full; the excess waited in USB
+  TEST_ASSERT_EQUAL(0, Serial1.blockedWrites);
+  TEST_ASSERT_TRUE(passthroughStalls() > stalls0);
+  TEST_ASSERT_EQUAL(400, Serial1.buffer.size());
+  TEST_ASSERT_EQUAL(0, Serial.rx.size());
+  // ...and the robot → host direction kept up
+  TEST_ASSERT_EQUAL(0, Serial1.overruns);
+  TEST_ASSERT_EQUAL(100, Serial.buffer.size());
+  passthroughDisable();
+}
+
+// Teleop over a congested UART: a drive frame and a sensor request every
+// millisecond (7 bytes/ms against ~5.8 the wire carries). Returns the host
+// bytes still waiting in USB afterwards; counts what reached the robot.
+// passthroughDisable() flushes the shaper (and may block, as on a mode switch).
+static size_t teleop(int ms, int& queries, int& lastSpeed, unsigned long& blocked) {
+  Serial1.setTxCapacity(64);
+  passthroughEnable();
+  Serial1.buffer.clear();
+  for (int t = 0; t < ms; ++t) {
+    const uint8_t cmd[] = { 145, 0, (uint8_t)(t % 100), 0, (uint8_t)(t % 100), 142, 7 };
+    for (uint8_t b : cmd) Serial.rx.push_back(b);
+    mockClockUs() += 1000;
+    passthroughPump();
+  }
+  size_t backlog = Serial.rx.size();
+  blocked = Serial1.blockedWrites;
+  passthroughDisable();
+  OiFramer f;
+  oiFramerReset(f);
+  queries = 0;
+  for (size_t i = 0; i < Serial1.buffer.size(); ++i) {
+    if (!oiFramerFeed(f, Serial1.buffer[i])) continue;
+    if (Serial1.buffer[i] == 142) queries++;
+    if (Serial1.buffer[i] == 145) lastSpeed = Serial1.buffer[i + 2];
+  }
+  return backlog;
+}
+
+void test_coalescing_bounds_teleop_backlog() {
+  int queries, speed;
+  unsigned long blocked;
+  passthroughSetCoalesce(false);
+  size_t plain = teleop(300, queries, speed, blocked);
+  // Without shaping every stale frame queues: the backlog keeps growing
+  TEST_ASSERT_TRUE(plain > 200);
+  TEST_ASSERT_EQUAL(0, blocked);
+
+  Serial.clear();
+  Serial1.clear();
+  passthroughSetCoalesce(true);
+  uint16_t before = passthroughCoalesced();
+  size_t shaped = teleop(300, queries, speed, blocked);
+  passthroughSetCoalesce(false);
+  TEST_ASSERT_TRUE(shaped < 16);
+  TEST_ASSERT_EQUAL(0, blocked);
+  TEST_ASSERT_TRUE(passthroughCoalesced() > before);
+  // Every sensor request got through; the robot ends on a recent speed
+  TEST_ASSERT_TRUE(queries >= 300 - 8);
+  TEST_ASSERT_TRUE(speed >= 299 % 100 - 3);
+}
+
+void test_full_tx_buffer_blocks_writer() {
+  // The mock's model of the core: writing into a full buffer waits
+  Serial1.setTxCapacity(64);
+  for (int i = 0; i < 64; ++i) Serial1.write((uint8_t)i);
+  TEST_ASSERT_EQUAL(0, Serial1.availableForWrite());
+  TEST_ASSERT_EQUAL(0, Serial1.blockedWrites);
+  unsigned long before = mockClockUs();
+  Serial1.write((uint8_t)0);
+  TEST_ASSERT_EQUAL(1, Serial1.blockedWrites);
+  TEST_ASSERT_TRUE(mockClockUs() > before);
+  mockClockUs() += 10 * 174;
+  TEST_ASSERT_EQUAL(10, Serial1.availableForWrite());
+}
+
+void test_framing_errors_drop_bytes() {
+  Serial1.setRxCapacity(0);
+  Serial1.setLineErrors(0, 0.5, 7);
+  Serial1.inject(frame, 200);
+  mockClockUs() += 200 * 174;
+  TEST_ASSERT_EQUAL(200, Serial1.available() + Serial1.framingErrors);
+  TEST_ASSERT_TRUE(Serial1.framingErrors > 50 && Serial1.framingErrors < 150);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bytes_arrive_at_baud_rate);
+  RUN_TEST(test_slow_reader_overruns_rx_buffer);
+  RUN_TEST(test_bridge_keeps_up_when_pumped_often);
+  RUN_TEST(test_host_flood_is_held_in_usb_not_blocking);
+  RUN_TEST(test_full_tx_buffer_blocks_writer);
+  RUN_TEST(test_coalescing_bounds_teleop_backlog);
+  RUN_TEST(test_framing_errors_drop_bytes);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <string>
+#include "cdc_ctl.h"
+#include "idle.h"
+#include "mode.h"
+#include "tx.h"
+#include "usblink.h"
+#include "Arduino.h"
+
+HardwareSerial Serial1; // mock robot serial
+
+void setUp() {
+  usbLinkSimulate(false, false, false);
+  initMode(MODE_FOREBRAIN);
+  txFlush();
+  CONTROL_SERIAL.clear();
+  Serial1.clear();
+}
+
+// Poll until a presence edge (or give up after ~10 ms of virtual time)
+static UsbLinkEvent pollEdge() {
+  for (int i = 0; i < 2500; ++i) {
+    UsbLinkEvent e = usbLinkPoll();
+    if (e != USB_LINK_NONE) return e;
+  }
+  return USB_LINK_NONE;
+}
+
+static std::string hostOut() {
+  txFlush();
+  return std::string(CONTROL_SERIAL.buffer.begin(), CONTROL_SERIAL.buffer.end());
+}
+
+void test_link_up_needs_vbus_sof_and_dtr() {
+  uint16_t seq = usbLinkTransitions();
+  usbLinkSimulate(true, true, false); // enumerated, port not opened
+  TEST_ASSERT_EQUAL(USB_LINK_NONE, pollEdge());
+  TEST_ASSERT_EQUAL_UINT8(USB_LINK_NO_DTR, usbLinkDownReason());
+  usbLinkSimulate(true, true, true);
+  TEST_ASSERT_EQUAL(USB_LINK_UP, pollEdge());
+  TEST_ASSERT_TRUE(usbLinkPresent());
+  TEST_ASSERT_EQUAL_UINT16(seq + 1, usbLinkTransitions());
+  std::string line = "LINK,1," + std::to_string(seq + 1) + ",eid=";
+  TEST_ASSERT_TRUE(hostOut().find(line) != std::string::npos);
+}
+
+void test_sof_stall_and_dtr_drop_take_the_link_down() {
+  usbLinkSimulate(true, true, true);
+  TEST_ASSERT_EQUAL(USB_LINK_UP, pollEdge());
+  // Bus suspended: frames stop counting
+  usbLinkSimulate(true, false, true);
+  TEST_ASSERT_EQUAL(USB_LINK_DOWN, pollEdge());
+  TEST_ASSERT_TRUE(usbLinkDownReason() & USB_LINK_SOF_STALL);
+  usbLinkSimulate(true, true, true);
+  TEST_ASSERT_EQUAL(USB_LINK_UP, pollEdge());
+  // Host program closed the port
+  usbLinkSimulate(true, true, false);
+  TEST_ASSERT_EQUAL(USB_LINK_DOWN, pollEdge());
+  TEST_ASSERT_EQUAL_UINT8(USB_LINK_NO_DTR, usbLinkDownReason());
+  TEST_ASSERT_TRUE(hostOut().find("LINK,0,") != std::string::npos);
+}
+
+void test_managed_loop_feeds_idle_from_presence() {
+  initIdle(100);
+  usbLinkSimulate(true, true, false);
+  for (int i = 0; i < 20; ++i) modeLoop();
+  TEST_ASSERT_TRUE(idleIsActive());
+  usbLinkSimulate(true, true, true);
+  modeLoop();
+  TEST_ASSERT_TRUE(usbLinkPresent());
+  TEST_ASSERT_FALSE(idleIsActive());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_link_up_needs_vbus_sof_and_dtr);
+  RUN_TEST(test_sof_stall_and_dtr_drop_take_the_link_down);
+  RUN_TEST(test_managed_loop_feeds_idle_from_presence);
+  return UNITY_END();
+}
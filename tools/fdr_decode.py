@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Decode a brainstem flight-recorder dump (FDR,... lines).
+
+Usage:
+  python3 tools/fdr_decode.py /dev/ttyACM0      # request a dump over the escape channel
+  python3 tools/fdr_decode.py capture.log       # decode FDR lines from a saved log
+  python3 tools/fdr_decode.py /dev/ttyACM0 --arm  # dump, then re-arm the recorder
+"""
+import os
+import stat
+import struct
+import sys
+import time
+import argparse
+
+KINDS = {1: "SENSORS", 2: "DRIVE", 3: "STATE", 4: "REFLEX", 5: "TRIGGER"}
+STATES = ["CONNECTING", "WAITING", "WALL_FOLLOWING", "SEEKING", "ADVANCING",
+          "RECOILING", "TURNING_LEFT", "TURNING_RIGHT", "FROZEN"]
+REFLEXES = {1: "cliff_freeze", 2: "bump_recoil", 3: "isr_recoil", 4: "bias_flip", 5: "stuck", 6: "trap_escape"}
+TRIGGERS = {0x01: "cliff", 0x02: "estop", 0x04: "watchdog", 0x08: "bumps", 0x10: "host"}
+HAZARDS = ["bumpR", "bumpL", "cliffL", "cliffFL", "cliffFR", "cliffR", "wall"]
+
+
+def read_dump_serial(dev, baud, arm):
+    import serial  # pyserial
+    ser = serial.Serial(dev, baud, timeout=0.1)
+    ser.reset_input_buffer()
+    ser.write(b"\xFF\x00!fdr\n")
+    lines = []
+    t0 = time.time()
+    while time.time() - t0 < 3.0:
+        ln = ser.readline().decode(errors="ignore").strip()
+        if ln.startswith("FDR,"):
+            lines.append(ln)
+            if ln == "FDR,end":
+                break
+    if arm:
+        ser.write(b"\xFF\x00!fdr_arm\n")
+    ser.close()
+    return lines
+
+
+def describe(kind, a, b, c):
+    if kind == 1:
+        bits = [n for i, n in enumerate(HAZARDS) if a & (1 << i)]
+        return f"{'|'.join(bits) or 'clear'} buttons=0x{b & 0xFF:02x}"
+    if kind == 2:
+        return f"right={b}mm/s left={c}mm/s"
+    if kind == 3:
+        name = lambda i: STATES[i] if 0 <= i < len(STATES) else str(i)
+        return f"{name(b)} -> {name(a)}"
+    if kind == 4:
+        return REFLEXES.get(a, str(a))
+    if kind == 5:
+        return TRIGGERS.get(a, hex(a))
+    return f"a={a} b={b} c={c}"
+
+
+def decode(lines):
+    header = None
+    records = []
+    for ln in lines:
+        parts = ln.split(",")
+        if len(parts) == 5:
+            header = {"frozen": parts[1] == "1", "trigger": int(parts[2]),
+                      "now_ms": int(parts[3]), "count": int(parts[4])}
+        elif len(parts) == 2 and parts[1] != "end" and len(parts[1]) == 16:
+            records.append(struct.unpack("<HBBhh", bytes.fromhex(parts[1])))
+    if header is None:
+        sys.exit("no FDR header found")
+    print(f"frozen={header['frozen']} trigger={TRIGGERS.get(header['trigger'], header['trigger'])} "
+          f"records={header['count']} now_ms={header['now_ms']}")
+    # Unwrap 16-bit timestamps backwards from now_ms
+    t_abs = []
+    ref = header["now_ms"]
+    for ms, *_ in reversed(records):
+        delta = (ref - ms) & 0xFFFF
+        ref -= delta
+        t_abs.append(ref)
+    t_abs.reverse()
+    for t, (ms, kind, a, b, c) in zip(t_abs, records):
+        rel = (t - header["now_ms"]) / 1000.0
+        print(f"{rel:+9.3f}s  {KINDS.get(kind, kind):8s} {describe(kind, a, b, c)}")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("source", help="serial device or log file")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--arm", action="store_true", help="re-arm the recorder after dumping")
+    args = ap.parse_args()
+    if os.path.exists(args.source) and stat.S_ISCHR(os.stat(args.source).st_mode):
+        lines = read_dump_serial(args.source, args.baud, args.arm)
+    else:
+        with open(args.source, errors="ignore") as f:
+            lines = [ln.strip() for ln in f if ln.startswith("FDR,")]
+    decode(lines)
+
+
+if __name__ == "__main__":
+    main()
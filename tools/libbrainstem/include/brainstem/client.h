@@ -0,0 +1,108 @@
+#pragma once
+// Asynchronous brainstem client: protocol-level state on top of a transport.
+//
+//  - typed message callbacks fed by the zero-copy LineParser
+//  - PING/GET/SET requests tracked by sequence number / key, answered
+//    through std::future (safe to call from any thread); ERR,cmd and
+//    ERR,param replies fail them
+//  - event-id tracking with automatic REPLAY,<since_eid> gap filling; eids
+//    the firmware no longer holds (ERR,evt,missing) are counted as lost
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include "brainstem/message.h"
+#include "brainstem/transport.h"
+
+namespace brainstem {
+
+struct RequestError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+struct ClientStats {
+  uint64_t messages = 0;
+  uint64_t malformed = 0;
+  uint64_t gapsDetected = 0;
+  uint64_t eidsMissing = 0;    // eids currently outstanding
+  uint64_t eidsRecovered = 0;  // delivered late via REPLAY
+  uint64_t eidsLost = 0;       // not replayed, or given up after the replay window
+  uint64_t duplicates = 0;
+  uint64_t timeouts = 0;
+};
+
+class Client {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using MessageHandler = std::function<void(const MessageView&)>;
+  // ok=false on timeout or ERR,cmd,PING; runs on the loop thread.
+  using PingCallback = std::function<void(bool ok, std::chrono::microseconds rtt)>;
+
+  explicit Client(EventLoop& loop);
+
+  bool open(const std::string& dev, unsigned baud = 115200) { return transport_.open(dev, baud); }
+  bool adopt(int fd) { return transport_.adopt(fd); }
+  SerialTransport& transport() { return transport_; }
+
+  // Every parsed line, in arrival order (replayed lines have m.replayed set).
+  void onMessage(MessageHandler h) { handler_ = std::move(h); }
+
+  // Requests: thread-safe, resolved on the loop thread. get("time") is
+  // answered by TIME,<ms>; other keys by ACK,<key>,<value>.
+  std::future<std::chrono::microseconds> ping();
+  // Callback form for code already on the loop thread (cannot block on a future).
+  void ping(PingCallback done);
+  std::future<std::string> get(const std::string& key);
+  std::future<std::string> set(const std::string& key, const std::string& value);
+  // Raw line (newline appended); thread-safe.
+  void sendLine(const std::string& line);
+
+  void setRequestTimeout(std::chrono::milliseconds t) { timeout_ = t; }
+  void setReplayEnabled(bool on) { replayEnabled_ = on; }
+  int64_t lastEid() const { return highEid_; }
+  const ClientStats& stats() const { return stats_; }
+
+ private:
+  struct PendingPing {
+    PingCallback done;
+    Clock::time_point sent;
+  };
+  struct PendingKey {
+    std::string verb;  // GET or SET
+    std::string key;
+    std::promise<std::string> promise;
+    Clock::time_point sent;
+  };
+
+  size_t onData(const char* data, size_t len);
+  void dispatch(const MessageView& m);
+  bool trackEid(MessageView& m);
+  void resolveAck(const MessageView& m);
+  void failPing();
+  void loseMissing();
+  void expire();
+
+  EventLoop& loop_;
+  SerialTransport transport_;
+  LineParser parser_;
+  MessageHandler handler_;
+  ClientStats stats_;
+
+  uint32_t nextSeq_ = 1;
+  std::map<uint32_t, PendingPing> pings_;
+  std::deque<PendingKey> keyed_;  // GET/SET answered in order by ACK/ERR
+  std::chrono::milliseconds timeout_{1000};
+
+  bool replayEnabled_ = true;
+  int64_t highEid_ = -1;
+  std::set<int64_t> missing_;
+  Clock::time_point lastReplay_{};
+};
+
+}  // namespace brainstem
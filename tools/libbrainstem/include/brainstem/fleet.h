@@ -0,0 +1,146 @@
+#pragma once
+// Fleet service: many brainstem links on one EventLoop (one thread, one epoll).
+//
+//  - one Client per robot, addressed by a short id ("r1", "kitchen", ...)
+//  - per-link state machine: HELLO handshake, READY/BUSY, bridge vs managed
+//    detection, LINK/STATE/ESTOP tracking, reopen with backoff for ttys
+//  - periodic PING health probes on managed links feeding per-link and
+//    fleet-wide RTT histograms (bridged links pass raw OI bytes, so they
+//    are only counted, never probed)
+//  - a one-line text control API that addresses robots by id
+//
+// Everything runs on the loop thread; only command() may be called from
+// other threads.
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "brainstem/client.h"
+
+namespace brainstem {
+
+enum class LinkState : uint8_t {
+  Closed,     // not open (tty missing; reopened after a backoff)
+  Handshake,  // HELLO sent, waiting for READY
+  Ready,      // answering; bridged or managed
+  Lost,       // fd closed and not reopenable (adopted pty/socket)
+};
+
+const char* linkStateName(LinkState s);
+
+// Log2 histogram of latencies: bucket i counts samples in [2^i, 2^(i+1)) µs.
+struct LatencyHistogram {
+  static constexpr size_t kBuckets = 24;  // last bucket also takes >= 8 s
+
+  uint64_t counts[kBuckets] = {};
+  uint64_t samples = 0;
+  uint64_t maxUs = 0;
+
+  void add(uint64_t us);
+  void merge(const LatencyHistogram& o);
+  // Upper edge of the bucket holding the q-quantile (0..1); 0 when empty.
+  uint64_t quantileUs(double q) const;
+};
+
+struct LinkStats {
+  uint64_t messages = 0;
+  uint64_t bytesIn = 0;
+  uint64_t bytesOut = 0;
+  uint64_t probesSent = 0;
+  uint64_t probesAnswered = 0;
+  uint64_t probeTimeouts = 0;
+  uint64_t reopens = 0;
+  LatencyHistogram rtt;
+};
+
+struct FleetStats {
+  size_t links = 0;
+  size_t ready = 0;
+  LinkStats total;  // sums over every link; rtt is the merged histogram
+};
+
+class Fleet {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using MessageHandler = std::function<void(const std::string& id, const MessageView&)>;
+  using Reply = std::function<void(const std::string& line)>;
+
+  explicit Fleet(EventLoop& loop);
+  ~Fleet();
+  Fleet(const Fleet&) = delete;
+  Fleet& operator=(const Fleet&) = delete;
+
+  // Loop thread (or before the loop runs). Both return false for a duplicate
+  // id. A device link that fails to open stays Closed and is retried.
+  bool addDevice(const std::string& id, const std::string& dev, unsigned baud = 115200);
+  // Adopted fds (pty master, socket) are not reopened once closed; one that
+  // cannot be polled is Lost from the start.
+  bool addFd(const std::string& id, int fd);
+
+  // Every parsed line from every link, tagged with the robot id.
+  void onMessage(MessageHandler h) { handler_ = std::move(h); }
+  // Health probe period per link; 0 disables probing.
+  void setProbeInterval(std::chrono::milliseconds t) { probeInterval_ = t; }
+  void setProbeTimeout(std::chrono::milliseconds t);
+
+  std::vector<std::string> ids() const;
+  LinkState state(const std::string& id) const;
+  // Last STATE,<name> seen ("" while bridged or unknown)
+  std::string mode(const std::string& id) const;
+  Client* client(const std::string& id);
+  bool linkStats(const std::string& id, LinkStats& out) const;
+  FleetStats stats() const;
+
+  // Control API, one request line in, one reply line out (OK,... / ERR,...):
+  //   list                    OK,list,<id>=<STATE>/<mode>,...
+  //   stats                   OK,stats,links=..,ready=..,msgs=..,p50_us=..,p99_us=..,...
+  //   <id> stats              same fields for one link
+  //   <id> ping               OK,ping,<id>,<rtt_us> | ERR,timeout,<id>
+  //   <id|*> send <line>      OK,send,<links written>
+  // Thread-safe; reply runs on the loop thread, possibly later (ping).
+  void command(const std::string& request, Reply reply);
+
+ private:
+  struct Link {
+    std::string id;
+    std::string dev;  // empty for adopted fds
+    unsigned baud = 115200;
+    std::unique_ptr<Client> client;
+    LinkState state = LinkState::Closed;
+    bool managed = false;   // seen eid-tagged lines (proto.h verbs work)
+    bool hostLink = true;   // last LINK,<0|1>
+    bool estop = false;     // last ESTOP,<0|1>
+    std::string mode;
+    Clock::time_point due{};  // next HELLO retry / reopen attempt
+    std::chrono::milliseconds backoff{};
+    Clock::time_point nextProbe{};
+    LinkStats stats;
+  };
+
+  Link* find(const std::string& id);
+  const Link* find(const std::string& id) const;
+  Link& create(const std::string& id);
+  void startHandshake(Link& l, Clock::time_point now);
+  void setReady(Link& l, Clock::time_point now);
+  void onLinkMessage(Link& l, const MessageView& m);
+  void onLinkClosed(Link& l);
+  void probeDone(Link& l, bool ok, std::chrono::microseconds rtt);
+  void tick();
+  void execute(const std::string& request, const Reply& reply);
+  static std::string formatStats(const LinkStats& s);
+
+  EventLoop& loop_;
+  // Never erased: each Client registers a tick with the loop for its lifetime
+  std::vector<std::unique_ptr<Link>> links_;
+  std::map<std::string, Link*> byId_;
+  MessageHandler handler_;
+  std::chrono::milliseconds probeInterval_{1000};
+  std::chrono::milliseconds probeTimeout_{1000};
+  Clock::time_point lastTick_{};
+};
+
+}  // namespace brainstem
@@ -0,0 +1,113 @@
+#pragma once
+// Zero-copy views over brainstem protocol lines (see include/proto.h).
+//
+// A MessageView never owns memory: its string_views point straight into the
+// transport's read buffer and stay valid only for the duration of the
+// callback that received it. Copy out whatever must outlive the callback.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace brainstem {
+
+enum class MsgType : uint8_t {
+  Unknown,
+  Hello,
+  Ready,
+  Busy,
+  Link,
+  Pong,
+  Odom,
+  Time,
+  State,
+  Bump,
+  Cliff,
+  Startle,
+  Estop,
+  Stale,
+  RgMin,
+  Ack,
+  Err,
+  Bat,
+  Sns,
+  Stuck,
+  Trap,
+  Traj,
+  Status,
+  Stats,
+};
+
+const char* msgTypeName(MsgType t);
+
+struct MessageView {
+  static constexpr size_t kMaxFields = 12;
+
+  MsgType type = MsgType::Unknown;
+  std::string_view line;                 // whole line, without newline and eid suffix
+  std::string_view verb;                 // first comma-separated token
+  std::string_view fields[kMaxFields];   // tokens after the verb
+  uint8_t fieldCount = 0;
+  int64_t eid = -1;                      // -1 when the line carried no ,eid=<n>
+  bool replayed = false;                 // delivered by REPLAY gap filling
+
+  std::string_view field(size_t i) const { return i < fieldCount ? fields[i] : std::string_view(); }
+  bool intField(size_t i, int64_t& out) const;
+  bool doubleField(size_t i, double& out) const;
+};
+
+// Parse one line (without the trailing newline) into a view over the same bytes.
+bool parseLine(std::string_view line, MessageView& out);
+
+// Typed accessors. Each returns false if the view is not of that type or a
+// field fails to parse.
+struct Odom { double x, y, theta, vx, wz; uint32_t seq; };
+struct Hazard { uint8_t mask; uint32_t seq; };           // BUMP / CLIFF
+struct Pong { uint32_t seq; };
+struct Link { bool up; uint32_t seq; };
+struct EstopMsg { bool active; uint32_t seq; };
+struct RangeMin { double meters; int64_t id; uint32_t seq; };
+struct Battery { uint32_t millivolts; uint8_t percent; bool charging; };
+
+bool asOdom(const MessageView& m, Odom& out);
+bool asHazard(const MessageView& m, Hazard& out);
+bool asPong(const MessageView& m, Pong& out);
+bool asLink(const MessageView& m, Link& out);
+bool asEstop(const MessageView& m, EstopMsg& out);
+bool asRangeMin(const MessageView& m, RangeMin& out);
+bool asBattery(const MessageView& m, Battery& out);
+
+// Incremental line splitter. feed() scans the caller's buffer in place and
+// invokes cb(const MessageView&) for every complete line; it returns how many
+// bytes were consumed so the caller can keep the partial tail.
+class LineParser {
+ public:
+  template <class F>
+  size_t feed(const char* data, size_t len, F&& cb) {
+    size_t start = 0;
+    while (start < len) {
+      const char* nl = static_cast<const char*>(std::memchr(data + start, '\n', len - start));
+      if (!nl) break;
+      size_t i = static_cast<size_t>(nl - data);
+      size_t end = i;
+      if (end > start && data[end - 1] == '\r') --end;
+      if (end > start) {
+        MessageView m;
+        if (parseLine(std::string_view(data + start, end - start), m)) cb(static_cast<const MessageView&>(m));
+        else ++malformed_;
+      }
+      ++lines_;
+      start = i + 1;
+    }
+    return start;
+  }
+
+  uint64_t lines() const { return lines_; }
+  uint64_t malformed() const { return malformed_; }
+
+ private:
+  uint64_t lines_ = 0;
+  uint64_t malformed_ = 0;
+};
+
+}  // namespace brainstem
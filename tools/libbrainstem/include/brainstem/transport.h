@@ -0,0 +1,94 @@
+#pragma once
+// epoll event loop and non-blocking serial transport for brainstem links.
+//
+// One EventLoop can drive any number of transports (see fleet tooling); all
+// callbacks run on the thread that calls EventLoop::run()/runOnce().
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace brainstem {
+
+class EventLoop {
+ public:
+  using Handler = std::function<void(uint32_t events)>;
+
+  EventLoop();
+  ~EventLoop();
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  void add(int fd, uint32_t events, Handler h);
+  void modify(int fd, uint32_t events);
+  void remove(int fd);
+
+  // Run one epoll_wait round (timeoutMs < 0 blocks) and any posted tasks.
+  void runOnce(int timeoutMs);
+  // Loop until stop() is called.
+  void run();
+  void stop();
+
+  // Queue a task from any thread; it runs on the loop thread.
+  void post(std::function<void()> task);
+  // Called on the loop thread after every round (timers, expiries).
+  void onTick(std::function<void()> tick) { ticks_.push_back(std::move(tick)); }
+
+ private:
+  int epfd_ = -1;
+  int wakeFd_ = -1;
+  bool running_ = false;
+  std::unordered_map<int, Handler> handlers_;
+  std::mutex postMu_;
+  std::vector<std::function<void()>> posted_;
+  std::vector<std::function<void()>> ticks_;
+};
+
+class SerialTransport {
+ public:
+  // Takes ownership of an already-open fd (pty master, socket) or opens a tty.
+  explicit SerialTransport(EventLoop& loop);
+  ~SerialTransport();
+
+  bool open(const std::string& dev, unsigned baud = 115200);
+  bool adopt(int fd);
+  void close();
+  bool isOpen() const { return fd_ >= 0; }
+  int fd() const { return fd_; }
+
+  // Called on every readable burst with all unconsumed bytes. The handler
+  // returns how many it consumed; the remainder is kept for the next read.
+  void onData(std::function<size_t(const char*, size_t)> h) { data_ = std::move(h); }
+  void onClose(std::function<void()> h) { closed_ = std::move(h); }
+
+  // Queue bytes; written immediately if the kernel buffer has room.
+  void write(const char* data, size_t len);
+  void write(const std::string& s) { write(s.data(), s.size()); }
+
+  uint64_t bytesIn() const { return bytesIn_; }
+  uint64_t bytesOut() const { return bytesOut_; }
+
+ private:
+  void handleEvents(uint32_t events);
+  void readAvailable();
+  void flushOut();
+
+  EventLoop& loop_;
+  int fd_ = -1;
+  // Read buffer: the parser runs over [0, rxLen_) in place; only an
+  // incomplete trailing line is moved to the front between reads.
+  std::vector<char> rx_;
+  size_t rxLen_ = 0;
+  std::string tx_;
+  size_t txOff_ = 0;
+  bool wantWrite_ = false;
+  uint64_t bytesIn_ = 0;
+  uint64_t bytesOut_ = 0;
+  std::function<size_t(const char*, size_t)> data_;
+  std::function<void()> closed_;
+};
+
+}  // namespace brainstem
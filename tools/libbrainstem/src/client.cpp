@@ -0,0 +1,195 @@
+#include "brainstem/client.h"
+
+#include <memory>
+
+namespace brainstem {
+
+namespace {
+
+constexpr size_t kMaxMissing = 256;  // cap on outstanding eids per gap
+constexpr auto kReplayInterval = std::chrono::milliseconds(200);
+constexpr auto kReplayGiveUp = std::chrono::milliseconds(2000);
+constexpr int64_t kEidResetThreshold = 1000;  // backwards jump = firmware restart
+
+}  // namespace
+
+Client::Client(EventLoop& loop) : loop_(loop), transport_(loop) {
+  transport_.onData([this](const char* d, size_t n) { return onData(d, n); });
+  loop_.onTick([this] { expire(); });
+}
+
+size_t Client::onData(const char* data, size_t len) {
+  size_t used = parser_.feed(data, len, [this](const MessageView& v) {
+    MessageView m = v;  // copies views only, never bytes
+    if (trackEid(m)) dispatch(m);
+  });
+  stats_.malformed = parser_.malformed();
+  return used;
+}
+
+bool Client::trackEid(MessageView& m) {
+  if (m.type == MsgType::Hello) {
+    // Fresh boot: eids restart
+    highEid_ = -1;
+    missing_.clear();
+    stats_.eidsMissing = 0;
+  }
+  if (m.eid < 0) return true;
+  if (highEid_ < 0 || m.eid < highEid_ - kEidResetThreshold) {
+    highEid_ = m.eid;
+    missing_.clear();
+    stats_.eidsMissing = 0;
+    return true;
+  }
+  if (m.eid > highEid_) {
+    if (m.eid > highEid_ + 1) {
+      ++stats_.gapsDetected;
+      int64_t e = highEid_ + 1;
+      for (; e < m.eid && missing_.size() < kMaxMissing; ++e) missing_.insert(e);
+      stats_.eidsLost += static_cast<uint64_t>(m.eid - e);
+      if (replayEnabled_ && !missing_.empty() && Clock::now() - lastReplay_ >= kReplayInterval) {
+        // Ask for everything after the last eid we saw in order
+        transport_.write("REPLAY," + std::to_string(*missing_.begin() - 1) + "\n");
+        lastReplay_ = Clock::now();
+      }
+    }
+    highEid_ = m.eid;
+    stats_.eidsMissing = missing_.size();
+    return true;
+  }
+  if (missing_.erase(m.eid)) {
+    m.replayed = true;
+    ++stats_.eidsRecovered;
+    stats_.eidsMissing = missing_.size();
+    return true;
+  }
+  ++stats_.duplicates;
+  return false;
+}
+
+void Client::dispatch(const MessageView& m) {
+  ++stats_.messages;
+  if (m.type == MsgType::Pong) {
+    Pong p;
+    if (asPong(m, p)) {
+      auto it = pings_.find(p.seq);
+      if (it != pings_.end()) {
+        PingCallback done = std::move(it->second.done);
+        auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it->second.sent);
+        pings_.erase(it);
+        done(true, rtt);
+      }
+    }
+  } else if (m.type == MsgType::Err && m.field(0) == "cmd" && m.field(1) == "PING") {
+    failPing();
+  } else if (m.type == MsgType::Err && m.field(0) == "evt" && m.field(1) == "missing") {
+    // Sent after whatever REPLAY still had: the rest is gone
+    loseMissing();
+  } else if (m.type == MsgType::Ack || m.type == MsgType::Err || m.type == MsgType::Time) {
+    resolveAck(m);
+  }
+  if (handler_) handler_(m);
+}
+
+void Client::resolveAck(const MessageView& m) {
+  if (keyed_.empty()) return;
+  PendingKey& front = keyed_.front();
+  std::string error;
+  if (m.type == MsgType::Ack && m.field(0) == front.key) {
+    front.promise.set_value(std::string(m.field(1)));
+  } else if (m.type == MsgType::Time && front.verb == "GET" && front.key == "time") {
+    front.promise.set_value(std::string(m.field(0)));
+  } else if (m.type == MsgType::Err && m.field(0) == "param" && m.field(1) == front.key) {
+    error = "ERR,param," + front.key;
+  } else if (m.type == MsgType::Err && m.field(0) == "cmd" && m.field(1) == front.verb) {
+    // GET of anything but time, or a verb the firmware does not know
+    error = "ERR,cmd," + front.verb;
+  } else if (m.type == MsgType::Err && m.field(0) == "parse" && front.verb == "SET" && m.field(1) == "set") {
+    error = "ERR,parse,set";
+  } else {
+    return;
+  }
+  if (!error.empty()) front.promise.set_exception(std::make_exception_ptr(RequestError(error)));
+  keyed_.pop_front();
+}
+
+// ERR,cmd,PING: firmware without PING; fail the oldest outstanding ping
+void Client::failPing() {
+  if (pings_.empty()) return;
+  auto it = pings_.begin();
+  PingCallback done = std::move(it->second.done);
+  pings_.erase(it);
+  done(false, std::chrono::microseconds(0));
+}
+
+void Client::loseMissing() {
+  stats_.eidsLost += missing_.size();
+  missing_.clear();
+  stats_.eidsMissing = 0;
+}
+
+void Client::expire() {
+  auto now = Clock::now();
+  for (auto it = pings_.begin(); it != pings_.end();) {
+    if (now - it->second.sent > timeout_) {
+      PingCallback done = std::move(it->second.done);
+      ++stats_.timeouts;
+      it = pings_.erase(it);
+      done(false, std::chrono::microseconds(0));
+    } else {
+      ++it;
+    }
+  }
+  while (!keyed_.empty() && now - keyed_.front().sent > timeout_) {
+    keyed_.front().promise.set_exception(std::make_exception_ptr(RequestError(keyed_.front().key + " timeout")));
+    ++stats_.timeouts;
+    keyed_.pop_front();
+  }
+  if (!missing_.empty() && now - lastReplay_ > kReplayGiveUp) loseMissing();
+}
+
+std::future<std::chrono::microseconds> Client::ping() {
+  auto promise = std::make_shared<std::promise<std::chrono::microseconds>>();
+  auto fut = promise->get_future();
+  ping([promise](bool ok, std::chrono::microseconds rtt) {
+    if (ok) promise->set_value(rtt);
+    else promise->set_exception(std::make_exception_ptr(RequestError("PING timeout or unsupported")));
+  });
+  return fut;
+}
+
+void Client::ping(PingCallback done) {
+  loop_.post([this, done = std::move(done)]() mutable {
+    uint32_t seq = nextSeq_++;
+    PendingPing& p = pings_[seq];
+    p.done = std::move(done);
+    p.sent = Clock::now();
+    transport_.write("PING," + std::to_string(seq) + "\n");
+  });
+}
+
+std::future<std::string> Client::get(const std::string& key) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  auto fut = promise->get_future();
+  loop_.post([this, promise, key] {
+    keyed_.push_back(PendingKey{"GET", key, std::move(*promise), Clock::now()});
+    transport_.write("GET," + key + "\n");
+  });
+  return fut;
+}
+
+std::future<std::string> Client::set(const std::string& key, const std::string& value) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  auto fut = promise->get_future();
+  loop_.post([this, promise, key, value] {
+    keyed_.push_back(PendingKey{"SET", key, std::move(*promise), Clock::now()});
+    transport_.write("SET," + key + "," + value + "\n");
+  });
+  return fut;
+}
+
+void Client::sendLine(const std::string& line) {
+  loop_.post([this, line] { transport_.write(line + "\n"); });
+}
+
+}  // namespace brainstem
@@ -0,0 +1,350 @@
+#include "brainstem/fleet.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace brainstem {
+
+namespace {
+
+constexpr auto kTickInterval = std::chrono::milliseconds(10);
+// HELLO is only resent while nothing has answered; after BUSY the firmware
+// is power-cycling the robot (a few seconds) before READY.
+constexpr auto kHelloRetry = std::chrono::milliseconds(3000);
+constexpr auto kBusyWait = std::chrono::milliseconds(10000);
+constexpr auto kMinBackoff = std::chrono::milliseconds(250);
+constexpr auto kMaxBackoff = std::chrono::milliseconds(5000);
+
+}  // namespace
+
+const char* linkStateName(LinkState s) {
+  switch (s) {
+    case LinkState::Closed: return "CLOSED";
+    case LinkState::Handshake: return "HANDSHAKE";
+    case LinkState::Ready: return "READY";
+    case LinkState::Lost: return "LOST";
+  }
+  return "?";
+}
+
+// ---------- LatencyHistogram ----------
+
+void LatencyHistogram::add(uint64_t us) {
+  size_t b = 0;
+  while (b + 1 < kBuckets && (us >> (b + 1)) != 0) ++b;
+  ++counts[b];
+  ++samples;
+  maxUs = std::max(maxUs, us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) {
+  for (size_t i = 0; i < kBuckets; ++i) counts[i] += o.counts[i];
+  samples += o.samples;
+  maxUs = std::max(maxUs, o.maxUs);
+}
+
+uint64_t LatencyHistogram::quantileUs(double q) const {
+  if (samples == 0) return 0;
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(samples)));
+  if (rank < 1) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) return std::min<uint64_t>(uint64_t(2) << i, maxUs);
+  }
+  return maxUs;
+}
+
+// ---------- Fleet ----------
+
+Fleet::Fleet(EventLoop& loop) : loop_(loop) {
+  loop_.onTick([this] { tick(); });
+}
+
+Fleet::~Fleet() {
+  // Transports close as the links go away; nothing must call back into them
+  for (auto& l : links_) l->client->transport().onClose(nullptr);
+}
+
+Fleet::Link& Fleet::create(const std::string& id) {
+  links_.push_back(std::make_unique<Link>());
+  Link* l = links_.back().get();
+  l->id = id;
+  l->client = std::make_unique<Client>(loop_);
+  l->client->setRequestTimeout(probeTimeout_);
+  l->client->onMessage([this, l](const MessageView& m) { onLinkMessage(*l, m); });
+  l->client->transport().onClose([this, l] { onLinkClosed(*l); });
+  l->backoff = kMinBackoff;
+  byId_[id] = l;
+  return *l;
+}
+
+bool Fleet::addDevice(const std::string& id, const std::string& dev, unsigned baud) {
+  if (byId_.count(id)) return false;
+  Link& l = create(id);
+  l.dev = dev;
+  l.baud = baud;
+  auto now = Clock::now();
+  if (l.client->open(dev, baud)) startHandshake(l, now);
+  else l.due = now;  // tick() retries with backoff
+  return true;
+}
+
+bool Fleet::addFd(const std::string& id, int fd) {
+  if (byId_.count(id)) return false;
+  Link& l = create(id);
+  if (l.client->adopt(fd)) startHandshake(l, Clock::now());
+  else l.state = LinkState::Lost;
+  return true;
+}
+
+void Fleet::setProbeTimeout(std::chrono::milliseconds t) {
+  probeTimeout_ = t;
+  for (auto& l : links_) l->client->setRequestTimeout(t);
+}
+
+void Fleet::startHandshake(Link& l, Clock::time_point now) {
+  l.state = LinkState::Handshake;
+  l.due = now + kHelloRetry;
+  l.client->transport().write("HELLO\n");
+}
+
+void Fleet::setReady(Link& l, Clock::time_point now) {
+  if (l.state == LinkState::Ready) return;
+  l.state = LinkState::Ready;
+  l.backoff = kMinBackoff;
+  // Spread the first probes so N links do not all PING in the same tick
+  auto spread = probeInterval_ * static_cast<int64_t>(std::hash<std::string>{}(l.id) % 64) / 64;
+  l.nextProbe = now + spread;
+}
+
+void Fleet::onLinkMessage(Link& l, const MessageView& m) {
+  auto now = Clock::now();
+  ++l.stats.messages;
+  switch (m.type) {
+    case MsgType::Hello:
+      // Bridge firmware answering HELLO (or freshly reset): READY follows
+      l.managed = false;
+      l.mode.clear();
+      break;
+    case MsgType::Busy:
+      if (l.state == LinkState::Handshake) l.due = now + kBusyWait;
+      break;
+    case MsgType::Ready:
+      setReady(l, now);
+      break;
+    case MsgType::State:
+      l.mode = std::string(m.field(0));
+      break;
+    case MsgType::Link: {
+      brainstem::Link v;  // LINK,<0|1>,<seq>; Fleet::Link shadows the name
+      if (asLink(m, v)) l.hostLink = v.up;
+      break;
+    }
+    case MsgType::Estop: {
+      EstopMsg v;
+      if (asEstop(m, v)) l.estop = v.active;
+      break;
+    }
+    default:
+      break;
+  }
+  if (m.eid >= 0) {
+    // Only the managed stack tags lines with eids; it needs no HELLO
+    l.managed = true;
+    setReady(l, now);
+  }
+  if (handler_) handler_(l.id, m);
+}
+
+void Fleet::onLinkClosed(Link& l) {
+  l.managed = false;
+  l.mode.clear();
+  if (l.dev.empty()) {
+    l.state = LinkState::Lost;
+    return;
+  }
+  l.state = LinkState::Closed;
+  l.due = Clock::now() + l.backoff;
+}
+
+void Fleet::probeDone(Link& l, bool ok, std::chrono::microseconds rtt) {
+  if (ok) {
+    ++l.stats.probesAnswered;
+    l.stats.rtt.add(static_cast<uint64_t>(rtt.count()));
+  } else {
+    ++l.stats.probeTimeouts;
+  }
+}
+
+void Fleet::tick() {
+  auto now = Clock::now();
+  if (now - lastTick_ < kTickInterval) return;
+  lastTick_ = now;
+  for (auto& lp : links_) {
+    Link& l = *lp;
+    switch (l.state) {
+      case LinkState::Closed:
+        if (!l.dev.empty() && now >= l.due) {
+          if (l.client->open(l.dev, l.baud)) {
+            ++l.stats.reopens;
+            startHandshake(l, now);
+          } else {
+            l.due = now + l.backoff;
+            l.backoff = std::min(l.backoff * 2, std::chrono::milliseconds(kMaxBackoff));
+          }
+        }
+        break;
+      case LinkState::Handshake:
+        if (now >= l.due) startHandshake(l, now);
+        break;
+      case LinkState::Ready:
+        if (l.managed && probeInterval_.count() > 0 && now >= l.nextProbe) {
+          l.nextProbe = now + probeInterval_;
+          ++l.stats.probesSent;
+          Link* lptr = &l;
+          l.client->ping([this, lptr](bool ok, std::chrono::microseconds rtt) { probeDone(*lptr, ok, rtt); });
+        }
+        break;
+      case LinkState::Lost:
+        break;
+    }
+  }
+}
+
+Fleet::Link* Fleet::find(const std::string& id) {
+  auto it = byId_.find(id);
+  return it == byId_.end() ? nullptr : it->second;
+}
+
+const Fleet::Link* Fleet::find(const std::string& id) const {
+  auto it = byId_.find(id);
+  return it == byId_.end() ? nullptr : it->second;
+}
+
+std::vector<std::string> Fleet::ids() const {
+  std::vector<std::string> out;
+  out.reserve(byId_.size());
+  for (const auto& kv : byId_) out.push_back(kv.first);
+  return out;
+}
+
+LinkState Fleet::state(const std::string& id) const {
+  const Link* l = find(id);
+  return l ? l->state : LinkState::Lost;
+}
+
+std::string Fleet::mode(const std::string& id) const {
+  const Link* l = find(id);
+  return l ? l->mode : std::string();
+}
+
+Client* Fleet::client(const std::string& id) {
+  Link* l = find(id);
+  return l ? l->client.get() : nullptr;
+}
+
+bool Fleet::linkStats(const std::string& id, LinkStats& out) const {
+  const Link* l = find(id);
+  if (!l) return false;
+  out = l->stats;
+  // Byte counters live in the transport
+  out.bytesIn = l->client->transport().bytesIn();
+  out.bytesOut = l->client->transport().bytesOut();
+  return true;
+}
+
+FleetStats Fleet::stats() const {
+  FleetStats f;
+  f.links = links_.size();
+  for (const auto& lp : links_) {
+    LinkStats s;
+    linkStats(lp->id, s);
+    if (lp->state == LinkState::Ready) ++f.ready;
+    f.total.messages += s.messages;
+    f.total.bytesIn += s.bytesIn;
+    f.total.bytesOut += s.bytesOut;
+    f.total.probesSent += s.probesSent;
+    f.total.probesAnswered += s.probesAnswered;
+    f.total.probeTimeouts += s.probeTimeouts;
+    f.total.reopens += s.reopens;
+    f.total.rtt.merge(s.rtt);
+  }
+  return f;
+}
+
+// ---------- Control API ----------
+
+std::string Fleet::formatStats(const LinkStats& s) {
+  return "msgs=" + std::to_string(s.messages) + ",in=" + std::to_string(s.bytesIn) +
+         ",out=" + std::to_string(s.bytesOut) + ",probes=" + std::to_string(s.probesSent) +
+         ",answered=" + std::to_string(s.probesAnswered) + ",timeouts=" + std::to_string(s.probeTimeouts) +
+         ",reopens=" + std::to_string(s.reopens) + ",p50_us=" + std::to_string(s.rtt.quantileUs(0.5)) +
+         ",p99_us=" + std::to_string(s.rtt.quantileUs(0.99)) + ",max_us=" + std::to_string(s.rtt.maxUs);
+}
+
+void Fleet::command(const std::string& request, Reply reply) {
+  loop_.post([this, request, reply = std::move(reply)] { execute(request, reply); });
+}
+
+void Fleet::execute(const std::string& request, const Reply& reply) {
+  // <target> [verb [rest...]]
+  size_t sp1 = request.find(' ');
+  std::string target = request.substr(0, sp1);
+  std::string verb, rest;
+  if (sp1 != std::string::npos) {
+    size_t sp2 = request.find(' ', sp1 + 1);
+    verb = request.substr(sp1 + 1, sp2 == std::string::npos ? std::string::npos : sp2 - sp1 - 1);
+    if (sp2 != std::string::npos) rest = request.substr(sp2 + 1);
+  }
+
+  if (target == "list" && verb.empty()) {
+    std::string out = "OK,list";
+    for (const auto& kv : byId_) {
+      const Link& l = *kv.second;
+      out += "," + l.id + "=" + linkStateName(l.state) + "/" + (l.mode.empty() ? "-" : l.mode);
+    }
+    reply(out);
+    return;
+  }
+  if (target == "stats" && verb.empty()) {
+    FleetStats f = stats();
+    reply("OK,stats,links=" + std::to_string(f.links) + ",ready=" + std::to_string(f.ready) + "," +
+          formatStats(f.total));
+    return;
+  }
+
+  if (verb == "send" && !rest.empty()) {
+    size_t written = 0;
+    for (const auto& kv : byId_) {
+      Link& l = *kv.second;
+      if ((target == "*" || target == l.id) && l.client->transport().isOpen()) {
+        l.client->transport().write(rest + "\n");
+        ++written;
+      }
+    }
+    if (target != "*" && !find(target)) reply("ERR,id," + target);
+    else reply("OK,send," + std::to_string(written));
+    return;
+  }
+
+  Link* l = find(target);
+  if (!l) {
+    reply(verb.empty() ? "ERR,cmd," + target : "ERR,id," + target);
+    return;
+  }
+  if (verb == "stats") {
+    LinkStats s;
+    linkStats(l->id, s);
+    reply("OK,stats," + l->id + "," + formatStats(s));
+  } else if (verb == "ping") {
+    std::string id = l->id;
+    l->client->ping([reply, id](bool ok, std::chrono::microseconds rtt) {
+      reply(ok ? "OK,ping," + id + "," + std::to_string(rtt.count()) : "ERR,timeout," + id);
+    });
+  } else {
+    reply("ERR,cmd," + verb);
+  }
+}
+
+}  // namespace brainstem
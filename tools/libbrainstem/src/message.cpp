@@ -0,0 +1,158 @@
+#include "brainstem/message.h"
+
+#include <charconv>
+#include <cstdlib>
+
+namespace brainstem {
+
+namespace {
+
+struct VerbEntry {
+  std::string_view verb;
+  MsgType type;
+};
+
+constexpr VerbEntry kVerbs[] = {
+    {"ODOM", MsgType::Odom},   {"BUMP", MsgType::Bump},     {"CLIFF", MsgType::Cliff},
+    {"PONG", MsgType::Pong},   {"ACK", MsgType::Ack},       {"ERR", MsgType::Err},
+    {"LINK", MsgType::Link},   {"STATE", MsgType::State},   {"TIME", MsgType::Time},
+    {"ESTOP", MsgType::Estop}, {"STALE", MsgType::Stale},   {"RGMIN", MsgType::RgMin},
+    {"BAT", MsgType::Bat},     {"STARTLE", MsgType::Startle}, {"HELLO", MsgType::Hello},
+    {"READY", MsgType::Ready}, {"BUSY", MsgType::Busy},     {"SNS", MsgType::Sns},
+    {"STUCK", MsgType::Stuck}, {"TRAP", MsgType::Trap},     {"TRAJ", MsgType::Traj},
+};
+
+MsgType lookupVerb(std::string_view v) {
+  for (const auto& e : kVerbs)
+    if (e.verb == v) return e.type;
+  return MsgType::Unknown;
+}
+
+template <class T>
+bool parseUnsigned(std::string_view s, T& out) {
+  auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+  return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+}  // namespace
+
+const char* msgTypeName(MsgType t) {
+  if (t == MsgType::Status) return "STATUS";
+  if (t == MsgType::Stats) return "STATS";
+  for (const auto& e : kVerbs)
+    if (e.type == t) return e.verb.data();
+  return "UNKNOWN";
+}
+
+bool MessageView::intField(size_t i, int64_t& out) const {
+  std::string_view s = field(i);
+  if (s.empty()) return false;
+  auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+  return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool MessageView::doubleField(size_t i, double& out) const {
+  std::string_view s = field(i);
+  if (s.empty()) return false;
+  auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+  return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool parseLine(std::string_view line, MessageView& m) {
+  m = MessageView();
+  if (line.empty()) return false;
+
+  // STATUS:{json} and STATS:{json} one-liners carry no comma-separated fields.
+  size_t colon = line.find(':');
+  if (colon != std::string_view::npos && colon + 1 < line.size() && line[colon + 1] == '{') {
+    std::string_view verb = line.substr(0, colon);
+    if (verb == "STATUS" || verb == "STATS") {
+      m.type = verb == "STATUS" ? MsgType::Status : MsgType::Stats;
+      m.line = line;
+      m.verb = verb;
+      m.fields[0] = line.substr(colon + 1);
+      m.fieldCount = 1;
+      return true;
+    }
+  }
+
+  // Strip the ,eid=<n> suffix that every managed-mode line carries.
+  size_t eidPos = line.rfind(",eid=");
+  if (eidPos != std::string_view::npos) {
+    uint64_t eid = 0;
+    if (!parseUnsigned(line.substr(eidPos + 5), eid)) return false;
+    m.eid = static_cast<int64_t>(eid);
+    line = line.substr(0, eidPos);
+  }
+  m.line = line;
+
+  size_t pos = line.find(',');
+  m.verb = line.substr(0, pos);
+  m.type = lookupVerb(m.verb);
+  while (pos != std::string_view::npos) {
+    if (m.fieldCount == MessageView::kMaxFields) return false;
+    size_t next = line.find(',', pos + 1);
+    m.fields[m.fieldCount++] = line.substr(pos + 1, next == std::string_view::npos ? next : next - pos - 1);
+    pos = next;
+  }
+  return true;
+}
+
+bool asOdom(const MessageView& m, Odom& o) {
+  int64_t seq = 0;
+  return m.type == MsgType::Odom && m.doubleField(0, o.x) && m.doubleField(1, o.y) &&
+         m.doubleField(2, o.theta) && m.doubleField(3, o.vx) && m.doubleField(4, o.wz) &&
+         m.intField(5, seq) && (o.seq = static_cast<uint32_t>(seq), true);
+}
+
+bool asHazard(const MessageView& m, Hazard& h) {
+  // BUMP,1,<mask>,<seq> / CLIFF,1,<mask>,<seq>
+  int64_t mask = 0, seq = 0;
+  if (m.type != MsgType::Bump && m.type != MsgType::Cliff) return false;
+  if (!m.intField(1, mask) || !m.intField(2, seq)) return false;
+  h.mask = static_cast<uint8_t>(mask);
+  h.seq = static_cast<uint32_t>(seq);
+  return true;
+}
+
+bool asPong(const MessageView& m, Pong& p) {
+  int64_t seq = 0;
+  if (m.type != MsgType::Pong || !m.intField(0, seq)) return false;
+  p.seq = static_cast<uint32_t>(seq);
+  return true;
+}
+
+bool asLink(const MessageView& m, Link& l) {
+  int64_t up = 0, seq = 0;
+  if (m.type != MsgType::Link || !m.intField(0, up) || !m.intField(1, seq)) return false;
+  l.up = up != 0;
+  l.seq = static_cast<uint32_t>(seq);
+  return true;
+}
+
+bool asEstop(const MessageView& m, EstopMsg& e) {
+  int64_t active = 0, seq = 0;
+  if (m.type != MsgType::Estop || !m.intField(0, active) || !m.intField(1, seq)) return false;
+  e.active = active != 0;
+  e.seq = static_cast<uint32_t>(seq);
+  return true;
+}
+
+bool asRangeMin(const MessageView& m, RangeMin& r) {
+  int64_t seq = 0;
+  if (m.type != MsgType::RgMin || !m.doubleField(0, r.meters) || !m.intField(1, r.id) || !m.intField(2, seq))
+    return false;
+  r.seq = static_cast<uint32_t>(seq);
+  return true;
+}
+
+bool asBattery(const MessageView& m, Battery& b) {
+  int64_t mv = 0, pct = 0, chg = 0;
+  if (m.type != MsgType::Bat || !m.intField(0, mv) || !m.intField(1, pct) || !m.intField(2, chg)) return false;
+  b.millivolts = static_cast<uint32_t>(mv);
+  b.percent = static_cast<uint8_t>(pct);
+  b.charging = chg != 0;
+  return true;
+}
+
+}  // namespace brainstem
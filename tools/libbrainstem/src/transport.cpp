@@ -0,0 +1,230 @@
+#include "brainstem/transport.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace brainstem {
+
+namespace {
+
+constexpr size_t kRxBufferSize = 16 * 1024;
+
+speed_t baudConstant(unsigned baud) {
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B115200;
+  }
+}
+
+}  // namespace
+
+// ---------- EventLoop ----------
+
+EventLoop::EventLoop() {
+  epfd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epfd_ < 0 || wakeFd_ < 0) throw std::runtime_error("epoll/eventfd setup failed");
+  add(wakeFd_, EPOLLIN, [this](uint32_t) {
+    uint64_t n;
+    while (::read(wakeFd_, &n, sizeof(n)) == sizeof(n)) {}
+  });
+}
+
+EventLoop::~EventLoop() {
+  if (wakeFd_ >= 0) ::close(wakeFd_);
+  if (epfd_ >= 0) ::close(epfd_);
+}
+
+void EventLoop::add(int fd, uint32_t events, Handler h) {
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  handlers_[fd] = std::move(h);
+  if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    handlers_.erase(fd);
+    throw std::runtime_error("epoll_ctl ADD failed");
+  }
+}
+
+void EventLoop::modify(int fd, uint32_t events) {
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void EventLoop::remove(int fd) {
+  epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+  handlers_.erase(fd);
+}
+
+void EventLoop::runOnce(int timeoutMs) {
+  epoll_event events[64];
+  int n = epoll_wait(epfd_, events, 64, timeoutMs);
+  for (int i = 0; i < n; ++i) {
+    auto it = handlers_.find(events[i].data.fd);
+    if (it == handlers_.end()) continue;  // removed by an earlier handler this round
+    Handler h = it->second;               // copy: the handler may remove itself
+    h(events[i].events);
+  }
+  std::vector<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lk(postMu_);
+    tasks.swap(posted_);
+  }
+  for (auto& t : tasks) t();
+  for (auto& t : ticks_) t();
+}
+
+void EventLoop::run() {
+  running_ = true;
+  while (running_) runOnce(10);
+}
+
+void EventLoop::stop() {
+  post([this] { running_ = false; });
+}
+
+void EventLoop::post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lk(postMu_);
+    posted_.push_back(std::move(task));
+  }
+  uint64_t one = 1;
+  (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+// ---------- SerialTransport ----------
+
+SerialTransport::SerialTransport(EventLoop& loop) : loop_(loop), rx_(kRxBufferSize) {}
+
+SerialTransport::~SerialTransport() { close(); }
+
+bool SerialTransport::open(const std::string& dev, unsigned baud) {
+  int fd = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) return false;
+  termios tio{};
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, baudConstant(baud));
+    cfsetospeed(&tio, baudConstant(baud));
+    tio.c_cflag |= CLOCAL | CREAD;
+    // VMIN=1: an empty non-blocking read is EAGAIN, not 0 (which means hangup)
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return adopt(fd);
+}
+
+bool SerialTransport::adopt(int fd) {
+  close();
+  int fl = fcntl(fd, F_GETFL);
+  if (fl >= 0) fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+  fd_ = fd;
+  rxLen_ = 0;
+  tx_.clear();
+  txOff_ = 0;
+  wantWrite_ = false;
+  try {
+    loop_.add(fd_, EPOLLIN, [this](uint32_t ev) { handleEvents(ev); });
+  } catch (const std::runtime_error&) {
+    // Not pollable (regular file, /dev/null, ...)
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+void SerialTransport::close() {
+  if (fd_ < 0) return;
+  loop_.remove(fd_);
+  ::close(fd_);
+  fd_ = -1;
+  if (closed_) closed_();
+}
+
+void SerialTransport::write(const char* data, size_t len) {
+  if (fd_ < 0) return;
+  if (tx_.size() == txOff_) {
+    tx_.clear();
+    txOff_ = 0;
+  }
+  tx_.append(data, len);
+  // Already waiting for EPOLLOUT: the kernel buffer is full, so just queue
+  if (!wantWrite_) flushOut();
+}
+
+void SerialTransport::flushOut() {
+  while (txOff_ < tx_.size()) {
+    ssize_t n = ::write(fd_, tx_.data() + txOff_, tx_.size() - txOff_);
+    if (n > 0) {
+      txOff_ += static_cast<size_t>(n);
+      bytesOut_ += static_cast<uint64_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      // EPIPE/EIO: the peer is gone; nothing queued can be delivered
+      close();
+      return;
+    }
+    break;  // EAGAIN: wait for EPOLLOUT
+  }
+  bool pending = txOff_ < tx_.size();
+  if (pending != wantWrite_) {
+    wantWrite_ = pending;
+    loop_.modify(fd_, EPOLLIN | (pending ? EPOLLOUT : 0u));
+  }
+}
+
+void SerialTransport::handleEvents(uint32_t events) {
+  if (events & EPOLLOUT) flushOut();
+  if (fd_ >= 0 && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) readAvailable();
+  // Hangup: deliver what was still readable, then close; epoll would report
+  // EPOLLHUP on every round otherwise (a pty whose slave has no reader yet
+  // reads EAGAIN, not EOF)
+  if (fd_ >= 0 && (events & (EPOLLHUP | EPOLLERR))) close();
+}
+
+void SerialTransport::readAvailable() {
+  for (;;) {
+    if (rxLen_ == rx_.size()) {
+      // A line longer than the whole buffer is garbage; drop it.
+      rxLen_ = 0;
+    }
+    ssize_t n = ::read(fd_, rx_.data() + rxLen_, rx_.size() - rxLen_);
+    if (n > 0) {
+      rxLen_ += static_cast<size_t>(n);
+      bytesIn_ += static_cast<uint64_t>(n);
+      size_t used = data_ ? data_(rx_.data(), rxLen_) : rxLen_;
+      if (used > 0) {
+        std::memmove(rx_.data(), rx_.data() + used, rxLen_ - used);
+        rxLen_ -= used;
+      }
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      // EIO on a pty whose peer went away, or EOF
+      if (n == 0 || errno == EIO) close();
+    }
+    return;
+  }
+}
+
+}  // namespace brainstem
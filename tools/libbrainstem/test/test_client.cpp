@@ -0,0 +1,125 @@
+// Client tests against an in-process fake brainstem on a socketpair.
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "brainstem/client.h"
+
+using namespace brainstem;
+
+// Minimal responder answering PING/GET/SET/REPLAY the way the firmware does
+// (src/control.cpp): only GET,time exists, other GETs are ERR,cmd,GET.
+struct FakeBrainstem {
+  explicit FakeBrainstem(int f) : fd(f) {}
+  int fd;
+  std::string rx;
+  std::string lastReplay;
+  std::map<int, std::string> sent;  // the firmware's TX ring
+  int eid = 0;
+
+  // lose=true: tagged and kept for REPLAY, but never reaches the host
+  void send(const std::string& s, bool lose = false) {
+    std::string line = s + ",eid=" + std::to_string(++eid) + "\n";
+    sent[eid] = line;
+    if (!lose) (void)::write(fd, line.data(), line.size());
+  }
+  void replay(int since) {
+    auto first = sent.upper_bound(since);
+    bool missing = since < eid && (first == sent.end() || first->first > since + 1);
+    for (auto it = first; it != sent.end(); ++it) (void)::write(fd, it->second.data(), it->second.size());
+    if (missing) send("ERR,evt,missing");
+  }
+  void pump() {
+    char buf[256];
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0) return;
+    rx.append(buf, static_cast<size_t>(n));
+    size_t nl;
+    while ((nl = rx.find('\n')) != std::string::npos) {
+      std::string line = rx.substr(0, nl);
+      rx.erase(0, nl + 1);
+      if (line.rfind("PING,", 0) == 0) send("PONG," + line.substr(5));
+      else if (line == "GET,time") send("TIME,123456");
+      else if (line.rfind("SET,bogus", 0) == 0) send("ERR,param,bogus");
+      else if (line.rfind("SET,", 0) == 0) send("ACK," + line.substr(4));
+      else if (line.rfind("REPLAY,", 0) == 0) {
+        lastReplay = line;
+        replay(std::stoi(line.substr(7)));
+      }
+      else send("ERR,cmd," + line.substr(0, line.find(',')));
+    }
+  }
+};
+
+int main() {
+  int sv[2];
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  EventLoop loop;
+  Client client(loop);
+  client.adopt(sv[0]);
+  fcntl(sv[1], F_SETFL, O_NONBLOCK);
+  FakeBrainstem fake(sv[1]);
+
+  std::thread io([&] { loop.run(); });
+  std::thread dev([&] {
+    for (int i = 0; i < 200; ++i) {
+      fake.pump();
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  });
+
+  auto rtt = client.ping().get();
+  assert(rtt.count() >= 0);
+  assert(client.get("time").get() == "123456");
+  assert(client.set("odom_hz", "20").get() == "20");
+  // ERR,param and ERR,cmd fail the request instead of leaving it to time out
+  std::future<std::string> failing[] = {client.set("bogus", "1"), client.get("soft_stop_m")};
+  for (auto& req : failing) {
+    bool threw = false;
+    try {
+      req.get();
+    } catch (const RequestError&) {
+      threw = true;
+    }
+    assert(threw);
+  }
+  assert(client.stats().timeouts == 0);
+
+  // Lose two lines: the client asks for a replay from the last good eid
+  // and takes them late; repeated eids are dropped
+  int before = fake.eid;
+  int replayed = 0;
+  client.onMessage([&](const MessageView& m) { replayed += m.replayed; });
+  fake.send("STATE,IDLE", true);
+  fake.send("STATE,IDLE", true);
+  fake.send("STATE,IDLE");
+  std::string dup = "STATE,IDLE,eid=" + std::to_string(before + 3) + "\n";
+  (void)::write(sv[1], dup.data(), dup.size());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  assert(fake.lastReplay == "REPLAY," + std::to_string(before));
+
+  // Lines the ring no longer holds: ERR,evt,missing ends the wait
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));  // replay rate limit
+  fake.eid += 1;
+  fake.send("STATE,IDLE");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  dev.join();
+  loop.stop();
+  io.join();
+  assert(client.stats().gapsDetected == 2);
+  assert(client.stats().eidsRecovered == 2);
+  assert(replayed == 2);
+  assert(client.stats().eidsLost == 1);
+  assert(client.stats().eidsMissing == 0);
+  assert(client.stats().duplicates == 3);
+  ::close(sv[1]);
+  std::puts("test_client: ok");
+  return 0;
+}
@@ -0,0 +1,79 @@
+// Fleet tests: 32 managed sims plus one bridge sim on a single event loop.
+#include <cassert>
+#include <cstdio>
+#include <future>
+#include <string>
+
+#include "brainstem/fleet.h"
+#include "../tools/sim_brainstem.h"
+
+using namespace brainstem;
+
+static constexpr int kManaged = 32;
+
+// Run the loop on this thread until pred() holds or the deadline passes.
+template <class Pred>
+static bool runUntil(EventLoop& loop, int ms, Pred pred) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  while (std::chrono::steady_clock::now() < end) {
+    loop.runOnce(5);
+    if (pred()) return true;
+  }
+  return pred();
+}
+
+static std::string ask(EventLoop& loop, Fleet& fleet, const std::string& req) {
+  std::string out;
+  fleet.command(req, [&out](const std::string& line) { out = line; });
+  runUntil(loop, 1000, [&] { return !out.empty(); });
+  return out;
+}
+
+int main() {
+  sim::SimBrainstems sims(50);
+  EventLoop loop;
+  Fleet fleet(loop);
+  fleet.setProbeInterval(std::chrono::milliseconds(50));
+  for (int i = 0; i < kManaged; ++i) assert(fleet.addFd("r" + std::to_string(i), sims.add(true)));
+  assert(fleet.addFd("bridge", sims.add(false)));
+  assert(!fleet.addFd("r0", -1));  // duplicate id
+  sims.start();
+
+  // Managed sims are ready on their first eid-tagged line, the bridge on READY
+  bool ready = runUntil(loop, 2000, [&] { return fleet.stats().ready == kManaged + 1; });
+  assert(ready);
+  assert(fleet.mode("r7") == "FOREBRAIN");
+  assert(fleet.mode("bridge").empty());
+
+  runUntil(loop, 600, [] { return false; });
+  FleetStats s = fleet.stats();
+  assert(s.total.probesAnswered >= static_cast<uint64_t>(kManaged) * 5);
+  assert(s.total.probeTimeouts == 0);
+  assert(s.total.rtt.quantileUs(0.99) < 200000);
+  LinkStats bridge;
+  assert(fleet.linkStats("bridge", bridge) && bridge.probesSent == 0);  // raw OI link: never probed
+
+  // Control API addresses robots by id
+  std::string list = ask(loop, fleet, "list");
+  assert(list.rfind("OK,list,", 0) == 0);
+  assert(list.find(",r12=READY/FOREBRAIN") != std::string::npos);
+  assert(list.find(",bridge=READY/-") != std::string::npos);
+  assert(ask(loop, fleet, "r3 ping").rfind("OK,ping,r3,", 0) == 0);
+  assert(ask(loop, fleet, "nope ping") == "ERR,id,nope");
+  assert(ask(loop, fleet, "r3 jump") == "ERR,cmd,jump");
+  assert(ask(loop, fleet, "r5 send SET,watchdog_ms,500") == "OK,send,1");
+  assert(ask(loop, fleet, "* send SET,twist_period_ms,100") == "OK,send," + std::to_string(kManaged + 1));
+  assert(ask(loop, fleet, "stats").rfind("OK,stats,links=33,ready=33,", 0) == 0);
+  runUntil(loop, 100, [] { return false; });
+  assert(sims.received(5, "SET") == 2);
+  assert(sims.received(6, "SET") == 1);
+
+  // A hung-up adopted link is lost for good; the rest carry on
+  sims.hangUp(0);
+  assert(runUntil(loop, 1000, [&] { return fleet.state("r0") == LinkState::Lost; }));
+  assert(fleet.stats().ready == kManaged);
+
+  sims.stop();
+  std::puts("test_fleet: ok");
+  return 0;
+}
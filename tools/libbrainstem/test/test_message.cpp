@@ -0,0 +1,70 @@
+// Parser tests: typed views, eid suffix handling, partial lines.
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "brainstem/message.h"
+
+using namespace brainstem;
+
+static void testOdom() {
+  MessageView m;
+  assert(parseLine("ODOM,1.250,-0.500,3.142,0.200,-0.100,77,eid=12", m));
+  assert(m.type == MsgType::Odom);
+  assert(m.eid == 12);
+  Odom o;
+  assert(asOdom(m, o));
+  assert(o.x == 1.25 && o.y == -0.5 && o.seq == 77);
+}
+
+static void testHazardAndPong() {
+  MessageView m;
+  assert(parseLine("BUMP,1,3,9,eid=4", m));
+  Hazard h;
+  assert(asHazard(m, h) && h.mask == 3 && h.seq == 9);
+  assert(parseLine("PONG,42,eid=5", m));
+  Pong p;
+  assert(asPong(m, p) && p.seq == 42);
+  Odom o;
+  assert(!asOdom(m, o));
+}
+
+static void testBridgeLines() {
+  MessageView m;
+  assert(parseLine("READY", m) && m.type == MsgType::Ready && m.eid == -1);
+  assert(parseLine("STATUS:{\"state\":\"BRIDGE\"}", m) && m.type == MsgType::Status);
+  assert(m.field(0) == "{\"state\":\"BRIDGE\"}");
+  assert(!parseLine("PONG,1,eid=x", m));
+  // Commas inside the JSON do not split it
+  assert(parseLine("STATS:{\"energy\":{\"idle\":[1,2,0],\"seek\":[3,4,5]},\"mj_per_m\":600}", m));
+  assert(m.type == MsgType::Stats && m.fieldCount == 1 && m.field(0).front() == '{');
+}
+
+static void testFirmwareVerbs() {
+  MessageView m;
+  assert(parseLine("SNS,129,0,0,0,0,eid=7", m) && m.type == MsgType::Sns);
+  assert(parseLine("STUCK,slip,2,eid=8", m) && m.type == MsgType::Stuck && m.field(0) == "slip");
+  assert(parseLine("TRAP,escaped,4200,3,eid=9", m) && m.type == MsgType::Trap);
+  assert(parseLine("TRAJ,underrun,1,eid=10", m) && m.type == MsgType::Traj);
+}
+
+static void testSplitterKeepsPartialTail() {
+  LineParser p;
+  std::vector<std::string> seen;
+  const char chunk[] = "PONG,1,eid=1\r\nBUMP,1,1,2,eid=2\nODOM,0,0";
+  size_t used = p.feed(chunk, sizeof(chunk) - 1, [&](const MessageView& m) { seen.emplace_back(m.line); });
+  assert(seen.size() == 2);
+  assert(seen[0] == "PONG,1" && seen[1] == "BUMP,1,1,2");
+  assert(std::string(chunk + used) == "ODOM,0,0");
+}
+
+int main() {
+  testOdom();
+  testHazardAndPong();
+  testBridgeLines();
+  testFirmwareVerbs();
+  testSplitterKeepsPartialTail();
+  std::puts("test_message: ok");
+  return 0;
+}
@@ -0,0 +1,168 @@
+// bs_fleet: serve many brainstems from one process and one event loop.
+//   bs_fleet [--control <socket>] [--probe-ms <n>] <id>=<device>[@baud] ...
+//
+// Control lines (see Fleet::command) go to the UNIX socket, one reply each:
+//   echo "r2 send SET,watchdog_ms,500" | socat - UNIX-CONNECT:/tmp/bs_fleet.sock
+// Fleet stats are printed every 10 s.
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "brainstem/fleet.h"
+
+using namespace brainstem;
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) { g_stop = 1; }
+
+// One accepted control connection; replies may arrive after it is gone.
+struct ControlConn {
+  int fd = -1;
+  std::string rx;
+};
+
+class ControlServer {
+ public:
+  ControlServer(EventLoop& loop, Fleet& fleet) : loop_(loop), fleet_(fleet) {}
+  ~ControlServer() {
+    for (auto& kv : conns_) ::close(kv.first);
+    if (fd_ >= 0) {
+      loop_.remove(fd_);
+      ::close(fd_);
+      ::unlink(path_.c_str());
+    }
+  }
+
+  bool listen(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    ::unlink(path.c_str());
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd_, 8) < 0)
+      return false;
+    path_ = path;
+    loop_.add(fd_, EPOLLIN, [this](uint32_t) { accept(); });
+    return true;
+  }
+
+ private:
+  void accept() {
+    int c;
+    while ((c = ::accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+      auto conn = std::make_shared<ControlConn>();
+      conn->fd = c;
+      conns_[c] = conn;
+      loop_.add(c, EPOLLIN, [this, conn](uint32_t) { read(conn); });
+    }
+  }
+
+  void read(const std::shared_ptr<ControlConn>& conn) {
+    char buf[256];
+    ssize_t n;
+    while ((n = ::read(conn->fd, buf, sizeof(buf))) > 0) conn->rx.append(buf, static_cast<size_t>(n));
+    size_t nl;
+    while ((nl = conn->rx.find('\n')) != std::string::npos) {
+      std::string line = conn->rx.substr(0, nl);
+      conn->rx.erase(0, nl + 1);
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.empty()) continue;
+      std::weak_ptr<ControlConn> weak = conn;
+      fleet_.command(line, [weak](const std::string& reply) {
+        auto c = weak.lock();
+        if (!c || c->fd < 0) return;
+        std::string out = reply + "\n";
+        (void)::write(c->fd, out.data(), out.size());
+      });
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      loop_.remove(conn->fd);
+      ::close(conn->fd);
+      conns_.erase(conn->fd);
+      conn->fd = -1;
+    }
+  }
+
+  EventLoop& loop_;
+  Fleet& fleet_;
+  int fd_ = -1;
+  std::string path_;
+  std::unordered_map<int, std::shared_ptr<ControlConn>> conns_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string control = "/tmp/bs_fleet.sock";
+  int probeMs = 1000;
+  EventLoop loop;
+  Fleet fleet(loop);
+  int links = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--control" && i + 1 < argc) {
+      control = argv[++i];
+    } else if (a == "--probe-ms" && i + 1 < argc) {
+      probeMs = std::atoi(argv[++i]);
+    } else if (a.find('=') != std::string::npos) {
+      std::string id = a.substr(0, a.find('='));
+      std::string dev = a.substr(a.find('=') + 1);
+      unsigned baud = 115200;
+      if (dev.find('@') != std::string::npos) {
+        baud = static_cast<unsigned>(std::atoi(dev.c_str() + dev.find('@') + 1));
+        dev.resize(dev.find('@'));
+      }
+      if (!fleet.addDevice(id, dev, baud)) {
+        std::fprintf(stderr, "duplicate id %s\n", id.c_str());
+        return 2;
+      }
+      ++links;
+    } else {
+      std::fprintf(stderr, "Usage: bs_fleet [--control <socket>] [--probe-ms <n>] <id>=<device>[@baud] ...\n");
+      return 2;
+    }
+  }
+  if (links == 0) {
+    std::fprintf(stderr, "bs_fleet: no links given\n");
+    return 2;
+  }
+  fleet.setProbeInterval(std::chrono::milliseconds(probeMs));
+
+  ControlServer server(loop, fleet);
+  if (!server.listen(control)) {
+    std::perror(control.c_str());
+    return 1;
+  }
+  std::printf("bs_fleet: %d links, control=%s\n", links, control.c_str());
+
+  auto nextReport = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  loop.onTick([&] {
+    if (g_stop) loop.stop();
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextReport) return;
+    nextReport = now + std::chrono::seconds(10);
+    fleet.command("stats", [](const std::string& line) {
+      std::printf("%s\n", line.c_str());
+      std::fflush(stdout);
+    });
+  });
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  loop.run();
+  return 0;
+}
@@ -0,0 +1,63 @@
+// bs_fleet_load: scaling run for Fleet on one loop thread.
+//   bs_fleet_load [max_links=64] [seconds=3] [probe_ms=100] [sns_hz=20]
+//
+// For 1, 2, 4, ... max_links simulated managed brainstems (socketpairs served
+// by one sim thread), runs a Fleet on this thread and reports loop CPU time
+// per message (flat = linear scaling) and probe RTT percentiles (bounded =
+// no link starves the others).
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "brainstem/fleet.h"
+#include "sim_brainstem.h"
+
+using namespace brainstem;
+
+static double threadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+  int maxLinks = argc > 1 ? std::atoi(argv[1]) : 64;
+  double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+  int probeMs = argc > 3 ? std::atoi(argv[3]) : 100;
+  unsigned snsHz = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 20;
+
+  std::printf("%6s %6s %10s %8s %10s %9s %9s %9s %8s\n", "links", "ready", "msgs/s", "cpu%", "us/msg",
+              "p50_us", "p99_us", "max_us", "timeouts");
+  // 1, 2, 4, ... and always max_links last
+  for (int n = 1; n <= maxLinks; n = (n < maxLinks && n * 2 > maxLinks) ? maxLinks : n * 2) {
+    sim::SimBrainstems sims(snsHz);
+    EventLoop loop;
+    Fleet fleet(loop);
+    fleet.setProbeInterval(std::chrono::milliseconds(probeMs));
+    for (int i = 0; i < n; ++i) fleet.addFd("r" + std::to_string(i), sims.add(true));
+    sims.start();
+
+    // Warm up until every link has answered, then measure a clean window
+    auto warmEnd = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (fleet.stats().ready < static_cast<size_t>(n) && std::chrono::steady_clock::now() < warmEnd)
+      loop.runOnce(5);
+    FleetStats before = fleet.stats();
+    double cpu0 = threadCpuSeconds();
+    auto t0 = std::chrono::steady_clock::now();
+    auto end = t0 + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) loop.runOnce(5);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double cpu = threadCpuSeconds() - cpu0;
+    sims.stop();
+
+    FleetStats after = fleet.stats();
+    uint64_t msgs = after.total.messages - before.total.messages;
+    const LatencyHistogram& rtt = after.total.rtt;
+    std::printf("%6d %6zu %10.0f %7.1f%% %10.2f %9llu %9llu %9llu %8llu\n", n, after.ready, msgs / wall,
+                100.0 * cpu / wall, msgs ? 1e6 * cpu / msgs : 0.0,
+                (unsigned long long)rtt.quantileUs(0.5), (unsigned long long)rtt.quantileUs(0.99),
+                (unsigned long long)rtt.maxUs, (unsigned long long)after.total.probeTimeouts);
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+// bs_ping: PING a brainstem N times and print round-trip times.
+//   bs_ping /dev/ttyACM0 [count]
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "brainstem/client.h"
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "Usage: bs_ping <device> [count]\n");
+    return 2;
+  }
+  int count = argc > 2 ? std::atoi(argv[2]) : 10;
+  brainstem::EventLoop loop;
+  brainstem::Client client(loop);
+  if (!client.open(argv[1])) {
+    std::perror(argv[1]);
+    return 1;
+  }
+  client.onMessage([](const brainstem::MessageView& m) {
+    if (m.type != brainstem::MsgType::Pong)
+      std::printf("<- %.*s\n", static_cast<int>(m.line.size()), m.line.data());
+  });
+  std::thread io([&] { loop.run(); });
+  int ok = 0;
+  for (int i = 0; i < count; ++i) {
+    try {
+      auto rtt = client.ping().get();
+      std::printf("PONG %d rtt=%.3f ms\n", i, rtt.count() / 1000.0);
+      ++ok;
+    } catch (const std::exception& e) {
+      std::printf("PING %d: %s\n", i, e.what());
+    }
+  }
+  loop.stop();
+  io.join();
+  const auto& s = client.stats();
+  std::printf("%d/%d answered, messages=%llu gaps=%llu recovered=%llu lost=%llu\n", ok, count,
+              (unsigned long long)s.messages, (unsigned long long)s.gapsDetected,
+              (unsigned long long)s.eidsRecovered, (unsigned long long)s.eidsLost);
+  return ok == count ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#pragma once
+// In-process simulated brainstems for fleet tests and load runs.
+//
+// SimBrainstems serves any number of fake devices from one thread on its own
+// epoll set, each on the far end of a socketpair. A managed sim answers like
+// the firmware's src/control.cpp: STATE on start, PING -> PONG, GET,time ->
+// TIME, SET of a known key -> ACK, ERR,param/ERR,cmd otherwise (HELLO
+// included), SNS keyframes at snsHz, every line eid-tagged. It keeps no
+// history, so REPLAY of anything it sent is ERR,evt,missing. A bridge sim only
+// answers HELLO with HELLO/BUSY/READY like src/main.cpp and then swallows raw
+// bytes.
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace brainstem {
+namespace sim {
+
+class SimBrainstems {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit SimBrainstems(unsigned snsHz = 20) : snsHz_(snsHz), start_(Clock::now()) {
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+  }
+  ~SimBrainstems() {
+    stop();
+    for (auto& d : devs_)
+      if (d->fd >= 0) ::close(d->fd);
+    ::close(epfd_);
+  }
+
+  // Create a device; returns the host-side fd (hand it to Fleet::addFd).
+  // Call before start().
+  int add(bool managed = true) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) return -1;
+    auto d = std::make_unique<Dev>();
+    d->fd = sv[1];
+    d->managed = managed;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(devs_.size());
+    epoll_ctl(epfd_, EPOLL_CTL_ADD, d->fd, &ev);
+    devs_.push_back(std::move(d));
+    return sv[0];
+  }
+
+  void start() {
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+  }
+  void stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  // Hang up one device (the host sees EOF). Thread-safe.
+  void hangUp(size_t i) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (devs_[i]->fd >= 0) {
+      epoll_ctl(epfd_, EPOLL_CTL_DEL, devs_[i]->fd, nullptr);
+      ::close(devs_[i]->fd);
+      devs_[i]->fd = -1;
+    }
+  }
+
+  // Lines of a given verb received by device i (e.g. "SET"). Thread-safe.
+  unsigned received(size_t i, const std::string& verb) {
+    std::lock_guard<std::mutex> lk(mu_);
+    unsigned n = 0;
+    for (const auto& l : devs_[i]->lines)
+      if (l.compare(0, verb.size(), verb) == 0) ++n;
+    return n;
+  }
+
+ private:
+  struct Dev {
+    int fd = -1;
+    bool managed = true;
+    bool started = false;
+    uint32_t eid = 0;
+    std::string rx;
+    std::vector<std::string> lines;
+    Clock::time_point nextSns{};
+  };
+
+  // SET keys the firmware accepts (handleSet and SET,mode in control.cpp)
+  static bool knownKey(const std::string& key) {
+    static const char* const kKeys[] = {"twist_period_ms", "twist_hold_pct", "watchdog_ms",  "gov_full_pct",
+                                        "gov_floor_pct",   "gov_min_level",  "task_budget_min"};
+    for (const char* k : kKeys)
+      if (key == k) return true;
+    return false;
+  }
+
+  void send(Dev& d, const std::string& body) {
+    std::string line = d.managed ? body + ",eid=" + std::to_string(++d.eid) + "\n" : body + "\n";
+    (void)::write(d.fd, line.data(), line.size());
+  }
+
+  void onLine(Dev& d, const std::string& line) {
+    d.lines.push_back(line);
+    if (!d.managed) {
+      if (line == "HELLO") {
+        send(d, "HELLO,proto=1.0,build=sim,reset=cold,setup_us=0,oi_us=0,usb_ms=0");
+        send(d, "BUSY");
+        send(d, "READY");
+      }
+      return;
+    }
+    if (line.rfind("PING,", 0) == 0) {
+      send(d, "PONG," + line.substr(5));
+    } else if (line == "GET,time") {
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start_).count();
+      send(d, "TIME," + std::to_string(ms));
+    } else if (line.rfind("REPLAY,", 0) == 0) {
+      if (std::strtoul(line.c_str() + 7, nullptr, 10) < d.eid) send(d, "ERR,evt,missing");
+    } else if (line.rfind("SET,", 0) == 0) {
+      size_t comma = line.find(',', 4);
+      if (comma == std::string::npos) return send(d, "ERR,parse,set");
+      std::string key = line.substr(4, comma - 4);
+      if (key == "mode") {
+        send(d, "STATE," + line.substr(comma + 1));
+        send(d, "ACK," + line.substr(4));
+      } else if (knownKey(key)) {
+        send(d, "ACK," + line.substr(4));
+      } else {
+        send(d, "ERR,param," + key);
+      }
+    } else {
+      send(d, "ERR,cmd," + line.substr(0, line.find(',')));
+    }
+  }
+
+  void run() {
+    epoll_event events[64];
+    while (running_) {
+      int n = epoll_wait(epfd_, events, 64, 1);
+      std::lock_guard<std::mutex> lk(mu_);
+      for (int i = 0; i < n; ++i) {
+        Dev& d = *devs_[events[i].data.u32];
+        if (d.fd < 0) continue;
+        char buf[512];
+        ssize_t r;
+        while ((r = ::read(d.fd, buf, sizeof(buf))) > 0) d.rx.append(buf, static_cast<size_t>(r));
+        size_t nl;
+        while ((nl = d.rx.find('\n')) != std::string::npos) {
+          std::string line = d.rx.substr(0, nl);
+          d.rx.erase(0, nl + 1);
+          onLine(d, line);
+        }
+      }
+      auto now = Clock::now();
+      for (auto& dp : devs_) {
+        Dev& d = *dp;
+        if (d.fd < 0 || !d.managed) continue;
+        if (!d.started) {
+          d.started = true;
+          send(d, "STATE,FOREBRAIN");
+          d.nextSns = now;
+        }
+        if (snsHz_ && now >= d.nextSns) {
+          // Keyframe: mask | 0x80, bumps, cliffs, wall, buttons
+          d.nextSns += std::chrono::microseconds(1000000 / snsHz_);
+          send(d, "SNS,143,0,0,0,0");
+        }
+      }
+    }
+  }
+
+  unsigned snsHz_;
+  Clock::time_point start_;
+  int epfd_ = -1;
+  std::vector<std::unique_ptr<Dev>> devs_;
+  std::mutex mu_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+}  // namespace sim
+}  // namespace brainstem
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Map a brainstem PC-profiler dump (PROF,... lines) back to firmware symbols.
+
+Build with -DENABLE_PROF, then:
+  python3 tools/prof_symbolize.py firmware.elf /dev/ttyACM0 --seconds 10  # start, wait, dump, stop
+  python3 tools/prof_symbolize.py firmware.elf capture.log                # symbolize a saved dump
+
+Symbols come from `avr-nm -n -C -S` (override with --nm). A bucket covers
+2^shift flash words, so a hot bucket straddling two functions is split
+evenly and marked with '~'.
+"""
+import argparse
+import bisect
+import os
+import stat
+import subprocess
+import sys
+import time
+
+
+def read_dump_serial(dev, baud, seconds, hz):
+    import serial  # pyserial
+    ser = serial.Serial(dev, baud, timeout=0.1)
+    ser.reset_input_buffer()
+    ser.write(f"\xFF\x00!prof_start,{hz}\n".encode("latin-1"))
+    time.sleep(seconds)
+    ser.write(b"\xFF\x00!prof\n")
+    lines = []
+    t0 = time.time()
+    while time.time() - t0 < 3.0:
+        ln = ser.readline().decode(errors="ignore").strip()
+        if ln.startswith("PROF,"):
+            lines.append(ln)
+            if ln == "PROF,end":
+                break
+    ser.write(b"\xFF\x00!prof_stop\n")
+    ser.close()
+    return lines
+
+
+def load_symbols(nm, elf):
+    out = subprocess.run([nm, "-n", "-C", "-S", elf], check=True,
+                         capture_output=True, text=True).stdout
+    syms = []
+    for ln in out.splitlines():
+        parts = ln.split(None, 3)
+        if len(parts) == 4 and parts[2] in "tTwW":
+            syms.append((int(parts[0], 16), int(parts[1], 16), parts[3]))
+    syms.sort()
+    return syms
+
+
+def lookup(syms, starts, addr):
+    i = bisect.bisect_right(starts, addr) - 1
+    if i < 0:
+        return None
+    start, size, name = syms[i]
+    return name if addr < start + max(size, 2) else None
+
+
+def parse(lines):
+    header = None
+    buckets = []
+    for ln in lines:
+        parts = ln.split(",")
+        if len(parts) == 6:
+            header = {"running": parts[1] == "1", "samples": int(parts[2]),
+                      "dropped": int(parts[3]), "hz": int(parts[4]), "shift": int(parts[5])}
+        elif len(parts) == 3:
+            buckets.append((int(parts[1], 16), int(parts[2])))
+    if header is None:
+        sys.exit("no PROF header found")
+    return header, buckets
+
+
+def symbolize(header, buckets, syms):
+    starts = [s for s, _, _ in syms]
+    span = 2 << header["shift"]  # bytes per bucket
+    totals = {}
+    for addr, count in buckets:
+        names = []
+        for off in range(0, span, 2):
+            n = lookup(syms, starts, addr + off)
+            if n and n not in names:
+                names.append(n)
+        if not names:
+            names = [f"0x{addr:05x}"]
+        for n in names:
+            key = n if len(names) == 1 else "~" + n
+            totals[key] = totals.get(key, 0) + count / len(names)
+    total = header["samples"] or 1
+    print(f"samples={header['samples']} dropped={header['dropped']} hz={header['hz']} "
+          f"bucket={span}B running={header['running']}")
+    for name, count in sorted(totals.items(), key=lambda kv: -kv[1]):
+        print(f"{100.0 * count / total:6.2f}%  {count:8.1f}  {name}")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("elf", help="firmware ELF (e.g. .pio/build/<env>/firmware.elf)")
+    ap.add_argument("source", help="serial device or log file")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--seconds", type=float, default=5.0, help="sampling window when reading a device")
+    ap.add_argument("--hz", type=int, default=997)
+    ap.add_argument("--nm", default="avr-nm")
+    args = ap.parse_args()
+    if os.path.exists(args.source) and stat.S_ISCHR(os.stat(args.source).st_mode):
+        lines = read_dump_serial(args.source, args.baud, args.seconds, args.hz)
+    else:
+        with open(args.source, errors="ignore") as f:
+            lines = [ln.strip() for ln in f if ln.startswith("PROF,")]
+    header, buckets = parse(lines)
+    symbolize(header, buckets, load_symbols(args.nm, args.elf))
+
+
+if __name__ == "__main__":
+    main()